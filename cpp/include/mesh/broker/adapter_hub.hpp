@@ -0,0 +1,125 @@
+#ifndef MESH_BROKER_ADAPTER_HUB_HPP
+#define MESH_BROKER_ADAPTER_HUB_HPP
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh/broker/message_queue.hpp"
+#include "mesh/broker/sharded_counters.hpp"
+#include "mesh/broker/snapshot.hpp"
+#include "mesh/broker/wakeup.hpp"
+#include "mesh/protocol/hop_path.hpp"
+#include "mesh/protocol/message.hpp"
+
+namespace mesh::broker {
+
+// One transport (emulated, WiFi, BLE, ...) hosted by an AdapterHub
+class Adapter {
+public:
+    virtual ~Adapter() = default;
+
+    virtual std::string name() const = 0;
+
+    // Called only from the adapter's own I/O thread
+    virtual bool send(const protocol::Message& message) = 0;
+};
+
+// Shared routing core for a broker bridging several adapters in one
+// process.
+//
+// Every adapter gets its own outbound MessageQueue and I/O thread, so a
+// slow BLE link never stalls WiFi. route() is the single entry point for
+// local sends and for messages received on any adapter: unicast goes to
+// the adapter the route table names, and broadcasts (to_id
+// protocol::kBroadcastId, or empty from a local sender) or unknown
+// destinations go to every adapter except the one they came in on.
+// Messages to the local node are handed to the delivery callback. The
+// hub stamps its hop id on forwarded messages and drops any it has
+// already relayed, so bridged adapters cannot loop a message. Routes are
+// an immutable snapshot, so route() takes no lock.
+class AdapterHub {
+public:
+    static constexpr size_t kLocal = static_cast<size_t>(-1);
+
+    using DeliverFn = std::function<void(const protocol::Message& message)>;
+
+    struct AdapterStats {
+        std::string name;
+        size_t queued = 0;
+        uint64_t received = 0;
+        uint64_t sent = 0;
+        uint64_t failed = 0;
+        uint64_t dropped = 0;       // outbound queue full
+    };
+
+    AdapterHub(std::string local_id, DeliverFn deliver_local,
+               const MessageQueue::Config& queue_config = MessageQueue::Config());
+    ~AdapterHub();
+
+    AdapterHub(const AdapterHub&) = delete;
+    AdapterHub& operator=(const AdapterHub&) = delete;
+
+    // Before start(); returns the adapter's index
+    size_t addAdapter(std::unique_ptr<Adapter> adapter);
+
+    bool start();
+    void stop();
+
+    void setRoute(const std::string& peer_id, size_t adapter);
+    void removeRoute(const std::string& peer_id);
+
+    // from is the adapter the message arrived on, or kLocal for messages
+    // originating here. False if it was dropped (loop, expired, no
+    // adapter) or every target queue was full.
+    bool route(protocol::Message message, size_t from = kLocal);
+
+    size_t adapterCount() const { return adapters_.size(); }
+    std::vector<AdapterStats> getStats() const;
+
+    uint64_t loopsDropped() const { return loops_dropped_.load(std::memory_order_relaxed); }
+
+private:
+    enum Counter : size_t {
+        kReceived,
+        kSent,
+        kFailed,
+        kDropped,
+        kCounterCount
+    };
+
+    struct Slot {
+        explicit Slot(std::unique_ptr<Adapter> adapter, const MessageQueue::Config& config)
+            : adapter(std::move(adapter)), queue(config) {}
+
+        std::unique_ptr<Adapter> adapter;
+        MessageQueue queue;
+        ShardedCounters<kCounterCount, 4> counters;
+        std::thread thread;
+    };
+
+    bool enqueue(Slot& slot, protocol::Message&& message);
+    void run(Slot& slot);
+
+    std::string local_id_;
+    protocol::HopId local_hop_;
+    DeliverFn deliver_local_;
+    MessageQueue::Config queue_config_;
+
+    std::vector<std::unique_ptr<Slot>> adapters_;
+    SnapshotCell<std::unordered_map<std::string, size_t>> routes_;
+
+    std::atomic<bool> running_{false};
+    EventFd stop_event_;
+    std::atomic<uint64_t> loops_dropped_{0};
+};
+
+} // namespace mesh::broker
+
+#endif // MESH_BROKER_ADAPTER_HUB_HPP
@@ -6,11 +6,18 @@
 #include <memory>
 #include <thread>
 #include <atomic>
-#include <mutex>
+#include <array>
 #include <map>
 
 #include "mesh/protocol/message.hpp"
+#include "mesh/broker/adapter_hub.hpp"
+#include "mesh/broker/latency_histogram.hpp"
+#include "mesh/broker/message_queue.hpp"
+#include "mesh/broker/message_spool.hpp"
 #include "mesh/broker/peer.hpp"
+#include "mesh/broker/sharded_counters.hpp"
+#include "mesh/broker/snapshot.hpp"
+#include "mesh/broker/wakeup.hpp"
 
 namespace mesh::broker {
 
@@ -31,15 +38,43 @@ public:
         size_t total_delivered = 0;
         size_t total_failed = 0;
         double success_rate = 0.0;
+        // Depth and queueing delay per class, indexed by MessagePriority
+        std::array<MessageQueue::ClassStats, MessageQueue::kClassCount> queue_classes;
+        // Latency percentiles since start, overall and per priority
+        LatencyStats enqueue_to_send;
+        LatencyStats send_to_ack;
+        LatencyStats end_to_end;
+        // One entry per hosted adapter, in the order given
+        std::vector<AdapterHub::AdapterStats> adapters;
+        // Zero unless a spool is enabled
+        MessageSpool::Stats spool;
     };
 
     Broker(const std::string& adapter_name);
+    // Hosts every adapter in one process, bridged through a shared AdapterHub
+    explicit Broker(const std::vector<std::string>& adapter_names);
     ~Broker();
 
+    // Before start(): messages for peers that are offline are spooled to
+    // disk instead of failing, and streamed to them on reconnect. Messages
+    // spooled by an earlier run are recovered by start().
+    void enableSpool(const MessageSpool::Config& config);
+
     bool start();
     void stop();
 
+    using PeerTable = std::map<std::string, std::shared_ptr<Peer>>;
+    using PeerSnapshot = SnapshotCell<PeerTable>::Ptr;
+
+    // Consistent view of the peer table with one atomic load; hold it as
+    // long as needed, it never changes underneath the caller
+    PeerSnapshot peerSnapshot() const { return peers_.load(); }
+
+    // Copies the current snapshot; prefer peerSnapshot() on hot paths
     std::vector<std::shared_ptr<Peer>> getPeers() const;
+
+    // Built on each call by summing the counter shards; cheap enough for
+    // a once-a-second reader and free for the send path
     Stats getStats() const;
 
     bool sendMessage(const protocol::Message& message);
@@ -48,23 +83,44 @@ public:
 private:
     void discoverPeers();
     void processMessageQueue();
-    void updateStats();
 
-    AdapterType adapter_type_;
+    enum Counter : size_t {
+        kSent,
+        kDelivered,
+        kFailed,
+        kCounterCount
+    };
+
+    std::vector<AdapterType> adapter_types_;
     std::atomic<bool> is_running_{false};
     
-    mutable std::mutex peers_mutex_;
-    std::map<std::string, std::shared_ptr<Peer>> peers_;
-
-    mutable std::mutex queue_mutex_;
-    std::vector<protocol::Message> message_queue_;
-
-    Stats stats_;
-    mutable std::mutex stats_mutex_;
-
+    // Discovery builds each new table with peers_.update()
+    SnapshotCell<PeerTable> peers_;
+
+    // sendMessage() pushes from any thread; queue_thread_ drains it in
+    // batches with popBatch() and sleeps on its wakeFd() when empty
+    MessageQueue message_queue_;
+
+    // Per-adapter I/O threads and queues; queue_thread_ hands each
+    // outbound message to hub_.route()
+    AdapterHub hub_;
+
+    // Null unless enableSpool() was called; discovery streams a peer's
+    // backlog when it reappears and acknowledges what was delivered
+    std::unique_ptr<MessageSpool> spool_;
+
+    // Bumped with relaxed atomics on the send and delivery paths
+    ShardedCounters<kCounterCount> counters_;
+    // Recorded by the queue thread on send and by the ack handler
+    PriorityLatency enqueue_to_send_;
+    PriorityLatency send_to_ack_;
+    PriorityLatency end_to_end_;
+
+    // Worker threads block in waitReadable() on their wakeup and
+    // stop_event_; discovery runs off a TimerFd instead of sleeping
+    EventFd stop_event_;
     std::thread discovery_thread_;
     std::thread queue_thread_;
-    std::thread stats_thread_;
 };
 
 } // namespace mesh::broker
@@ -0,0 +1,89 @@
+#ifndef MESH_BROKER_EMULATED_LINK_HPP
+#define MESH_BROKER_EMULATED_LINK_HPP
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+#include "mesh/broker/adapter_hub.hpp"
+#include "mesh/broker/link_model.hpp"
+#include "mesh/protocol/message.hpp"
+
+namespace mesh::broker {
+
+// Real-time radio link between two adapters in one process; the transport
+// behind Broker::AdapterType::WiFiEmulated.
+//
+// Each end is an Adapter for an AdapterHub. send() encodes the message
+// with the wire codec, passes the frame through the shared LinkModel on
+// the steady clock, and the link's delivery thread hands it to the other
+// end's receive callback once the model says it has arrived. Frames over
+// the MTU or refused for congestion fail send(), so the hub counts them
+// as failed; lost frames look sent, as they would on the air.
+class EmulatedLink {
+public:
+    enum class End {
+        A,
+        B
+    };
+
+    // Runs on the delivery thread
+    using ReceiveFn = std::function<void(const protocol::Message& message)>;
+
+    explicit EmulatedLink(const LinkProfile& profile, uint64_t seed = 1);
+    ~EmulatedLink();
+
+    EmulatedLink(const EmulatedLink&) = delete;
+    EmulatedLink& operator=(const EmulatedLink&) = delete;
+
+    // Adapter for one end; on_receive gets frames sent from the other end.
+    // The adapter must not outlive the link.
+    std::unique_ptr<Adapter> makeAdapter(End end, std::string name, ReceiveFn on_receive);
+
+    // Stops delivery; frames still in flight are dropped
+    void close();
+
+    // Frames sent from this end
+    LinkModel::Stats getStats(End from) const;
+
+private:
+    class EndAdapter;
+
+    struct InFlight {
+        std::chrono::steady_clock::time_point due;
+        uint64_t seq;
+        size_t to;
+        std::vector<uint8_t> frame;
+
+        bool operator>(const InFlight& other) const {
+            return due != other.due ? due > other.due : seq > other.seq;
+        }
+    };
+
+    bool transmit(End from, const protocol::Message& message);
+    void run();
+
+    const std::chrono::steady_clock::time_point epoch_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    LinkModel model_;
+    std::priority_queue<InFlight, std::vector<InFlight>, std::greater<InFlight>> in_flight_;
+    std::array<ReceiveFn, 2> receivers_;
+    uint64_t next_seq_ = 0;
+    bool closing_ = false;
+
+    std::thread thread_;
+};
+
+} // namespace mesh::broker
+
+#endif // MESH_BROKER_EMULATED_LINK_HPP
@@ -0,0 +1,217 @@
+#ifndef MESH_BROKER_EMULATED_MESH_HPP
+#define MESH_BROKER_EMULATED_MESH_HPP
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh/broker/link_model.hpp"
+#include "mesh/broker/message_queue.hpp"
+#include "mesh/protocol/codec.hpp"
+#include "mesh/protocol/message.hpp"
+#include "mesh/protocol/message_id.hpp"
+
+namespace mesh::broker {
+
+// Discrete-event emulation of a large mesh inside one process.
+//
+// Thousands of virtual nodes share one thread and a virtual clock, and
+// exchange encoded frames over in-memory point-to-point links. Each node
+// runs the relay path for real: frames are built with the wire codec,
+// checked for loops and duplicates in place with MessageView, and
+// forwarded through the node's own MessageQueue. A node sends one frame
+// per tx_time and a plain link adds link_delay; a link connected with a
+// LinkProfile instead gets its own LinkModel for bandwidth, jitter, loss,
+// MTU and duplex contention. A run measures routing overhead and
+// convergence in virtual time while the host only pays for the events it
+// processes, and is deterministic for a given topology and seed.
+//
+// Nodes learn reverse routes from every frame they hear: the origin is
+// reachable through the neighbour the frame came from, and fewer hops
+// win. Unicast follows a learned route and floods to every unvisited
+// neighbour when there is none; broadcasts always flood.
+class EmulatedMesh {
+public:
+    using NodeIndex = uint32_t;
+    using Duration = std::chrono::microseconds;
+
+    static constexpr NodeIndex kBroadcast = UINT32_MAX;
+
+    struct Config {
+        Duration link_delay{2000};      // propagation per link
+        Duration tx_time{100};          // a node's serialization time per frame
+        size_t queue_depth = 8;         // per priority lane at each node
+        int32_t ttl = 32;
+        size_t dedup_window = 32;       // recent message ids remembered per node
+        uint64_t seed = 1;              // link models draw loss and jitter from it
+    };
+
+    struct Stats {
+        uint64_t events = 0;
+        uint64_t originated = 0;
+        uint64_t transmissions = 0;     // frames put on a link
+        uint64_t bytes = 0;
+        uint64_t delivered = 0;         // local deliveries; a broadcast counts once per node
+        uint64_t duplicates = 0;        // dropped by message id or hop path
+        uint64_t expired = 0;
+        uint64_t queue_full = 0;
+        uint64_t routed = 0;            // unicast forwards that followed a learned route
+        uint64_t flooded = 0;           // unicast forwards with no route yet
+        uint64_t link_lost = 0;         // sent, then lost by a link model
+        uint64_t link_dropped = 0;      // refused by a link model: over MTU or congested
+
+        double transmissionsPerDelivery() const {
+            return delivered > 0 ? static_cast<double>(transmissions) / static_cast<double>(delivered) : 0.0;
+        }
+    };
+
+    // latency is virtual time since the message was originated
+    using DeliverFn = std::function<void(NodeIndex node, const protocol::Message& message, Duration latency)>;
+
+    EmulatedMesh();
+    explicit EmulatedMesh(const Config& config);
+
+    EmulatedMesh(const EmulatedMesh&) = delete;
+    EmulatedMesh& operator=(const EmulatedMesh&) = delete;
+
+    // Returns the index of the first new node
+    NodeIndex addNodes(size_t count);
+
+    // Bidirectional; false for unknown nodes, self-links and duplicates
+    bool connect(NodeIndex a, NodeIndex b);
+    // Same, with frames timed and dropped by a LinkModel of this profile
+    bool connect(NodeIndex a, NodeIndex b, const LinkProfile& profile);
+
+    // Links every node to its 4-neighbours in a grid width nodes wide
+    void connectGrid(size_t width);
+
+    // Ring plus links_per_node random chords from each node, so the mesh
+    // is connected and its diameter grows with log(n)
+    void connectRandom(size_t links_per_node, uint64_t seed);
+
+    size_t nodeCount() const { return nodes_.size(); }
+    size_t linkCount() const { return link_count_; }
+    // Model of the a-b link, or null for plain links and unknown pairs
+    const LinkModel* linkModel(NodeIndex a, NodeIndex b) const;
+
+    // 64-character hex id used as the node's from_id / to_id
+    static std::string nodeId(NodeIndex node);
+
+    // Originates a message at the current virtual time; kBroadcast floods
+    // it to every node
+    bool send(NodeIndex from, NodeIndex to, const std::string& content,
+              protocol::MessagePriority priority = protocol::MessagePriority::Normal);
+
+    // Processes events in time order until none are left or the next one
+    // is later than until; returns the number processed
+    uint64_t run(Duration until = Duration::max());
+
+    Duration now() const { return Duration(static_cast<Duration::rep>(now_us_)); }
+    bool idle() const { return events_.empty(); }
+
+    bool hasRoute(NodeIndex node, NodeIndex target) const;
+    // Nodes other than target that know a route to it
+    size_t routeCount(NodeIndex target) const;
+    // True once every other node knows a route to target; at is when the
+    // last of them learned it
+    bool convergenceTime(NodeIndex target, Duration& at) const;
+
+    void setDeliverHandler(DeliverFn handler) { deliver_ = std::move(handler); }
+
+    const Stats& getStats() const { return stats_; }
+
+private:
+    static constexpr uint32_t kService = UINT32_MAX;
+    static constexpr uint32_t kPlainLink = UINT32_MAX;
+
+    struct Link {
+        NodeIndex peer;
+        uint32_t model;                 // index into models_, or kPlainLink
+        LinkModel::Direction direction;
+    };
+
+    struct Route {
+        NodeIndex next_hop;
+        uint32_t hops;
+        uint64_t learned_at_us;
+    };
+
+    struct Node {
+        Node(NodeIndex index, const MessageQueue::Config& queue_config, size_t dedup_window);
+
+        protocol::NodeId id;
+        protocol::HopId hop;
+        MessageQueue queue;
+        std::vector<Link> links;
+        std::unordered_map<NodeIndex, Route> routes;
+        std::vector<protocol::MessageId> seen;
+        size_t seen_next = 0;
+        bool transmitting = false;
+    };
+
+    // An encoded frame shared by every link it was sent on
+    struct Frame {
+        std::vector<uint8_t> bytes;
+        uint32_t refs = 0;
+    };
+
+    struct Event {
+        uint64_t at_us;
+        uint64_t seq;
+        NodeIndex node;
+        NodeIndex from;
+        uint32_t frame;     // kService for a transmit slot
+
+        bool operator>(const Event& other) const {
+            return at_us != other.at_us ? at_us > other.at_us : seq > other.seq;
+        }
+    };
+
+    static NodeIndex indexOf(const uint8_t* id);
+
+    bool addLink(NodeIndex a, NodeIndex b, uint32_t model);
+    const Link* findLink(const Node& node, NodeIndex peer) const;
+    void schedule(uint64_t at_us, NodeIndex node, NodeIndex from, uint32_t frame);
+    bool enqueue(Node& node, NodeIndex index, protocol::Message&& message);
+    void transmit(NodeIndex index);
+    // Puts one frame on a link at time at, unless its model refuses it
+    void sendOnLink(NodeIndex index, const Link& link, uint32_t frame, size_t bytes, uint64_t at);
+    void receive(NodeIndex index, NodeIndex from, uint32_t frame);
+    void learnRoute(Node& node, NodeIndex origin, NodeIndex via, uint32_t hops);
+    bool markSeen(Node& node, const protocol::MessageId& id);
+
+    uint32_t acquireFrame();
+    void releaseFrame(uint32_t frame);
+
+    Config config_;
+    MessageQueue::Config queue_config_;
+    std::deque<Node> nodes_;
+    size_t link_count_ = 0;
+    std::deque<LinkModel> models_;
+
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+    uint64_t now_us_ = 0;
+    uint64_t next_seq_ = 0;
+
+    std::vector<Frame> frames_;
+    std::vector<uint32_t> free_frames_;
+
+    protocol::MessageIdGenerator ids_;
+    // Origination time by message id; unicast entries go on delivery,
+    // broadcasts stay for the life of the mesh
+    std::unordered_map<protocol::MessageId, uint64_t> sent_at_;
+    protocol::Message scratch_;
+
+    DeliverFn deliver_;
+    Stats stats_;
+};
+
+} // namespace mesh::broker
+
+#endif // MESH_BROKER_EMULATED_MESH_HPP
@@ -0,0 +1,95 @@
+#ifndef MESH_BROKER_LATENCY_HISTOGRAM_HPP
+#define MESH_BROKER_LATENCY_HISTOGRAM_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh/protocol/message.hpp"
+
+namespace mesh::broker {
+
+struct LatencySummary {
+    uint64_t count = 0;
+    double mean_us = 0.0;
+    uint64_t p50_us = 0;
+    uint64_t p90_us = 0;
+    uint64_t p99_us = 0;
+    uint64_t p999_us = 0;
+    uint64_t max_us = 0;
+};
+
+// Lock-free log-linear (HDR-style) histogram of latencies in microseconds.
+//
+// Each power of two is split into 16 linear sub-buckets, so a recorded
+// value is reported within 1/16 of itself from 1us up to 2^40us. record()
+// is one relaxed fetch_add on the bucket plus one on the sum, and a CAS on
+// max only when the value is a new maximum. Percentiles report the upper
+// edge of the bucket, capped at the exact maximum.
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr unsigned kMaxExponent = 40;
+    static constexpr size_t kBucketCount = (kMaxExponent - kSubBucketBits + 2) << kSubBucketBits;
+
+    void record(std::chrono::nanoseconds latency) {
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+        recordMicros(micros > 0 ? static_cast<uint64_t>(micros) : 0);
+    }
+
+    void recordMicros(uint64_t micros) {
+        buckets_[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+        sum_us_.fetch_add(micros, std::memory_order_relaxed);
+        uint64_t max = max_us_.load(std::memory_order_relaxed);
+        while (micros > max && !max_us_.compare_exchange_weak(max, micros, std::memory_order_relaxed)) {
+        }
+    }
+
+    LatencySummary summarize() const;
+
+    // Summary over several histograms as if their samples were recorded in one
+    static LatencySummary summarize(const LatencyHistogram* const* histograms, size_t count);
+
+    // Not atomic against concurrent record()
+    void reset();
+
+    static size_t bucketIndex(uint64_t micros);
+    // Largest value that lands in a bucket
+    static uint64_t bucketUpperBound(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+    std::atomic<uint64_t> sum_us_{0};
+    std::atomic<uint64_t> max_us_{0};
+};
+
+struct LatencyStats {
+    LatencySummary all;
+    // Indexed by MessagePriority
+    std::array<LatencySummary, 3> by_priority;
+};
+
+// One histogram per MessagePriority for a single latency metric
+class PriorityLatency {
+public:
+    void record(protocol::MessagePriority priority, std::chrono::nanoseconds latency) {
+        histograms_[index(priority)].record(latency);
+    }
+
+    LatencyStats summarize() const;
+    void reset();
+
+private:
+    static size_t index(protocol::MessagePriority priority) {
+        size_t i = static_cast<size_t>(priority);
+        return i < 3 ? i : static_cast<size_t>(protocol::MessagePriority::Normal);
+    }
+
+    std::array<LatencyHistogram, 3> histograms_;
+};
+
+} // namespace mesh::broker
+
+#endif // MESH_BROKER_LATENCY_HISTOGRAM_HPP
@@ -0,0 +1,115 @@
+#ifndef MESH_BROKER_LINK_MODEL_HPP
+#define MESH_BROKER_LINK_MODEL_HPP
+
+#include <array>
+#include <chrono>
+#include <random>
+#include <cstddef>
+#include <cstdint>
+
+namespace mesh::broker {
+
+// Two-state Markov loss: a link flips between a good and a bad state
+// before each frame and drops it with that state's loss rate, so losses
+// come in bursts the way fading radio links lose them. Mean burst length
+// is 1 / bad_to_good frames. The defaults never lose anything.
+struct GilbertElliott {
+    double good_to_bad = 0.0;
+    double bad_to_good = 1.0;
+    double loss_good = 0.0;
+    double loss_bad = 0.0;
+
+    // Long-run fraction of frames lost
+    double averageLoss() const;
+};
+
+struct LinkProfile {
+    uint64_t bandwidth_bps = 24'000'000;
+    std::chrono::microseconds delay{1000};      // propagation
+    std::chrono::microseconds jitter{0};        // extra delay, uniform in [0, jitter]
+    size_t mtu = 1500;
+    // Token bucket depth: bytes an idle channel lets through at once. At
+    // 0 every frame waits out its own serialization time.
+    size_t burst_bytes = 0;
+    // Frames that would queue longer than this for the channel are dropped
+    std::chrono::microseconds max_backlog{100000};
+    // Both directions share one channel's airtime
+    bool half_duplex = true;
+    GilbertElliott loss;
+
+    // Congested 802.11n link between phones a room apart
+    static LinkProfile wifi();
+};
+
+// Timing and loss for one emulated link, both directions.
+//
+// transmit() is told the time a frame is handed to the link and says
+// whether and when it arrives at the far end. Each channel is a token
+// bucket filled at bandwidth_bps up to burst_bytes, and a frame has left
+// once the bucket covers it, so later frames queue behind earlier ones
+// and a saturated channel runs at exactly its bandwidth. A half-duplex link
+// has one channel, so traffic in either direction delays the other. Jitter
+// never reorders a direction, and lost frames still use their airtime.
+// Time is any monotonic microsecond count, so the same model runs on the
+// steady clock or an EmulatedMesh's virtual clock; randomness comes from
+// the seed, so a run is reproducible.
+class LinkModel {
+public:
+    using Duration = std::chrono::microseconds;
+
+    enum class Direction {
+        AtoB,
+        BtoA
+    };
+
+    enum class Outcome {
+        Delivered,
+        Lost,           // sent, but the loss model dropped it
+        Oversize,       // larger than the MTU, never sent
+        Congested       // would have waited past max_backlog, never sent
+    };
+
+    struct Verdict {
+        Outcome outcome = Outcome::Delivered;
+        Duration departs_at{0};     // last bit on the air
+        Duration arrives_at{0};     // valid when Delivered
+    };
+
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t delivered = 0;
+        uint64_t lost = 0;
+        uint64_t oversize = 0;
+        uint64_t congested = 0;
+        uint64_t bytes_delivered = 0;
+    };
+
+    explicit LinkModel(const LinkProfile& profile, uint64_t seed = 1);
+
+    Verdict transmit(Direction direction, size_t bytes, Duration now);
+
+    const LinkProfile& profile() const { return profile_; }
+    // Indexed by Direction
+    const Stats& getStats(Direction direction) const { return stats_[index(direction)]; }
+
+private:
+    struct Channel {
+        double tokens = 0.0;        // bytes; negative while frames are queued
+        int64_t refilled_at = 0;    // microseconds
+    };
+
+    static size_t index(Direction direction) { return static_cast<size_t>(direction); }
+
+    LinkProfile profile_;
+    double bytes_per_us_;
+    double burst_;
+    std::array<Channel, 2> channels_;
+    std::array<bool, 2> bad_{{false, false}};
+    std::array<int64_t, 2> last_arrival_{{0, 0}};
+    std::array<Stats, 2> stats_;
+    std::mt19937_64 rng_;
+};
+
+} // namespace mesh::broker
+
+#endif // MESH_BROKER_LINK_MODEL_HPP
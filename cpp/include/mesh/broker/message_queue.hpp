@@ -0,0 +1,155 @@
+#ifndef MESH_BROKER_MESSAGE_QUEUE_HPP
+#define MESH_BROKER_MESSAGE_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh/broker/mpmc_ring.hpp"
+#include "mesh/broker/wakeup.hpp"
+#include "mesh/protocol/coarse_clock.hpp"
+#include "mesh/protocol/message.hpp"
+
+namespace mesh::broker {
+
+// Outbound queue with one lock-free lane per MessagePriority.
+//
+// Each lane is a bounded MpmcRing of pooled slots, so pushing never
+// allocates once the slots are warm. Any thread may push(); a single
+// consumer (the broker's queue thread) calls pop() or popBatch(). Lanes
+// are served by weighted round robin, so under load High gets
+// weights[High] dequeues for every weights[Low] of Low, and an idle class
+// never holds back a busy one. A Low message that has waited longer than
+// low_max_wait is served next regardless of credits, so bulk traffic
+// cannot be starved indefinitely by control floods.
+//
+// An idle consumer sleeps on wakeFd() instead of polling:
+//
+//   while (running) {
+//       if (queue.popBatch(batch, n) == 0 && queue.prepareWait()) {
+//           waitReadable({queue.wakeFd(), stop.fd()});
+//           queue.finishWait();
+//       }
+//   }
+//
+// Producers only write the eventfd when the consumer has armed it, so a
+// busy queue makes no syscalls. The eventfd is opened on the first
+// prepareWait(), so queues that are only ever drained by polling (such as
+// the thousands in an EmulatedMesh) hold no file descriptor. Producers
+// blocked on a full lane sleep on a futex that the consumer wakes when it
+// frees slots.
+class MessageQueue {
+public:
+    static constexpr size_t kClassCount = 3;
+
+    // What push() does when the message's lane is full
+    enum class EnqueuePolicy {
+        Reject,     // fail at once
+        Block       // wait up to block_timeout for the consumer to make room
+    };
+
+    struct Config {
+        // Dequeues per round, indexed by MessagePriority
+        std::array<uint32_t, kClassCount> weights{{1, 4, 16}};
+        // Per-lane ring capacity, rounded up to a power of two
+        size_t max_depth = 4096;
+        protocol::CoarseClock::duration low_max_wait = std::chrono::milliseconds(500);
+        EnqueuePolicy enqueue_policy = EnqueuePolicy::Reject;
+        std::chrono::microseconds block_timeout = std::chrono::milliseconds(100);
+    };
+
+    struct ClassStats {
+        size_t depth = 0;
+        uint64_t dequeued = 0;
+        uint64_t rejected = 0;
+        uint64_t blocked = 0;       // pushes that had to wait for room
+        double avg_wait_ms = 0.0;
+        double max_wait_ms = 0.0;
+    };
+
+    MessageQueue();
+    explicit MessageQueue(const Config& config);
+
+    MessageQueue(const MessageQueue&) = delete;
+    MessageQueue& operator=(const MessageQueue&) = delete;
+
+    // Lock-free for producers; false when the lane is full under Reject,
+    // or stays full for block_timeout under Block. Copying reuses the
+    // slot's string buffers.
+    bool push(const protocol::Message& message);
+    bool push(protocol::Message&& message);
+
+    // Consumer only
+    bool pop(protocol::Message& message);
+
+    // Consumer only; swaps up to max messages into out[0..n) in the same
+    // order repeated pop() calls would, claiming each run from a lane at
+    // once. out's old contents go back to the pool.
+    size_t popBatch(protocol::Message* out, size_t max);
+
+    // Consumer only; arms the wakeup and returns true if the queue is
+    // still empty, in which case the caller may sleep on wakeFd()
+    bool prepareWait();
+
+    // Consumer only; disarms and clears the wakeup after sleeping
+    void finishWait();
+
+    // -1 until the first prepareWait()
+    int wakeFd() const { return wake_ ? wake_->fd() : -1; }
+
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+
+    ClassStats getClassStats(protocol::MessagePriority priority) const;
+
+    // Consumer only; drops everything still queued
+    void clear();
+
+private:
+    struct Entry {
+        protocol::Message message;
+        // Read fresh by the producer; popBatch() compares it with one fresh
+        // read of its own, so waits never mix two threads' cached clocks
+        protocol::CoarseClock::time_point enqueued_at;
+    };
+
+    struct Lane {
+        explicit Lane(size_t capacity) : ring(capacity) {}
+
+        MpmcRing<Entry> ring;
+        uint32_t credits = 0;
+
+        alignas(64) std::atomic<uint64_t> rejected{0};
+        std::atomic<uint64_t> blocked{0};
+        std::atomic<uint64_t> dequeued{0};
+        std::atomic<int64_t> total_wait_ms{0};
+        std::atomic<int64_t> max_wait_ms{0};
+    };
+
+    static size_t laneIndex(protocol::MessagePriority priority);
+
+    template <typename Fill>
+    bool enqueue(Lane& lane, Fill&& fill);
+    void notifyConsumer();
+    void notifyProducers();
+    size_t take(Lane& lane, protocol::Message* out, size_t max, protocol::CoarseClock::time_point now);
+    void refillCredits();
+
+    Config config_;
+    std::array<Lane, kClassCount> lanes_;
+
+    // Written by the consumer before it first arms, so producers that see
+    // consumer_armed_ also see it
+    std::unique_ptr<EventFd> wake_;
+    alignas(64) std::atomic<bool> consumer_armed_{false};
+    // Bumped by the consumer whenever it frees slots while producers wait
+    alignas(64) std::atomic<uint32_t> space_epoch_{0};
+    std::atomic<uint32_t> space_waiters_{0};
+};
+
+} // namespace mesh::broker
+
+#endif // MESH_BROKER_MESSAGE_QUEUE_HPP
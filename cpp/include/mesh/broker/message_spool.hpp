@@ -0,0 +1,154 @@
+#ifndef MESH_BROKER_MESSAGE_SPOOL_HPP
+#define MESH_BROKER_MESSAGE_SPOOL_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh/protocol/codec.hpp"
+#include "mesh/protocol/message.hpp"
+
+namespace mesh::broker {
+
+// Disk-backed store-and-forward queue for peers that are offline.
+//
+// Messages are wire-encoded straight into one log of fixed-size,
+// memory-mapped segment files, so the bytes live in the page cache rather
+// than on the heap. A committer thread msyncs everything appended since
+// the last commit in one go, every commit_interval or sooner once
+// commit_bytes are pending, and sync() joins the next commit instead of
+// forcing its own. The only per-message memory is a 12-byte index entry
+// (segment, offset, length) in a FIFO per destination, so RAM stays flat
+// however long a partition lasts.
+//
+// stream() hands a reconnecting peer's frames straight out of the mapping
+// in order; acknowledge() then retires them by appending an ack record,
+// keeping the log append-only. Segments are deleted oldest first once
+// nothing in them is pending. open() rebuilds the index with one
+// sequential, CRC-checked scan and stops at a torn tail. Acks are not
+// waited on, so a crash can resend acknowledged messages (at-least-once);
+// receivers drop them by message id.
+class MessageSpool {
+public:
+    struct Config {
+        std::string directory;
+        size_t segment_bytes = 8 * 1024 * 1024;
+        // Longest an append waits to become durable
+        std::chrono::milliseconds commit_interval{5};
+        // Commit early once this much is waiting
+        size_t commit_bytes = 256 * 1024;
+        // Writes one dirty range back to disk; msync(MS_SYNC) when unset.
+        // Lets tests inject I/O errors.
+        std::function<bool(void* address, size_t len)> flush;
+    };
+
+    struct Stats {
+        size_t destinations = 0;        // with messages pending
+        uint64_t pending = 0;
+        size_t segments = 0;
+        uint64_t disk_bytes = 0;
+        uint64_t appended = 0;
+        uint64_t acknowledged = 0;
+        uint64_t commits = 0;
+        uint64_t commit_failures = 0;
+        bool failing = false;           // last commit failed; appends are refused
+        uint64_t recovered = 0;         // pending messages found by open()
+    };
+
+    // Called with each frame in order; false stops the stream
+    using SendFn = std::function<bool(const uint8_t* frame, size_t len)>;
+
+    explicit MessageSpool(const Config& config);
+    ~MessageSpool();
+
+    MessageSpool(const MessageSpool&) = delete;
+    MessageSpool& operator=(const MessageSpool&) = delete;
+
+    // Creates the directory if needed and recovers any existing log;
+    // false on I/O errors
+    bool open();
+    // Commits and unmaps; open() may be called again
+    void close();
+
+    // Spools a copy for message.to_id; durable by the next group commit.
+    // False for messages that cannot be encoded or fit no segment, and
+    // while commits are failing; the committer retries every
+    // commit_interval and appends resume once one succeeds.
+    bool append(const protocol::Message& message);
+
+    // Blocks until everything appended so far is on disk
+    bool sync();
+
+    // Sends up to max of the peer's oldest frames without removing them;
+    // returns how many send accepted
+    size_t stream(const protocol::NodeId& peer, size_t max, const SendFn& send) const;
+
+    // Retires the peer's oldest count messages once delivered
+    size_t acknowledge(const protocol::NodeId& peer, size_t count);
+
+    size_t pending(const protocol::NodeId& peer) const;
+    Stats getStats() const;
+
+private:
+    struct Segment;
+
+    struct Entry {
+        uint32_t segment;
+        uint32_t offset;        // of the record header
+        uint32_t length;        // frame bytes
+    };
+
+    struct NodeIdHash {
+        size_t operator()(const protocol::NodeId& id) const;
+    };
+
+    std::shared_ptr<Segment> openSegment(uint32_t number, bool create);
+    // Room for a record with a body_len-byte body; null if none can be made
+    uint8_t* reserve(size_t body_len, Entry& at);
+    // Writes the header of a filled-in record, making it visible to recovery
+    void seal(const Entry& at, size_t body_len);
+    void recover(Segment& segment);
+    // Pops the queue's entries up to and including the record at segment:offset
+    size_t retire(std::deque<Entry>& queue, uint32_t segment, uint32_t offset);
+    void dropDeadSegments();
+    void runCommitter();
+    void commit(std::unique_lock<std::mutex>& lock);
+
+    Config config_;
+    int dir_fd_ = -1;
+
+    mutable std::mutex mutex_;
+    std::condition_variable commit_wake_;
+    std::condition_variable committed_;
+
+    std::map<uint32_t, std::shared_ptr<Segment>> segments_;
+    std::shared_ptr<Segment> active_;
+    std::unordered_map<protocol::NodeId, std::deque<Entry>, NodeIdHash> queues_;
+    uint64_t pending_ = 0;
+
+    // Bytes ever appended, and how many of them are on disk
+    uint64_t appended_bytes_ = 0;
+    uint64_t durable_bytes_ = 0;
+    // Segments before this one hold nothing uncommitted
+    uint32_t unsynced_from_ = 0;
+    bool sync_requested_ = false;
+    bool commit_failed_ = false;
+
+    Stats stats_;
+    bool open_ = false;
+    bool stopping_ = false;
+    std::thread committer_;
+};
+
+} // namespace mesh::broker
+
+#endif // MESH_BROKER_MESSAGE_SPOOL_HPP
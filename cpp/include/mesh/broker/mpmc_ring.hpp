@@ -0,0 +1,150 @@
+#ifndef MESH_BROKER_MPMC_RING_HPP
+#define MESH_BROKER_MPMC_RING_HPP
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace mesh::broker {
+
+// Bounded lock-free MPMC ring (Vyukov's sequence-numbered slots).
+//
+// Slots are allocated once and their values are reused: push() assigns
+// into the slot's existing T, and consumers swap the value out, so a
+// steady stream of same-sized messages stops allocating once every slot
+// and the consumer's buffers have warmed up. Each slot carries a sequence
+// number that tells producers and consumers whose turn it is; the only
+// shared writes are one CAS on the enqueue or dequeue position.
+// popBatch() claims a run of ready slots with a single CAS.
+template <typename T>
+class MpmcRing {
+public:
+    // Capacity is rounded up to a power of two
+    explicit MpmcRing(size_t capacity)
+        : mask_(roundUp(capacity) - 1), slots_(new Slot[mask_ + 1]) {
+        for (size_t i = 0; i <= mask_; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
+
+    bool tryPush(const T& value) {
+        return push([&](T& slot) { slot = value; });
+    }
+
+    bool tryPush(T&& value) {
+        return push([&](T& slot) { slot = std::move(value); });
+    }
+
+    // fill(T&) writes the slot's value in place; false when full
+    template <typename Fill>
+    bool push(Fill&& fill) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos & mask_];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    fill(slot.value);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& value) {
+        return popBatch(1, [&](T& slot) {
+            using std::swap;
+            swap(slot, value);
+        }) == 1;
+    }
+
+    // Claims up to max ready values in FIFO order and calls take(T&) on
+    // each before handing its slot back; returns how many were taken
+    template <typename Take>
+    size_t popBatch(size_t max, Take&& take) {
+        if (max == 0) {
+            return 0;
+        }
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        size_t ready;
+        for (;;) {
+            Slot& first = slots_[pos & mask_];
+            size_t sequence = first.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff < 0) {
+                return 0;
+            }
+            if (diff > 0) {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+                continue;
+            }
+
+            ready = 1;
+            while (ready < max &&
+                   slots_[(pos + ready) & mask_].sequence.load(std::memory_order_acquire) == pos + ready + 1) {
+                ++ready;
+            }
+            if (dequeue_pos_.compare_exchange_weak(pos, pos + ready, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < ready; ++i) {
+            Slot& slot = slots_[(pos + i) & mask_];
+            take(slot.value);
+            slot.sequence.store(pos + i + mask_ + 1, std::memory_order_release);
+        }
+        return ready;
+    }
+
+    // Oldest ready value, or nullptr. Only meaningful with a single
+    // consumer, since another consumer may take it at any time.
+    const T* peek() const {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        const Slot& slot = slots_[pos & mask_];
+        return slot.sequence.load(std::memory_order_acquire) == pos + 1 ? &slot.value : nullptr;
+    }
+
+    // Exact when quiescent; includes pushes still being written
+    size_t sizeApprox() const {
+        size_t tail = dequeue_pos_.load(std::memory_order_relaxed);
+        size_t head = enqueue_pos_.load(std::memory_order_relaxed);
+        return head > tail ? head - tail : 0;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    static size_t roundUp(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+};
+
+} // namespace mesh::broker
+
+#endif // MESH_BROKER_MPMC_RING_HPP
@@ -0,0 +1,76 @@
+#ifndef MESH_BROKER_SHARDED_COUNTERS_HPP
+#define MESH_BROKER_SHARDED_COUNTERS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace mesh::broker {
+
+namespace detail {
+
+// Small per-thread number, handed out round robin on first use
+inline size_t threadSlot() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+}
+
+} // namespace detail
+
+// A fixed set of event counters striped across cache-line-padded shards.
+//
+// Each thread bumps the shard picked by its thread slot with a relaxed
+// fetch_add, so threads on different shards never share a line and the
+// hot path takes no lock. Readers sum the shards on demand; a read is not
+// a snapshot across counters, only each counter is exact once writers
+// are quiescent.
+template <size_t Count, size_t Shards = 16>
+class ShardedCounters {
+public:
+    static_assert(Count > 0, "at least one counter");
+    static_assert((Shards & (Shards - 1)) == 0, "shard count must be a power of two");
+
+    void add(size_t counter, uint64_t delta = 1) {
+        shards_[detail::threadSlot() & (Shards - 1)].values[counter].fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    uint64_t read(size_t counter) const {
+        uint64_t total = 0;
+        for (const auto& shard : shards_) {
+            total += shard.values[counter].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    std::array<uint64_t, Count> readAll() const {
+        std::array<uint64_t, Count> totals{};
+        for (const auto& shard : shards_) {
+            for (size_t i = 0; i < Count; ++i) {
+                totals[i] += shard.values[i].load(std::memory_order_relaxed);
+            }
+        }
+        return totals;
+    }
+
+    // Not atomic against concurrent add()
+    void reset() {
+        for (auto& shard : shards_) {
+            for (auto& value : shard.values) {
+                value.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, Count> values{};
+    };
+
+    std::array<Shard, Shards> shards_{};
+};
+
+} // namespace mesh::broker
+
+#endif // MESH_BROKER_SHARDED_COUNTERS_HPP
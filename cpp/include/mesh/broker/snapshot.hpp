@@ -0,0 +1,56 @@
+#ifndef MESH_BROKER_SNAPSHOT_HPP
+#define MESH_BROKER_SNAPSHOT_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <cstdint>
+
+namespace mesh::broker {
+
+// An immutable published value and the version it was published as
+template <typename T>
+struct Snapshot {
+    uint64_t version = 0;
+    T value;
+};
+
+// Read-mostly state published as immutable versioned snapshots.
+//
+// Readers take the current snapshot with one atomic shared_ptr load and
+// keep a consistent view for as long as they hold it; elements inside
+// are never copied or re-counted. Writers serialize on a mutex, copy the
+// current value, edit the copy off to the side and publish it with the
+// next version. The old snapshot is freed when its last reader lets go.
+template <typename T>
+class SnapshotCell {
+public:
+    using Ptr = std::shared_ptr<const Snapshot<T>>;
+
+    SnapshotCell() : current_(std::make_shared<const Snapshot<T>>()) {}
+
+    Ptr load() const {
+        return std::atomic_load_explicit(&current_, std::memory_order_acquire);
+    }
+
+    // edit(T&) changes a private copy; returns the published version
+    template <typename Edit>
+    uint64_t update(Edit&& edit) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        auto next = std::make_shared<Snapshot<T>>(*current_);
+        edit(next->value);
+        next->version = current_->version + 1;
+        uint64_t version = next->version;
+        std::atomic_store_explicit(&current_, Ptr(std::move(next)), std::memory_order_release);
+        return version;
+    }
+
+private:
+    std::mutex write_mutex_;
+    Ptr current_;
+};
+
+} // namespace mesh::broker
+
+#endif // MESH_BROKER_SNAPSHOT_HPP
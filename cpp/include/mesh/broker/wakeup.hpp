@@ -0,0 +1,66 @@
+#ifndef MESH_BROKER_WAKEUP_HPP
+#define MESH_BROKER_WAKEUP_HPP
+
+#include <atomic>
+#include <chrono>
+#include <initializer_list>
+#include <cstdint>
+
+namespace mesh::broker {
+
+// Kernel wakeup primitives for the broker's worker threads (Linux).
+// Threads sleep in waitReadable() on an EventFd that producers signal
+// and a TimerFd for periodic work, so an idle broker makes no syscalls.
+
+// Counter that makes its fd readable once notified. notify() is a single
+// write(2) and is async-signal-safe.
+class EventFd {
+public:
+    EventFd();
+    ~EventFd();
+
+    EventFd(const EventFd&) = delete;
+    EventFd& operator=(const EventFd&) = delete;
+
+    void notify();
+
+    // Clears the fd; returns notifications since the last drain
+    uint64_t drain();
+
+    int fd() const { return fd_; }
+
+private:
+    int fd_;
+};
+
+// fd that becomes readable every interval, starting one interval from now
+class TimerFd {
+public:
+    explicit TimerFd(std::chrono::milliseconds interval);
+    ~TimerFd();
+
+    TimerFd(const TimerFd&) = delete;
+    TimerFd& operator=(const TimerFd&) = delete;
+
+    // Clears the fd; returns expirations since the last drain
+    uint64_t drain();
+
+    int fd() const { return fd_; }
+
+private:
+    int fd_;
+};
+
+// Blocks until at least one fd is readable or the timeout passes
+// (negative waits forever). Returns a bitmask by position in fds; 0 on
+// timeout.
+uint32_t waitReadable(std::initializer_list<int> fds,
+                      std::chrono::milliseconds timeout = std::chrono::milliseconds(-1));
+
+// futex(2) on a 32-bit atomic: sleeps while word == expected
+void futexWait(const std::atomic<uint32_t>& word, uint32_t expected, std::chrono::microseconds timeout);
+void futexWakeAll(const std::atomic<uint32_t>& word);
+
+} // namespace mesh::broker
+
+#endif // MESH_BROKER_WAKEUP_HPP
@@ -0,0 +1,103 @@
+#ifndef MESH_CRYPTO_BATCH_SIGNER_HPP
+#define MESH_CRYPTO_BATCH_SIGNER_HPP
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace mesh::crypto {
+
+using Hash = std::array<uint8_t, 32>;
+using Signature = std::array<uint8_t, 64>;
+
+// Proof attached to each message of a signed batch: the single Ed25519
+// signature over the batch's Merkle root, plus the sibling hashes that
+// lead from the message's leaf to that root. The root itself is not sent;
+// verifiers recompute it from the message.
+struct BatchProof {
+    Signature signature{};
+    uint16_t leaf_index = 0;
+    uint16_t leaf_count = 0;
+    std::vector<Hash> path;
+
+    // signature (64) | leaf_index (2) | leaf_count (2) | path (32 each)
+    std::vector<uint8_t> encode() const;
+    static bool decode(const uint8_t* data, size_t len, BatchProof& proof);
+};
+
+// Collects messages over a short window and signs them as one Merkle batch,
+// so a node pays one Ed25519 signature per batch instead of per message.
+class BatchSigner {
+public:
+    static constexpr size_t kMaxBatchSize = 1024;
+
+    enum class AddResult {
+        Queued,
+        Full,       // queued, and the batch should now be flushed
+        Rejected    // the batch was already full; flush and add again
+    };
+
+    BatchSigner(const uint8_t private_key[32],
+                std::chrono::milliseconds window = std::chrono::milliseconds(5),
+                size_t max_batch = 256);
+    ~BatchSigner();
+
+    // Queues a message. A full batch takes nothing more until flush(), so
+    // its leaf count always fits the proof's 16-bit field.
+    AddResult add(const uint8_t* message, size_t len);
+
+    // True when the oldest pending message has waited a full window
+    bool isDue() const;
+
+    // Signs every pending message. proofs[i] belongs to the i-th message
+    // added since the previous flush.
+    bool flush(std::vector<BatchProof>& proofs);
+
+    size_t pending() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::array<uint8_t, 32> private_key_{};
+    std::chrono::milliseconds window_;
+    size_t max_batch_;
+    std::vector<Hash> leaves_;
+    std::chrono::steady_clock::time_point first_added_;
+};
+
+// Verifies batch proofs, remembering roots whose signature already checked
+// out so the rest of a batch costs only hashing.
+class BatchVerifier {
+public:
+    struct Stats {
+        size_t signature_checks = 0;
+        size_t cache_hits = 0;
+    };
+
+    explicit BatchVerifier(const uint8_t public_key[32], size_t cache_size = 1024);
+
+    bool verify(const uint8_t* message, size_t len, const BatchProof& proof);
+
+    Stats getStats() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::array<uint8_t, 32> public_key_{};
+    size_t cache_size_;
+    std::set<std::pair<Hash, uint16_t>> verified_roots_;
+    std::deque<std::pair<Hash, uint16_t>> cache_order_;
+    Stats stats_;
+};
+
+// Merkle helpers shared by signer and verifier
+Hash batchLeafHash(const uint8_t* message, size_t len);
+bool batchRootFromProof(const Hash& leaf, const BatchProof& proof, Hash& root);
+
+} // namespace mesh::crypto
+
+#endif // MESH_CRYPTO_BATCH_SIGNER_HPP
@@ -0,0 +1,94 @@
+#ifndef MESH_CRYPTO_GROUP_SESSION_HPP
+#define MESH_CRYPTO_GROUP_SESSION_HPP
+
+#include <array>
+#include <map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace mesh::crypto {
+
+// Sender-key group encryption for broadcasts.
+//
+// A node creates one SenderKeySession and hands its distribution message
+// to every group member over their pairwise sessions. Each broadcast is
+// then encrypted once, whatever the group size; members decrypt with the
+// SenderKeyReceiver built from that distribution. The chain key is
+// ratcheted with HKDF after every message, so a leaked key does not expose
+// earlier broadcasts.
+//
+// Broadcast frames are authenticated to the group, not to the sender:
+// any member holding the distribution could forge one. Call rotate() and
+// redistribute whenever membership changes.
+//
+// Frame layout: key id (4, LE) | iteration (4, LE) | AES-GCM ciphertext
+class SenderKeySession {
+public:
+    using ChainKey = std::array<uint8_t, 32>;
+
+    static constexpr size_t kHeaderSize = 8;
+    static constexpr size_t kTagSize = 16;
+    static constexpr size_t kFrameOverhead = kHeaderSize + kTagSize;
+    static constexpr size_t kDistributionSize = 8 + 32;
+
+    // Starts with rotate(); check hasKey() in case the RNG failed
+    SenderKeySession();
+    ~SenderKeySession();
+
+    // Encrypts one broadcast payload and advances the chain; false
+    // without a key
+    bool encrypt(const std::vector<uint8_t>& plaintext, std::vector<uint8_t>& out);
+
+    // Current key id, iteration and chain key, to send over pairwise
+    // sessions; empty without a key
+    std::vector<uint8_t> createDistribution() const;
+
+    // Starts a fresh chain under a new key id. False if the RNG failed,
+    // which also discards the old chain: nothing can be sent until a
+    // later rotate() succeeds.
+    bool rotate();
+
+    bool hasKey() const { return has_key_; }
+    uint32_t getKeyId() const { return key_id_; }
+    uint32_t getIteration() const { return iteration_; }
+
+private:
+    bool has_key_ = false;
+    uint32_t key_id_ = 0;
+    uint32_t iteration_ = 0;
+    ChainKey chain_key_{};
+};
+
+class SenderKeyReceiver {
+public:
+    // Bound on how far a single frame may move the chain forward
+    static constexpr uint32_t kMaxForwardSkip = 1024;
+    // Bound on message keys kept for frames that arrive out of order
+    static constexpr size_t kMaxSkippedKeys = 256;
+
+    SenderKeyReceiver() = default;
+    ~SenderKeyReceiver();
+
+    // Installs (or replaces) the sender's chain from a distribution message
+    bool importDistribution(const std::vector<uint8_t>& distribution);
+
+    bool decrypt(const std::vector<uint8_t>& frame, std::vector<uint8_t>& plaintext);
+
+    bool hasKey() const { return has_key_; }
+    uint32_t getKeyId() const { return key_id_; }
+    uint32_t getIteration() const { return iteration_; }
+
+private:
+    using MessageKey = std::array<uint8_t, 32>;
+
+    bool has_key_ = false;
+    uint32_t key_id_ = 0;
+    uint32_t iteration_ = 0;
+    SenderKeySession::ChainKey chain_key_{};
+    std::map<uint32_t, MessageKey> skipped_keys_;
+};
+
+} // namespace mesh::crypto
+
+#endif // MESH_CRYPTO_GROUP_SESSION_HPP
@@ -0,0 +1,83 @@
+#ifndef MESH_CRYPTO_LAYERED_FRAME_HPP
+#define MESH_CRYPTO_LAYERED_FRAME_HPP
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh/crypto/session_table.hpp"
+
+namespace mesh::crypto {
+
+// Layered frame for MESH_MSG_ENCRYPTED traffic.
+//
+// The body is encrypted end to end between source and destination; the
+// routing header in front of it is authenticated hop by hop. A relay
+// verifies the header with its inbound link key, updates TTL and hop
+// count, re-tags the header for the outbound link and forwards the body
+// bytes untouched, so relay cost does not depend on payload size.
+//
+// Layout (little endian):
+//   0   version      u8
+//   1   type         u8     MESH_MSG_ENCRYPTED
+//   2   ttl          u8
+//   3   hops         u8
+//   4   session_id   u32    link session of the hop that sent the frame
+//   8   hop_counter  u64    nonce for the header tag
+//   16  source       32     node id
+//   48  destination  32     node id
+//   80  body_length  u32
+//   84  hop_tag      16     GMAC over bytes [0, 84)
+//   100 body         e2e counter (u64) | ciphertext | tag (16)
+using NodeId = std::array<uint8_t, 32>;
+
+constexpr uint8_t kLayeredFrameVersion = 1;
+constexpr size_t kRoutingHeaderSize = 100;
+constexpr size_t kLayeredBodyOverhead = 8 + 16;
+
+struct RoutingHeader {
+    uint8_t version = kLayeredFrameVersion;
+    uint8_t type = 0;
+    uint8_t ttl = 0;
+    uint8_t hops = 0;
+    SessionId session_id = kInvalidSessionId;
+    uint64_t hop_counter = 0;
+    NodeId source{};
+    NodeId destination{};
+    uint32_t body_length = 0;
+};
+
+// Origin: encrypts the body for the destination and tags the header for
+// the first link. version, type and body_length are filled in by the call.
+bool sealLayeredFrame(RoutingHeader header,
+                      const SessionTable::Key& e2e_key,
+                      uint64_t e2e_counter,
+                      const std::vector<uint8_t>& plaintext,
+                      const SessionTable::Key& hop_key,
+                      std::vector<uint8_t>& out);
+
+// Any hop: checks the header tag and decodes the header. The body is not read.
+bool verifyRoutingHeader(const uint8_t* frame, size_t len,
+                         const SessionTable::Key& hop_key,
+                         RoutingHeader& header);
+
+// Relay: verifies the header, spends one TTL, and re-tags it in place for
+// the outbound link. Fails without modifying the frame if the header does
+// not verify or the TTL is exhausted.
+bool relayLayeredFrame(uint8_t* frame, size_t len,
+                       const SessionTable::Key& inbound_hop_key,
+                       SessionId outbound_session,
+                       uint64_t outbound_counter,
+                       const SessionTable::Key& outbound_hop_key);
+
+// Destination: verifies the header, then decrypts the body.
+bool openLayeredFrame(const uint8_t* frame, size_t len,
+                      const SessionTable::Key& hop_key,
+                      const SessionTable::Key& e2e_key,
+                      RoutingHeader& header,
+                      std::vector<uint8_t>& plaintext);
+
+} // namespace mesh::crypto
+
+#endif // MESH_CRYPTO_LAYERED_FRAME_HPP
@@ -0,0 +1,102 @@
+#ifndef MESH_CRYPTO_NOISE_HPP
+#define MESH_CRYPTO_NOISE_HPP
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#include "mesh/crypto/handshake.hpp"
+
+namespace mesh::crypto {
+
+// One-round-trip handshake following the Noise IK pattern
+// (Noise_IK_25519_AESGCM_SHA256):
+//
+//   <- s                       responder static key known from discovery
+//   -> e, es, s, ss, [early]   initiation, carries encrypted early data
+//   <- e, ee, se, [payload]    response, carries encrypted reply
+//
+// The initiator may put its first application message into the initiation,
+// so it reaches the responder together with the key exchange. Both sides
+// hold transport keys after the response; no further round trip is needed.
+class NoiseHandshake {
+public:
+    enum class Role {
+        Initiator,
+        Responder
+    };
+
+    // Bytes added to the early data / reply by each flight
+    static constexpr size_t kTagSize = 16;
+    static constexpr size_t kInitiationOverhead = 32 + 32 + kTagSize + kTagSize;
+    static constexpr size_t kResponseOverhead = 32 + kTagSize;
+
+    NoiseHandshake(Role role, const KeyPair& static_key);
+    ~NoiseHandshake() = default;
+
+    // Initiator: build the first flight for a responder whose static key is known
+    bool writeInitiation(const PublicKey& remote_static_key,
+                         const std::vector<uint8_t>& early_data,
+                         std::vector<uint8_t>& out);
+
+    // Responder: consume the first flight and recover the early data
+    bool readInitiation(const std::vector<uint8_t>& in,
+                        std::vector<uint8_t>& early_data);
+
+    // Responder: answer the initiation, completing the handshake
+    bool writeResponse(const std::vector<uint8_t>& payload,
+                       std::vector<uint8_t>& out);
+
+    // Initiator: consume the response, completing the handshake
+    bool readResponse(const std::vector<uint8_t>& in,
+                      std::vector<uint8_t>& payload);
+
+    bool isComplete() const { return complete_; }
+    Role getRole() const { return role_; }
+
+    // Valid once the initiation has been written or read
+    const PublicKey& getRemoteStaticKey() const { return remote_static_; }
+
+    // Transport keys, valid once isComplete()
+    const SessionKey& getSendKey() const { return send_key_; }
+    const SessionKey& getReceiveKey() const { return receive_key_; }
+
+    // Channel binding value, identical on both sides once complete
+    const std::array<uint8_t, 32>& getHandshakeHash() const { return hash_; }
+
+private:
+    enum class Step {
+        Initiation,
+        Response,
+        Done,
+        Failed
+    };
+
+    void mixHash(const uint8_t* data, size_t len);
+    bool mixKey(const SharedSecret& dh);
+    bool encryptAndHash(const uint8_t* plaintext, size_t len, std::vector<uint8_t>& out);
+    bool decryptAndHash(const uint8_t* ciphertext, size_t len, std::vector<uint8_t>& out);
+    bool split();
+    bool fail();
+
+    Role role_;
+    Step step_ = Step::Initiation;
+    bool complete_ = false;
+
+    KeyPair static_key_;
+    KeyPair ephemeral_key_;
+    PublicKey remote_static_{};
+    PublicKey remote_ephemeral_{};
+
+    std::array<uint8_t, 32> chaining_key_{};
+    std::array<uint8_t, 32> hash_{};
+    SessionKey cipher_key_;
+    uint64_t nonce_ = 0;
+
+    SessionKey send_key_;
+    SessionKey receive_key_;
+};
+
+} // namespace mesh::crypto
+
+#endif // MESH_CRYPTO_NOISE_HPP
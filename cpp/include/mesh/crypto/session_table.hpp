@@ -0,0 +1,99 @@
+#ifndef MESH_CRYPTO_SESSION_TABLE_HPP
+#define MESH_CRYPTO_SESSION_TABLE_HPP
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#include "mesh/crypto/handshake.hpp"
+
+namespace mesh::crypto {
+
+class NoiseHandshake;
+
+// Session id carried in frame headers: low 16 bits index the table,
+// high 16 bits are a generation tag so ids of evicted sessions never
+// resolve to the slot's next occupant. Zero is never issued. The tag
+// wraps after 65535 reuses of one slot, so an id held across that many
+// evictions of its slot can alias a later session; callers must drop ids
+// once they see evict() or a failed lookup().
+using SessionId = uint32_t;
+
+constexpr SessionId kInvalidSessionId = 0;
+
+// Flat table of established sessions indexed directly by SessionId.
+//
+// Receive threads resolve a frame's session with lookup(), which never
+// blocks: each slot is a seqlock and readers retry only if they raced a
+// writer on that same slot. insert() and evict() may run concurrently from
+// any number of handshake threads; free slots are kept on a lock-free stack.
+class SessionTable {
+public:
+    using Key = std::array<uint8_t, 32>;
+
+    struct Entry {
+        PublicKey peer_key{};
+        Key send_key{};
+        Key receive_key{};
+    };
+
+    static constexpr size_t kMaxCapacity = 1u << 16;
+
+    explicit SessionTable(size_t capacity = 1024);
+    ~SessionTable();
+
+    SessionTable(const SessionTable&) = delete;
+    SessionTable& operator=(const SessionTable&) = delete;
+
+    // Returns kInvalidSessionId when the table is full
+    SessionId insert(const Entry& entry);
+    SessionId insert(const NoiseHandshake& handshake);
+
+    bool evict(SessionId id);
+
+    // Copies the session's cipher state; false for unknown or evicted ids
+    bool lookup(SessionId id, Entry& out) const;
+
+    // Reserves the next outbound nonce counter for the session; false for
+    // unknown ids, or if the session was evicted while reserving
+    bool nextSendCounter(SessionId id, uint64_t& counter);
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+    size_t capacity() const { return capacity_; }
+
+private:
+    static constexpr size_t kKeyWords = sizeof(Entry) / sizeof(uint64_t);
+    static constexpr uint32_t kEmptyStack = 0xFFFFFFFFu;
+
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> sequence{0};
+        std::atomic<uint32_t> tag{0};
+        std::atomic<uint64_t> send_counter{0};
+        std::array<std::atomic<uint64_t>, kKeyWords> words{};
+        uint16_t generation = 0;
+    };
+
+    static_assert(sizeof(Entry) % sizeof(uint64_t) == 0, "Entry must pack into 64-bit words");
+
+    static uint32_t indexOf(SessionId id) { return id & 0xFFFFu; }
+    static uint32_t tagOf(SessionId id) { return id >> 16; }
+
+    void lockSlot(Slot& slot);
+    void unlockSlot(Slot& slot);
+
+    bool popFree(uint32_t& index);
+    void pushFree(uint32_t index);
+
+    size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    std::unique_ptr<std::atomic<uint32_t>[]> next_free_;
+
+    // Treiber stack head: (aba counter << 32) | index
+    alignas(64) std::atomic<uint64_t> free_head_;
+    alignas(64) std::atomic<size_t> size_{0};
+};
+
+} // namespace mesh::crypto
+
+#endif // MESH_CRYPTO_SESSION_TABLE_HPP
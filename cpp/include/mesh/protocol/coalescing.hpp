@@ -0,0 +1,111 @@
+#ifndef MESH_PROTOCOL_COALESCING_HPP
+#define MESH_PROTOCOL_COALESCING_HPP
+
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh/protocol/message_view.hpp"
+
+namespace mesh::protocol {
+
+// Batch frame carrying several small encoded frames for one next hop:
+//   0  marker  u8   kBatchMarker
+//   1  count   u8
+//   then count x (varint length | frame bytes)
+// A batch of one is never sent; that frame goes out bare.
+constexpr uint8_t kBatchMarker = 0x81;
+constexpr size_t kBatchHeaderSize = 2;
+constexpr size_t kMaxBatchCount = 255;
+
+inline bool isBatch(const uint8_t* data, size_t len) {
+    return len >= kBatchHeaderSize && data[0] == kBatchMarker;
+}
+
+// Walks the frames of a batch in place
+class BatchReader {
+public:
+    bool reset(const uint8_t* data, size_t len);
+
+    // Next frame as a view into the batch; false at the end or on damage
+    bool next(ByteView& frame);
+
+    size_t count() const { return count_; }
+
+private:
+    const uint8_t* in_ = nullptr;
+    const uint8_t* end_ = nullptr;
+    size_t count_ = 0;
+    size_t remaining_ = 0;
+};
+
+// Nagle-style coalescing in front of per-peer sends.
+//
+// Small frames for the same next hop are packed into one batch, which is
+// flushed when it reaches max_batch_bytes, max_batch_count, or max_delay
+// after its first frame, whichever comes first. Frames above
+// max_message_bytes bypass the stage, after flushing anything queued for
+// that hop so ordering is kept. The owner calls poll() from its event
+// loop, using nextDeadline() to size its wait. Not thread-safe, and the
+// send callback must not call back into the coalescer.
+class Coalescer {
+public:
+    using Clock = std::chrono::steady_clock;
+    using SendFn = std::function<void(uint64_t next_hop, const uint8_t* frame, size_t len)>;
+
+    struct Config {
+        size_t max_batch_bytes = 1024;
+        size_t max_batch_count = 32;
+        size_t max_message_bytes = 256;
+        std::chrono::microseconds max_delay{500};
+    };
+
+    struct Stats {
+        uint64_t messages = 0;
+        uint64_t frames = 0;
+        uint64_t batches = 0;
+        uint64_t bypassed = 0;
+
+        // Below 1 when coalescing saves frames
+        double framesPerMessage() const {
+            return messages > 0 ? static_cast<double>(frames) / static_cast<double>(messages) : 0.0;
+        }
+    };
+
+    Coalescer(const Config& config, SendFn send);
+
+    void submit(uint64_t next_hop, const uint8_t* frame, size_t len, Clock::time_point now = Clock::now());
+
+    // Flushes batches whose deadline has passed
+    void poll(Clock::time_point now = Clock::now());
+
+    // Earliest pending deadline, or time_point::max() when idle
+    Clock::time_point nextDeadline() const;
+
+    void flush(uint64_t next_hop);
+    void flushAll();
+
+    const Stats& getStats() const { return stats_; }
+    const Config& getConfig() const { return config_; }
+
+private:
+    struct Batch {
+        std::vector<uint8_t> buffer;
+        size_t count = 0;
+        Clock::time_point deadline;
+    };
+
+    void emit(uint64_t next_hop, Batch& batch);
+
+    Config config_;
+    SendFn send_;
+    std::unordered_map<uint64_t, Batch> batches_;
+    Stats stats_;
+};
+
+} // namespace mesh::protocol
+
+#endif // MESH_PROTOCOL_COALESCING_HPP
@@ -0,0 +1,49 @@
+#ifndef MESH_PROTOCOL_COARSE_CLOCK_HPP
+#define MESH_PROTOCOL_COARSE_CLOCK_HPP
+
+#include <chrono>
+#include <cstdint>
+
+namespace mesh::protocol {
+
+// Cheap monotonic clock for expiry and queue-age decisions.
+//
+// now() reads CLOCK_MONOTONIC_COARSE (a few milliseconds of resolution,
+// served from the vDSO without a syscall on Linux), so it is always
+// current. Event loops that want to pay even less can tick() once per
+// iteration and read cached() in between; cached() is only as fresh as
+// that thread's last tick(), and reads the clock directly on a thread that
+// has never ticked. Wall-clock timestamps stay on system_clock and are for
+// display and the wire only.
+class CoarseClock {
+public:
+    using rep = int64_t;
+    using period = std::milli;
+    using duration = std::chrono::duration<rep, period>;
+    using time_point = std::chrono::time_point<CoarseClock, duration>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() { return time_point(duration(read())); }
+
+    // Refreshes this thread's cached reading and returns it
+    static time_point tick() {
+        cached_ = read();
+        return time_point(duration(cached_));
+    }
+
+    // This thread's reading as of its last tick()
+    static time_point cached() {
+        rep cached = cached_;
+        return time_point(duration(cached != 0 ? cached : read()));
+    }
+
+private:
+    // Never zero, which marks a thread that has not ticked
+    static rep read();
+
+    static inline thread_local rep cached_ = 0;
+};
+
+} // namespace mesh::protocol
+
+#endif // MESH_PROTOCOL_COARSE_CLOCK_HPP
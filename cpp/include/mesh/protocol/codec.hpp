@@ -0,0 +1,65 @@
+#ifndef MESH_PROTOCOL_CODEC_HPP
+#define MESH_PROTOCOL_CODEC_HPP
+
+#include <array>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh/protocol/message.hpp"
+#include "mesh/protocol/message_types.hpp"
+
+namespace mesh::protocol {
+
+// Binary wire format for Message, replacing JSON on the hot path.
+//
+// Fixed header (little endian):
+//   0   version      u8
+//   1   flags        u8     kFlagCompressed: content went through a
+//                              CompressionStage (compression.hpp)
+//   2   type_code    u8     well-known type (message_types.hpp), or 0 when
+//                              the type name follows in the variable part
+//   3   hop_count    u8     hops recorded, saturating at 255
+//   4   timestamp    u64    milliseconds since the Unix epoch
+//   12  id           16     MessageId, big endian
+//   28  from         32     node id
+//   60  to           32     node id
+//   92  hop_summary  u64    Bloom summary of every hop
+//   100 hops         16 x u32  most recent hop ids, oldest first, zero padded
+// Variable part:
+//   ttl (zigzag varint) | priority (varint) | [type name (varint len + bytes)]
+//   | content (varint len + bytes)
+//
+// The hop block is fixed size, so relays record themselves in place with
+// appendHop() and the frame never grows along the route.
+//
+// Node ids travel as 32 raw bytes. In Message they are 64-character hex
+// strings, with "broadcast" mapped to the all-ones id.
+using NodeId = std::array<uint8_t, 32>;
+
+constexpr uint8_t kWireVersion = 2;
+constexpr size_t kWireHeaderSize = 164;
+constexpr size_t kMaxVarintSize = 10;
+
+constexpr uint8_t kFlagCompressed = 0x01;
+
+extern const char kBroadcastId[];
+
+bool parseNodeId(const std::string& text, NodeId& id);
+std::string formatNodeId(const NodeId& id);
+
+// Bytes needed to encode the message; 0 if it cannot be encoded
+size_t encodedSize(const Message& message);
+
+// Encodes into a caller-provided buffer without allocating
+bool encodeMessage(const Message& message, uint8_t* buffer, size_t capacity, size_t& written);
+
+// Plain frames only; compressed frames decode through CompressionStage
+bool decodeMessage(const uint8_t* data, size_t len, Message& message);
+
+// Records a hop in an encoded frame without re-encoding or resizing it
+bool appendHop(uint8_t* frame, size_t len, HopId hop);
+
+} // namespace mesh::protocol
+
+#endif // MESH_PROTOCOL_CODEC_HPP
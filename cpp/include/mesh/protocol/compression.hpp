@@ -0,0 +1,103 @@
+#ifndef MESH_PROTOCOL_COMPRESSION_HPP
+#define MESH_PROTOCOL_COMPRESSION_HPP
+
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh/protocol/message.hpp"
+
+namespace mesh::protocol {
+
+// Codec ids carried in the first byte of compressed content
+constexpr uint8_t kCodecDeflate = 1;
+constexpr uint8_t kCodecChatDictionary = 2;
+
+// Built-in dictionary of common chat and control message text
+extern const std::string_view kChatDictionary;
+
+// One payload compression algorithm, identified on the wire by id().
+// Instances keep reusable compressor state and are not thread-safe.
+class PayloadCodec {
+public:
+    virtual ~PayloadCodec() = default;
+
+    virtual uint8_t id() const = 0;
+
+    // Appends the compressed form of data to out
+    virtual bool compress(const uint8_t* data, size_t len, std::vector<uint8_t>& out) = 0;
+
+    // Inflates into exactly out_len bytes
+    virtual bool decompress(const uint8_t* data, size_t len, uint8_t* out, size_t out_len) = 0;
+};
+
+// Raw deflate, optionally primed with a preset dictionary. A dictionary
+// lets the first bytes of a short message refer back to known text, which
+// is where generic compressors otherwise lose to the message itself.
+std::unique_ptr<PayloadCodec> makeDeflateCodec(uint8_t id = kCodecDeflate,
+                                               std::string_view dictionary = {},
+                                               int level = 6);
+
+// Optional compression stage on the encode/decode path.
+//
+// compressFrame() rewrites the content of an encoded frame and sets
+// kFlagCompressed; everything else in the frame is untouched, so relays
+// inspect and stamp compressed frames exactly like plain ones and never
+// decompress. Content below min_size, or that does not shrink, is left
+// alone. Content up to dictionary_max_size goes through the dictionary
+// codec, larger content through plain deflate.
+//
+// Compressed content: codec id (u8) | original size (varint) | codec output
+//
+// Holds per-codec scratch state: use one stage per thread.
+class CompressionStage {
+public:
+    struct Config {
+        size_t min_size = 24;
+        size_t dictionary_max_size = 256;
+        size_t max_content_size = 1 << 20;
+    };
+
+    // Registers deflate and the built-in chat dictionary codec
+    CompressionStage();
+    explicit CompressionStage(const Config& config);
+    ~CompressionStage();
+
+    // Adds or replaces a codec; both ends must register the same ids
+    void registerCodec(std::unique_ptr<PayloadCodec> codec);
+    void setSmallCodec(uint8_t id) { small_codec_ = id; }
+    void setLargeCodec(uint8_t id) { large_codec_ = id; }
+
+    // Writes the frame to out, compressed if it pays off. Returns false only
+    // on malformed input; wasCompressed tells whether the flag was set.
+    bool compressFrame(const uint8_t* frame, size_t len, std::vector<uint8_t>& out,
+                       bool* wasCompressed = nullptr);
+
+    // Writes the plain form of a frame; plain frames are copied as-is
+    bool decompressFrame(const uint8_t* frame, size_t len, std::vector<uint8_t>& out);
+
+    // Encodes a message through the stage
+    bool encode(const Message& message, std::vector<uint8_t>& out);
+
+    // Decodes a frame, compressed or not
+    bool decode(const uint8_t* frame, size_t len, Message& message);
+
+    const Config& getConfig() const { return config_; }
+
+private:
+    PayloadCodec* findCodec(uint8_t id) const;
+
+    Config config_;
+    std::array<std::unique_ptr<PayloadCodec>, 256> codecs_;
+    uint8_t small_codec_ = kCodecChatDictionary;
+    uint8_t large_codec_ = kCodecDeflate;
+    std::vector<uint8_t> scratch_;
+};
+
+} // namespace mesh::protocol
+
+#endif // MESH_PROTOCOL_COMPRESSION_HPP
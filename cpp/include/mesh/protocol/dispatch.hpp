@@ -0,0 +1,109 @@
+#ifndef MESH_PROTOCOL_DISPATCH_HPP
+#define MESH_PROTOCOL_DISPATCH_HPP
+
+#include <array>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh/protocol/message_types.hpp"
+#include "mesh/protocol/message_view.hpp"
+
+namespace mesh::protocol {
+
+// Binds a handler to a type tag from message_types.hpp
+template <typename Tag, typename Fn>
+struct Handler {
+    using tag_type = Tag;
+    Fn fn;
+};
+
+template <typename Tag, typename Fn>
+constexpr Handler<Tag, std::decay_t<Fn>> on(Fn&& fn) {
+    return {std::forward<Fn>(fn)};
+}
+
+// Routes frames to handlers by the type code in the binary header.
+//
+// The handler set is fixed at compile time. A 256-entry table of
+// per-handler thunks is generated as a constant, so dispatch is one index
+// and one call whatever the number of types. Handlers must be callable as
+// void(const MessageView&, Context&); a wrong signature, a named (code 0)
+// tag or two handlers for one tag fail to compile.
+//
+//   auto dispatcher = makeDispatcher<Node>(
+//       on<types::Chat>([](const MessageView& view, Node& node) { ... }),
+//       on<types::Ack>(AckHandler{}));
+//   dispatcher.dispatch(view, node);
+template <typename Context, typename... Handlers>
+class Dispatcher {
+public:
+    static_assert(sizeof...(Handlers) > 0, "a dispatcher needs at least one handler");
+    static_assert((std::is_invocable_r_v<void, const decltype(Handlers::fn)&, const MessageView&, Context&> && ...),
+                  "handlers must be callable as void(const MessageView&, Context&)");
+    static_assert(((Handlers::tag_type::kCode != kNamedTypeCode) && ...),
+                  "named types have no code to dispatch on");
+
+    constexpr explicit Dispatcher(Handlers... handlers) : handlers_(std::move(handlers)...) {
+        static_assert(uniqueCodes(), "each message type may have only one handler");
+    }
+
+    // False when no handler is registered for the frame's type code
+    bool dispatch(const MessageView& view, Context& context) const {
+        static constexpr std::array<Thunk, 256> table = makeTable(std::index_sequence_for<Handlers...>{});
+        return table[view.typeCode()](*this, view, context);
+    }
+
+    template <typename Tag>
+    static constexpr bool handles() {
+        return ((Tag::kCode == Handlers::tag_type::kCode) || ...);
+    }
+
+private:
+    using Thunk = bool (*)(const Dispatcher&, const MessageView&, Context&);
+
+    template <size_t I>
+    static bool invoke(const Dispatcher& self, const MessageView& view, Context& context) {
+        std::get<I>(self.handlers_).fn(view, context);
+        return true;
+    }
+
+    static bool unhandled(const Dispatcher&, const MessageView&, Context&) {
+        return false;
+    }
+
+    static constexpr bool uniqueCodes() {
+        constexpr uint8_t codes[] = {Handlers::tag_type::kCode...};
+        for (size_t i = 0; i < sizeof...(Handlers); ++i) {
+            for (size_t j = i + 1; j < sizeof...(Handlers); ++j) {
+                if (codes[i] == codes[j]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    template <size_t... I>
+    static constexpr std::array<Thunk, 256> makeTable(std::index_sequence<I...>) {
+        std::array<Thunk, 256> table{};
+        for (auto& entry : table) {
+            entry = &unhandled;
+        }
+        ((table[Handlers::tag_type::kCode] = &invoke<I>), ...);
+        return table;
+    }
+
+    std::tuple<Handlers...> handlers_;
+};
+
+template <typename Context, typename... Handlers>
+constexpr Dispatcher<Context, Handlers...> makeDispatcher(Handlers... handlers) {
+    return Dispatcher<Context, Handlers...>(std::move(handlers)...);
+}
+
+} // namespace mesh::protocol
+
+#endif // MESH_PROTOCOL_DISPATCH_HPP
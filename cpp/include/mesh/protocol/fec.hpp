@@ -0,0 +1,224 @@
+#ifndef MESH_PROTOCOL_FEC_HPP
+#define MESH_PROTOCOL_FEC_HPP
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh/protocol/coarse_clock.hpp"
+
+namespace mesh::protocol {
+
+// GF(2^8) arithmetic over x^8 + x^4 + x^3 + x^2 + 1 (0x11d)
+namespace gf256 {
+
+uint8_t mul(uint8_t a, uint8_t b);
+uint8_t inv(uint8_t a);
+
+// dst[i] ^= c * src[i]; split 4-bit tables with PSHUFB on CPUs that have
+// SSSE3 (checked at run time), otherwise one product table lookup per byte
+void mulAddRegion(uint8_t* dst, const uint8_t* src, uint8_t c, size_t len);
+
+// The two kernels behind mulAddRegion. The SSSE3 one returns false, leaving
+// dst untouched, where the CPU or target lacks it.
+void mulAddRegionScalar(uint8_t* dst, const uint8_t* src, uint8_t c, size_t len);
+bool mulAddRegionSsse3(uint8_t* dst, const uint8_t* src, uint8_t c, size_t len);
+
+} // namespace gf256
+
+// Forward error correction for large frames on lossy links.
+//
+// A frame is cut into k equal data shards (the last zero padded) and m
+// parity shards from a systematic Reed-Solomon code with a Cauchy
+// generator, so any k of the n = k + m shards rebuild the frame without a
+// round trip. Data shards carry the frame bytes unchanged; when they all
+// arrive nothing is decoded.
+//
+// Shard header (9 bytes, little endian):
+//   0  marker   u8   kFecMarker, never a valid wire version
+//   1  stream   u16  per-sender stream id
+//   3  index    u8   0..k-1 data, k..n-1 parity
+//   4  k        u8   data shards
+//   5  n        u8   total shards, k..255
+//   6  total    u24  length of the original frame
+constexpr uint8_t kFecMarker = 0x82;
+constexpr size_t kFecHeaderSize = 9;
+constexpr size_t kMaxFecShards = 255;
+constexpr size_t kMaxFecFrameSize = (1u << 24) - 1;
+
+inline bool isFecShard(const uint8_t* data, size_t len) {
+    return len >= kFecHeaderSize && data[0] == kFecMarker;
+}
+
+// Exponentially weighted shard loss rate for one link, fed from acks or
+// from gaps in received shard indices
+class LossEstimator {
+public:
+    explicit LossEstimator(double alpha = 0.125) : alpha_(alpha) {}
+
+    void record(size_t sent, size_t lost);
+
+    double lossRate() const { return loss_rate_; }
+
+private:
+    double alpha_;
+    double loss_rate_ = 0.0;
+};
+
+class FecEncoder {
+public:
+    struct Config {
+        // Acceptable chance that more than m of the n shards are lost
+        double target_failure = 1e-3;
+        size_t min_parity = 0;
+        size_t max_parity = 64;
+    };
+
+    explicit FecEncoder(size_t mtu);
+    FecEncoder(size_t mtu, const Config& config);
+
+    // Data shards for a frame of len bytes; 0 if it cannot be sent
+    size_t dataShardCount(size_t len) const;
+
+    // Fewest parity shards meeting target_failure at the given loss rate,
+    // within [min_parity, max_parity] and the 255 shard limit
+    size_t parityShardCount(size_t data_shards, double loss_rate) const;
+
+    uint16_t nextStreamId() { return next_stream_++; }
+
+    // Writes all n shards, each at most mtu bytes, reusing the buffers in
+    // shards. Returns n, or 0 if the frame cannot be sent.
+    size_t encode(const uint8_t* frame, size_t len, uint16_t stream, double loss_rate,
+                  std::vector<std::vector<uint8_t>>& shards);
+
+    size_t getMtu() const { return mtu_; }
+    const Config& getConfig() const { return config_; }
+
+private:
+    size_t mtu_;
+    Config config_;
+    uint16_t next_stream_ = 0;
+};
+
+// Rebuilds frames from any k shards of a stream, from many senders.
+//
+// Data shards are copied straight to their place in the output buffer and
+// parity shards are kept aside. Once k shards are in, the missing data
+// shards are solved from the parity syndromes with the inverse of a
+// Cauchy submatrix, and the buffer is handed over by move. Memory is
+// reserved against a budget as in Reassembler. The last few completed or
+// evicted streams of each source are remembered until their deadline, so
+// surplus shards are dropped as duplicates instead of opening a new
+// stream; a shard whose k, n or total differ starts a new stream under a
+// wrapped id instead.
+class FecDecoder {
+public:
+    enum class Result {
+        Incomplete,
+        Complete,
+        Duplicate,
+        Invalid,
+        OverBudget
+    };
+
+    struct Config {
+        size_t memory_budget = 512 * 1024;
+        CoarseClock::duration timeout = std::chrono::seconds(5);
+    };
+
+    struct Stats {
+        uint64_t completed = 0;
+        uint64_t recovered = 0;     // completed with parity standing in for lost data
+        uint64_t duplicates = 0;
+        uint64_t invalid = 0;
+        uint64_t expired = 0;
+        uint64_t evicted = 0;
+        size_t partial_streams = 0;
+        size_t finished_streams = 0;    // remembered to catch late shards
+        size_t reserved_bytes = 0;
+    };
+
+    FecDecoder();
+    explicit FecDecoder(const Config& config);
+
+    // source identifies the sending link or peer; stream ids are only
+    // unique per source. On Complete, frame holds the original bytes.
+    Result receive(uint64_t source, const uint8_t* shard, size_t len, std::vector<uint8_t>& frame);
+
+    // Hands a completed frame's buffer back for reuse by later streams
+    void recycle(std::vector<uint8_t>&& buffer);
+
+    // Forgets streams whose deadline has passed; returns how many were
+    // still incomplete
+    size_t sweep(CoarseClock::time_point now = CoarseClock::now());
+
+    Stats getStats() const;
+
+private:
+    static constexpr size_t kMaxSpareBuffers = 8;
+    // Finished streams remembered per source, beyond which the oldest is
+    // forgotten; far below the 65536 ids a sender cycles through
+    static constexpr size_t kMaxFinishedPerSource = 32;
+
+    struct StreamKey {
+        uint64_t source;
+        uint16_t stream;
+
+        bool operator==(const StreamKey& other) const {
+            return source == other.source && stream == other.stream;
+        }
+    };
+
+    struct StreamKeyHash {
+        size_t operator()(const StreamKey& key) const {
+            return static_cast<size_t>((key.source * 0x9E3779B97F4A7C15ull) ^ key.stream);
+        }
+    };
+
+    struct Partial {
+        std::vector<uint8_t> data;      // k shards in place, becomes the frame
+        std::vector<uint8_t> parity;    // up to min(k, n - k) shards as received
+        std::vector<uint8_t> parity_rows;
+        std::array<uint64_t, 4> received{};
+        size_t reserved = 0;
+        size_t total = 0;
+        size_t shard_size = 0;
+        uint8_t k = 0;
+        uint8_t n = 0;
+        uint8_t have = 0;
+        bool done = false;
+        CoarseClock::time_point deadline;
+        // Tells a reopened stream id from the stream it replaced
+        uint64_t generation = 0;
+    };
+
+    struct Finished {
+        uint16_t stream;
+        uint64_t generation;
+    };
+
+    using PartialMap = std::unordered_map<StreamKey, Partial, StreamKeyHash>;
+
+    bool reserve(size_t bytes, CoarseClock::time_point now);
+    // Frees the buffers and leaves the entry as a finished stream
+    void release(const StreamKey& key, Partial& partial);
+    void recover(Partial& partial);
+
+    Config config_;
+    PartialMap partials_;
+    // Streams per source in the order they finished; may hold streams that
+    // sweep() or a reopened id has already replaced
+    std::unordered_map<uint64_t, std::deque<Finished>> finished_;
+    uint64_t next_generation_ = 0;
+    size_t reserved_ = 0;
+    std::vector<std::vector<uint8_t>> spare_buffers_;
+    Stats stats_;
+};
+
+} // namespace mesh::protocol
+
+#endif // MESH_PROTOCOL_FEC_HPP
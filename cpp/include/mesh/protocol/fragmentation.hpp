@@ -0,0 +1,149 @@
+#ifndef MESH_PROTOCOL_FRAGMENTATION_HPP
+#define MESH_PROTOCOL_FRAGMENTATION_HPP
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh/protocol/coarse_clock.hpp"
+
+namespace mesh::protocol {
+
+// Link-layer fragmentation for encoded frames on small-MTU links (BLE).
+//
+// Fragment header (8 bytes, little endian):
+//   0  marker   u8   kFragmentMarker, never a valid wire version
+//   1  stream   u16  per-sender stream id
+//   3  index    u8
+//   4  count    u8   fragments in the stream, 1..255
+//   5  total    u24  length of the reassembled frame
+//
+// Every fragment but the last carries ceil(total / count) bytes, so the
+// receiver can place any fragment without having seen the others. Frames
+// that fit in one MTU should go out unfragmented; isFragment() tells the
+// two apart on receive.
+constexpr uint8_t kFragmentMarker = 0x80;
+constexpr size_t kFragmentHeaderSize = 8;
+constexpr size_t kMaxFragmentCount = 255;
+constexpr size_t kMaxFragmentedSize = (1u << 24) - 1;
+
+// ATT payload with BLE data length extension
+constexpr size_t kBleDefaultMtu = 244;
+
+inline bool isFragment(const uint8_t* data, size_t len) {
+    return len >= kFragmentHeaderSize && data[0] == kFragmentMarker;
+}
+
+class Fragmenter {
+public:
+    explicit Fragmenter(size_t mtu);
+
+    // Fragments needed for a frame of len bytes; 0 if it cannot be sent
+    size_t fragmentCount(size_t len) const;
+
+    uint16_t nextStreamId() { return next_stream_++; }
+
+    // Writes fragment index of the frame into out (at least mtu bytes)
+    // and returns its size, or 0 on bad arguments
+    size_t writeFragment(const uint8_t* frame, size_t len, uint16_t stream, size_t index,
+                         uint8_t* out) const;
+
+    size_t getMtu() const { return mtu_; }
+
+private:
+    size_t mtu_;
+    uint16_t next_stream_ = 0;
+};
+
+// Reassembles fragment streams from many senders.
+//
+// The first fragment of a stream reserves a buffer of the final frame size
+// against a fixed memory budget, and each fragment is copied straight to
+// its offset; a completed frame is handed over by moving that buffer, so
+// payload bytes are copied exactly once. A 256-bit bitmap per stream drops
+// duplicates. Streams that stall past the timeout are reclaimed by
+// sweep(); when a new stream does not fit the budget, the oldest partial
+// streams are evicted first.
+class Reassembler {
+public:
+    static constexpr size_t kMaxSpareBuffers = 8;
+
+    enum class Result {
+        Incomplete,
+        Complete,
+        Duplicate,
+        Invalid,
+        OverBudget
+    };
+
+    struct Config {
+        size_t memory_budget = 256 * 1024;
+        CoarseClock::duration timeout = std::chrono::seconds(5);
+    };
+
+    struct Stats {
+        uint64_t completed = 0;
+        uint64_t duplicates = 0;
+        uint64_t invalid = 0;
+        uint64_t expired = 0;
+        uint64_t evicted = 0;
+        size_t partial_streams = 0;
+        size_t reserved_bytes = 0;
+    };
+
+    Reassembler();
+    explicit Reassembler(const Config& config);
+
+    // source identifies the sending link or peer; stream ids are only
+    // unique per source. On Complete, frame holds the reassembled bytes.
+    Result receive(uint64_t source, const uint8_t* fragment, size_t len,
+                   std::vector<uint8_t>& frame);
+
+    // Hands a completed frame's buffer back for reuse by later streams
+    void recycle(std::vector<uint8_t>&& buffer);
+
+    // Drops streams whose deadline has passed; returns how many
+    size_t sweep(CoarseClock::time_point now = CoarseClock::now());
+
+    Stats getStats() const;
+
+private:
+    struct StreamKey {
+        uint64_t source;
+        uint16_t stream;
+
+        bool operator==(const StreamKey& other) const {
+            return source == other.source && stream == other.stream;
+        }
+    };
+
+    struct StreamKeyHash {
+        size_t operator()(const StreamKey& key) const {
+            return static_cast<size_t>((key.source * 0x9E3779B97F4A7C15ull) ^ key.stream);
+        }
+    };
+
+    struct Partial {
+        std::vector<uint8_t> buffer;
+        size_t reserved = 0;
+        std::array<uint64_t, 4> received{};
+        uint8_t count = 0;
+        uint8_t remaining = 0;
+        CoarseClock::time_point deadline;
+    };
+
+    bool reserve(size_t bytes, CoarseClock::time_point now);
+    void release(std::unordered_map<StreamKey, Partial, StreamKeyHash>::iterator it);
+
+    Config config_;
+    std::unordered_map<StreamKey, Partial, StreamKeyHash> partials_;
+    size_t reserved_ = 0;
+    std::vector<std::vector<uint8_t>> spare_buffers_;
+    Stats stats_;
+};
+
+} // namespace mesh::protocol
+
+#endif // MESH_PROTOCOL_FRAGMENTATION_HPP
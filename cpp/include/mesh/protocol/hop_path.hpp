@@ -0,0 +1,114 @@
+#ifndef MESH_PROTOCOL_HOP_PATH_HPP
+#define MESH_PROTOCOL_HOP_PATH_HPP
+
+#include <array>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace mesh::protocol {
+
+// Compact hop identifier: 32-bit FNV-1a hash of a node id
+using HopId = uint32_t;
+
+inline HopId makeHopId(std::string_view node_id) {
+    uint32_t hash = 2166136261u;
+    for (char c : node_id) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Fixed-size record of the hops a message has taken.
+//
+// Keeps the most recent kCapacity hop ids plus a 64-bit Bloom summary of
+// every hop, so the encoded size never grows with path length. Loop checks
+// are O(1): the summary rules out unvisited nodes with one mask test, and
+// only possible matches scan the bounded hop list. Hops that fell out of the
+// list are known only through the summary and may report false positives.
+class HopPath {
+public:
+    static constexpr size_t kCapacity = 16;
+
+    // Records a hop; once full, the oldest entry is dropped from the list
+    void append(HopId hop) {
+        hops_[head_] = hop;
+        head_ = static_cast<uint8_t>((head_ + 1) % kCapacity);
+        if (total_ < UINT8_MAX) {
+            ++total_;
+        }
+        summary_ |= summaryBits(hop);
+    }
+
+    bool contains(HopId hop) const {
+        uint64_t bits = summaryBits(hop);
+        if ((summary_ & bits) != bits) {
+            return false;
+        }
+        for (size_t i = 0; i < size(); ++i) {
+            if (hops_[i] == hop) {
+                return true;
+            }
+        }
+        return overflowed();
+    }
+
+    // Hop ids still held in the list, oldest first
+    HopId at(size_t index) const {
+        size_t start = size() == kCapacity ? head_ : 0;
+        return hops_[(start + index) % kCapacity];
+    }
+
+    size_t size() const { return total_ < kCapacity ? total_ : kCapacity; }
+    bool empty() const { return total_ == 0; }
+    bool overflowed() const { return total_ > kCapacity; }
+
+    // Number of hops ever recorded, saturating at 255
+    size_t totalHops() const { return total_; }
+    uint64_t summary() const { return summary_; }
+
+    void clear() { *this = HopPath(); }
+
+    // Rebuilds a path from its wire form: held hops oldest first
+    bool restore(const HopId* hops, size_t count, uint8_t total, uint64_t summary) {
+        if (count > kCapacity || count != (total < kCapacity ? total : kCapacity)) {
+            return false;
+        }
+        *this = HopPath();
+        for (size_t i = 0; i < count; ++i) {
+            hops_[i] = hops[i];
+        }
+        head_ = static_cast<uint8_t>(count % kCapacity);
+        total_ = total;
+        summary_ = summary;
+        return true;
+    }
+
+    bool operator==(const HopPath& other) const {
+        if (total_ != other.total_ || summary_ != other.summary_) {
+            return false;
+        }
+        for (size_t i = 0; i < size(); ++i) {
+            if (at(i) != other.at(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool operator!=(const HopPath& other) const { return !(*this == other); }
+
+    static uint64_t summaryBits(HopId hop) {
+        return (uint64_t(1) << (hop & 63)) | (uint64_t(1) << ((hop >> 6) & 63));
+    }
+
+private:
+    std::array<HopId, kCapacity> hops_{};
+    uint8_t head_ = 0;
+    uint8_t total_ = 0;
+    uint64_t summary_ = 0;
+};
+
+} // namespace mesh::protocol
+
+#endif // MESH_PROTOCOL_HOP_PATH_HPP
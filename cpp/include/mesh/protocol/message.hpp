@@ -6,6 +6,10 @@
 #include <chrono>
 #include <cstdint>
 
+#include "mesh/protocol/coarse_clock.hpp"
+#include "mesh/protocol/hop_path.hpp"
+#include "mesh/protocol/message_id.hpp"
+
 namespace mesh::protocol {
 
 enum class MessagePriority {
@@ -15,21 +19,28 @@ enum class MessagePriority {
 };
 
 struct Message {
-    std::string id;
+    MessageId id;
     std::string from_id;
     std::string to_id;
     std::string content;
+    // Wall-clock creation time, for display and the wire
     std::chrono::system_clock::time_point timestamp;
+    // Local monotonic deadline; never sent, max() means no age limit
+    CoarseClock::time_point expires_at = CoarseClock::time_point::max();
     int32_t ttl = 10;
-    std::vector<std::string> path;
+    HopPath path;
     MessagePriority priority = MessagePriority::Normal;
     std::string type;
     
     Message() = default;
     Message(const std::string& to, const std::string& content, MessagePriority prio = MessagePriority::Normal);
     
-    bool isExpired() const;
-    void decrementTTL();
+    // One coarse clock read and a compare; queue scans read the clock once
+    // and pass it to the overload
+    bool isExpired() const { return isExpired(CoarseClock::now()); }
+    bool isExpired(CoarseClock::time_point now) const { return ttl <= 0 || now >= expires_at; }
+    void setMaxAge(CoarseClock::duration age) { expires_at = CoarseClock::now() + age; }
+    void decrementTTL() { --ttl; }
 };
 
 } // namespace mesh::protocol
@@ -0,0 +1,94 @@
+#ifndef MESH_PROTOCOL_MESSAGE_TYPES_HPP
+#define MESH_PROTOCOL_MESSAGE_TYPES_HPP
+
+#include <array>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+namespace mesh::protocol {
+
+// Well-known message types as compile-time tags. Each carries the compact
+// code sent in header byte 2 (type_code) instead of the type name, and the
+// name used in Message::type. Codes 1-4 are mesh_message_type_t + 1.
+// Code 0 means the name travels in the frame; new types take the next code.
+namespace types {
+
+struct Data {
+    static constexpr uint8_t kCode = 1;
+    static constexpr std::string_view kName = "data";
+};
+
+struct Control {
+    static constexpr uint8_t kCode = 2;
+    static constexpr std::string_view kName = "control";
+};
+
+struct Discovery {
+    static constexpr uint8_t kCode = 3;
+    static constexpr std::string_view kName = "discovery";
+};
+
+struct Encrypted {
+    static constexpr uint8_t kCode = 4;
+    static constexpr std::string_view kName = "encrypted";
+};
+
+struct Chat {
+    static constexpr uint8_t kCode = 5;
+    static constexpr std::string_view kName = "chat";
+};
+
+struct Ack {
+    static constexpr uint8_t kCode = 6;
+    static constexpr std::string_view kName = "ack";
+};
+
+struct Heartbeat {
+    static constexpr uint8_t kCode = 7;
+    static constexpr std::string_view kName = "heartbeat";
+};
+
+struct Typing {
+    static constexpr uint8_t kCode = 8;
+    static constexpr std::string_view kName = "typing";
+};
+
+} // namespace types
+
+constexpr uint8_t kNamedTypeCode = 0;
+constexpr uint8_t kMaxTypeCode = types::Typing::kCode;
+
+namespace detail {
+
+template <typename... Tags>
+constexpr std::array<std::string_view, kMaxTypeCode + 1> makeTypeNames() {
+    std::array<std::string_view, kMaxTypeCode + 1> names{};
+    ((names[Tags::kCode] = Tags::kName), ...);
+    return names;
+}
+
+constexpr auto kTypeNames = makeTypeNames<types::Data, types::Control, types::Discovery,
+                                          types::Encrypted, types::Chat, types::Ack,
+                                          types::Heartbeat, types::Typing>();
+
+} // namespace detail
+
+// Name for a code; empty for 0 and unknown codes
+constexpr std::string_view typeName(uint8_t code) {
+    return code <= kMaxTypeCode ? detail::kTypeNames[code] : std::string_view();
+}
+
+// Code for a well-known name; kNamedTypeCode when the name must be sent
+constexpr uint8_t typeCode(std::string_view name) {
+    for (uint8_t code = 1; code <= kMaxTypeCode; ++code) {
+        if (detail::kTypeNames[code] == name) {
+            return code;
+        }
+    }
+    return kNamedTypeCode;
+}
+
+} // namespace mesh::protocol
+
+#endif // MESH_PROTOCOL_MESSAGE_TYPES_HPP
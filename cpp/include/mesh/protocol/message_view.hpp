@@ -0,0 +1,84 @@
+#ifndef MESH_PROTOCOL_MESSAGE_VIEW_HPP
+#define MESH_PROTOCOL_MESSAGE_VIEW_HPP
+
+#include <chrono>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh/protocol/codec.hpp"
+
+namespace mesh::protocol {
+
+// Non-owning pointer/length pair over bytes inside a receive buffer
+struct ByteView {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    const uint8_t* begin() const { return data; }
+    const uint8_t* end() const { return data + size; }
+    bool empty() const { return size == 0; }
+};
+
+// Zero-copy reader over an encoded message.
+//
+// parse() validates the whole frame in place and records field offsets;
+// accessors then return views into the caller's buffer, which must outlive
+// the view. A relay can check TTL and destination and forward the frame
+// without building a Message or copying the payload.
+class MessageView {
+public:
+    MessageView() = default;
+
+    bool parse(const uint8_t* data, size_t len);
+
+    bool isValid() const { return data_ != nullptr; }
+
+    uint8_t version() const { return data_[0]; }
+    uint8_t flags() const { return data_[1]; }
+    bool isCompressed() const { return (data_[1] & kFlagCompressed) != 0; }
+    uint8_t typeCode() const { return data_[2]; }
+    uint64_t timestampMillis() const;
+    std::chrono::system_clock::time_point timestamp() const;
+
+    ByteView id() const { return {data_ + 12, 16}; }
+    MessageId messageId() const { return MessageId::fromBytes(data_ + 12); }
+    ByteView fromId() const;
+    ByteView toId() const;
+    bool isBroadcast() const;
+    bool isAddressedTo(const NodeId& node) const;
+
+    int32_t ttl() const { return ttl_; }
+    MessagePriority priority() const { return priority_; }
+    // Empty for codes newer than this build knows
+    std::string_view type() const;
+    std::string_view content() const;
+    ByteView contentBytes() const { return {data_ + content_offset_, content_size_}; }
+
+    // Loop check straight from the fixed hop block; same rules as HopPath
+    size_t hopCount() const { return data_[3]; }
+    bool hasVisited(HopId hop) const;
+    HopPath hopPath() const;
+
+    // The whole encoded frame, for forwarding as-is
+    ByteView frame() const { return {data_, size_}; }
+
+    // Decodes into an owning Message when the full object is needed.
+    // Fails on compressed frames, whose content() is still compressed.
+    bool toMessage(Message& message) const;
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+
+    int32_t ttl_ = 0;
+    MessagePriority priority_ = MessagePriority::Normal;
+    size_t type_offset_ = 0;
+    size_t type_size_ = 0;
+    size_t content_offset_ = 0;
+    size_t content_size_ = 0;
+};
+
+} // namespace mesh::protocol
+
+#endif // MESH_PROTOCOL_MESSAGE_VIEW_HPP
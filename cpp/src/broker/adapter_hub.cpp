@@ -0,0 +1,159 @@
+#include "mesh/broker/adapter_hub.hpp"
+#include "mesh/protocol/codec.hpp"
+#include <utility>
+
+namespace mesh::broker {
+
+using protocol::CoarseClock;
+using protocol::Message;
+
+AdapterHub::AdapterHub(std::string local_id, DeliverFn deliver_local,
+                       const MessageQueue::Config& queue_config)
+    : local_id_(std::move(local_id)),
+      local_hop_(protocol::makeHopId(local_id_)),
+      deliver_local_(std::move(deliver_local)),
+      queue_config_(queue_config) {}
+
+AdapterHub::~AdapterHub() {
+    stop();
+}
+
+size_t AdapterHub::addAdapter(std::unique_ptr<Adapter> adapter) {
+    adapters_.push_back(std::make_unique<Slot>(std::move(adapter), queue_config_));
+    return adapters_.size() - 1;
+}
+
+bool AdapterHub::start() {
+    if (running_.load() || adapters_.empty()) {
+        return false;
+    }
+    stop_event_.drain();
+    running_ = true;
+    for (auto& slot : adapters_) {
+        slot->thread = std::thread([this, raw = slot.get()] { run(*raw); });
+    }
+    return true;
+}
+
+void AdapterHub::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    // Left readable so every I/O thread sees it
+    stop_event_.notify();
+    for (auto& slot : adapters_) {
+        if (slot->thread.joinable()) {
+            slot->thread.join();
+        }
+    }
+}
+
+void AdapterHub::setRoute(const std::string& peer_id, size_t adapter) {
+    routes_.update([&](auto& routes) { routes[peer_id] = adapter; });
+}
+
+void AdapterHub::removeRoute(const std::string& peer_id) {
+    routes_.update([&](auto& routes) { routes.erase(peer_id); });
+}
+
+bool AdapterHub::route(Message message, size_t from) {
+    if (from != kLocal) {
+        if (from < adapters_.size()) {
+            adapters_[from]->counters.add(kReceived);
+        }
+        if (message.path.contains(local_hop_)) {
+            loops_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    // Local senders may leave to_id empty; on the wire it is kBroadcastId
+    if (message.to_id.empty()) {
+        message.to_id = protocol::kBroadcastId;
+    }
+    bool broadcast = message.to_id == protocol::kBroadcastId;
+    if (message.to_id == local_id_ || (broadcast && from != kLocal)) {
+        deliver_local_(message);
+        if (!broadcast) {
+            return true;
+        }
+    }
+
+    if (from != kLocal) {
+        message.decrementTTL();
+        if (message.isExpired(CoarseClock::tick())) {
+            return false;
+        }
+    }
+    message.path.append(local_hop_);
+
+    if (!broadcast) {
+        auto routes = routes_.load();
+        auto it = routes->value.find(message.to_id);
+        if (it != routes->value.end() && it->second < adapters_.size()) {
+            return enqueue(*adapters_[it->second], std::move(message));
+        }
+    }
+
+    // Broadcast, or no route yet: every adapter but the one it came from
+    size_t last = adapters_.size();
+    for (size_t i = adapters_.size(); i-- > 0;) {
+        if (i != from) {
+            last = i;
+            break;
+        }
+    }
+    bool queued = false;
+    for (size_t i = 0; i < last; ++i) {
+        if (i != from) {
+            queued |= enqueue(*adapters_[i], Message(message));
+        }
+    }
+    if (last < adapters_.size()) {
+        queued |= enqueue(*adapters_[last], std::move(message));
+    }
+    return queued;
+}
+
+bool AdapterHub::enqueue(Slot& slot, Message&& message) {
+    if (!slot.queue.push(std::move(message))) {
+        slot.counters.add(kDropped);
+        return false;
+    }
+    return true;
+}
+
+void AdapterHub::run(Slot& slot) {
+    std::vector<Message> batch(32);
+    while (running_.load(std::memory_order_relaxed)) {
+        // Keeps CoarseClock::cached() current for the adapter's send path
+        CoarseClock::tick();
+        size_t count = slot.queue.popBatch(batch.data(), batch.size());
+        for (size_t i = 0; i < count; ++i) {
+            slot.counters.add(slot.adapter->send(batch[i]) ? kSent : kFailed);
+        }
+        if (count == 0 && slot.queue.prepareWait()) {
+            waitReadable({slot.queue.wakeFd(), stop_event_.fd()});
+            slot.queue.finishWait();
+        }
+    }
+}
+
+std::vector<AdapterHub::AdapterStats> AdapterHub::getStats() const {
+    std::vector<AdapterStats> stats;
+    stats.reserve(adapters_.size());
+    for (const auto& slot : adapters_) {
+        auto counters = slot->counters.readAll();
+        AdapterStats entry;
+        entry.name = slot->adapter->name();
+        entry.queued = slot->queue.size();
+        entry.received = counters[kReceived];
+        entry.sent = counters[kSent];
+        entry.failed = counters[kFailed];
+        entry.dropped = counters[kDropped];
+        stats.push_back(std::move(entry));
+    }
+    return stats;
+}
+
+} // namespace mesh::broker
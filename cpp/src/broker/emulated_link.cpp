@@ -0,0 +1,119 @@
+#include "mesh/broker/emulated_link.hpp"
+#include "mesh/protocol/codec.hpp"
+#include <utility>
+
+namespace mesh::broker {
+
+using protocol::Message;
+
+class EmulatedLink::EndAdapter : public Adapter {
+public:
+    EndAdapter(EmulatedLink& link, End end, std::string name)
+        : link_(link), end_(end), name_(std::move(name)) {}
+
+    std::string name() const override { return name_; }
+
+    bool send(const Message& message) override {
+        return link_.transmit(end_, message);
+    }
+
+private:
+    EmulatedLink& link_;
+    End end_;
+    std::string name_;
+};
+
+EmulatedLink::EmulatedLink(const LinkProfile& profile, uint64_t seed)
+    : epoch_(std::chrono::steady_clock::now()),
+      model_(profile, seed),
+      thread_([this] { run(); }) {}
+
+EmulatedLink::~EmulatedLink() {
+    close();
+}
+
+std::unique_ptr<Adapter> EmulatedLink::makeAdapter(End end, std::string name, ReceiveFn on_receive) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        receivers_[static_cast<size_t>(end)] = std::move(on_receive);
+    }
+    return std::make_unique<EndAdapter>(*this, end, std::move(name));
+}
+
+void EmulatedLink::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closing_) {
+            return;
+        }
+        closing_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+LinkModel::Stats EmulatedLink::getStats(End from) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return model_.getStats(from == End::A ? LinkModel::Direction::AtoB : LinkModel::Direction::BtoA);
+}
+
+bool EmulatedLink::transmit(End from, const Message& message) {
+    std::vector<uint8_t> frame(protocol::encodedSize(message));
+    size_t written = 0;
+    if (frame.empty() || !protocol::encodeMessage(message, frame.data(), frame.size(), written)) {
+        return false;
+    }
+    frame.resize(written);
+
+    auto now = std::chrono::steady_clock::now();
+    auto direction = from == End::A ? LinkModel::Direction::AtoB : LinkModel::Direction::BtoA;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closing_) {
+        return false;
+    }
+    auto verdict = model_.transmit(direction, written,
+                                   std::chrono::duration_cast<LinkModel::Duration>(now - epoch_));
+    if (verdict.outcome != LinkModel::Outcome::Delivered) {
+        return verdict.outcome == LinkModel::Outcome::Lost;
+    }
+
+    auto due = epoch_ + verdict.arrives_at;
+    bool earliest = in_flight_.empty() || due < in_flight_.top().due;
+    in_flight_.push(InFlight{due, next_seq_++, from == End::A ? size_t(1) : size_t(0), std::move(frame)});
+    lock.unlock();
+    if (earliest) {
+        wake_.notify_one();
+    }
+    return true;
+}
+
+void EmulatedLink::run() {
+    Message message;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!closing_) {
+        if (in_flight_.empty()) {
+            wake_.wait(lock);
+            continue;
+        }
+        auto due = in_flight_.top().due;
+        if (std::chrono::steady_clock::now() < due) {
+            wake_.wait_until(lock, due);
+            continue;
+        }
+
+        // priority_queue only hands out const tops; the frame is moved
+        // out before the pop, which never reads it
+        InFlight arrived = std::move(const_cast<InFlight&>(in_flight_.top()));
+        in_flight_.pop();
+        ReceiveFn receiver = receivers_[arrived.to];
+        lock.unlock();
+        if (receiver && protocol::decodeMessage(arrived.frame.data(), arrived.frame.size(), message)) {
+            receiver(message);
+        }
+        lock.lock();
+    }
+}
+
+} // namespace mesh::broker
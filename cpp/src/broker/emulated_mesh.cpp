@@ -0,0 +1,374 @@
+#include "mesh/broker/emulated_mesh.hpp"
+#include "mesh/protocol/message_view.hpp"
+#include <algorithm>
+#include <random>
+#include <utility>
+
+namespace mesh::broker {
+
+using protocol::Message;
+using protocol::MessageView;
+
+namespace {
+
+// Node ids are the index, big-endian, in the last four bytes
+protocol::NodeId makeNodeId(EmulatedMesh::NodeIndex index) {
+    protocol::NodeId id{};
+    id[28] = static_cast<uint8_t>(index >> 24);
+    id[29] = static_cast<uint8_t>(index >> 16);
+    id[30] = static_cast<uint8_t>(index >> 8);
+    id[31] = static_cast<uint8_t>(index);
+    return id;
+}
+
+} // namespace
+
+EmulatedMesh::Node::Node(NodeIndex index, const MessageQueue::Config& queue_config, size_t dedup_window)
+    : id(makeNodeId(index)),
+      hop(protocol::makeHopId(protocol::formatNodeId(id))),
+      queue(queue_config),
+      seen(std::max<size_t>(dedup_window, 1)) {}
+
+EmulatedMesh::EmulatedMesh() : EmulatedMesh(Config()) {}
+
+EmulatedMesh::EmulatedMesh(const Config& config)
+    : config_(config),
+      ids_(protocol::MessageIdGenerator::prefixFor("emulated-mesh")) {
+    queue_config_.max_depth = config.queue_depth;
+}
+
+std::string EmulatedMesh::nodeId(NodeIndex node) {
+    return protocol::formatNodeId(makeNodeId(node));
+}
+
+EmulatedMesh::NodeIndex EmulatedMesh::indexOf(const uint8_t* id) {
+    return static_cast<NodeIndex>(id[28]) << 24 | static_cast<NodeIndex>(id[29]) << 16 |
+           static_cast<NodeIndex>(id[30]) << 8 | static_cast<NodeIndex>(id[31]);
+}
+
+EmulatedMesh::NodeIndex EmulatedMesh::addNodes(size_t count) {
+    auto first = static_cast<NodeIndex>(nodes_.size());
+    for (size_t i = 0; i < count; ++i) {
+        nodes_.emplace_back(static_cast<NodeIndex>(nodes_.size()), queue_config_, config_.dedup_window);
+    }
+    return first;
+}
+
+bool EmulatedMesh::connect(NodeIndex a, NodeIndex b) {
+    return addLink(a, b, kPlainLink);
+}
+
+bool EmulatedMesh::connect(NodeIndex a, NodeIndex b, const LinkProfile& profile) {
+    if (!addLink(a, b, static_cast<uint32_t>(models_.size()))) {
+        return false;
+    }
+    models_.emplace_back(profile, config_.seed + models_.size());
+    return true;
+}
+
+bool EmulatedMesh::addLink(NodeIndex a, NodeIndex b, uint32_t model) {
+    if (a == b || a >= nodes_.size() || b >= nodes_.size() || findLink(nodes_[a], b)) {
+        return false;
+    }
+    nodes_[a].links.push_back(Link{b, model, LinkModel::Direction::AtoB});
+    nodes_[b].links.push_back(Link{a, model, LinkModel::Direction::BtoA});
+    ++link_count_;
+    return true;
+}
+
+const EmulatedMesh::Link* EmulatedMesh::findLink(const Node& node, NodeIndex peer) const {
+    for (const auto& link : node.links) {
+        if (link.peer == peer) {
+            return &link;
+        }
+    }
+    return nullptr;
+}
+
+const LinkModel* EmulatedMesh::linkModel(NodeIndex a, NodeIndex b) const {
+    const Link* link = a < nodes_.size() ? findLink(nodes_[a], b) : nullptr;
+    return link && link->model != kPlainLink ? &models_[link->model] : nullptr;
+}
+
+void EmulatedMesh::connectGrid(size_t width) {
+    if (width == 0) {
+        return;
+    }
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        auto node = static_cast<NodeIndex>(i);
+        if ((i + 1) % width != 0) {
+            connect(node, node + 1);
+        }
+        connect(node, static_cast<NodeIndex>(i + width));
+    }
+}
+
+void EmulatedMesh::connectRandom(size_t links_per_node, uint64_t seed) {
+    size_t n = nodes_.size();
+    if (n < 2) {
+        return;
+    }
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<NodeIndex> pick(0, static_cast<NodeIndex>(n - 1));
+    for (size_t i = 0; i < n; ++i) {
+        connect(static_cast<NodeIndex>(i), static_cast<NodeIndex>((i + 1) % n));
+        for (size_t j = 0; j < links_per_node; ++j) {
+            connect(static_cast<NodeIndex>(i), pick(rng));
+        }
+    }
+}
+
+bool EmulatedMesh::send(NodeIndex from, NodeIndex to, const std::string& content,
+                        protocol::MessagePriority priority) {
+    if (from >= nodes_.size() || (to != kBroadcast && (to >= nodes_.size() || to == from))) {
+        return false;
+    }
+    Node& node = nodes_[from];
+
+    Message message;
+    message.id = ids_.next();
+    message.from_id = protocol::formatNodeId(node.id);
+    message.to_id = to == kBroadcast ? protocol::kBroadcastId : nodeId(to);
+    message.content = content;
+    message.timestamp = std::chrono::system_clock::time_point(std::chrono::duration_cast<
+        std::chrono::system_clock::duration>(now()));
+    message.ttl = config_.ttl;
+    message.priority = priority;
+    message.path.append(node.hop);
+
+    markSeen(node, message.id);
+    sent_at_[message.id] = now_us_;
+    ++stats_.originated;
+    return enqueue(node, from, std::move(message));
+}
+
+uint64_t EmulatedMesh::run(Duration until) {
+    uint64_t limit = until.count() < 0 ? 0 : static_cast<uint64_t>(until.count());
+    uint64_t processed = 0;
+    while (!events_.empty() && events_.top().at_us <= limit) {
+        Event event = events_.top();
+        events_.pop();
+        now_us_ = event.at_us;
+        if (event.frame == kService) {
+            transmit(event.node);
+        } else {
+            receive(event.node, event.from, event.frame);
+        }
+        ++processed;
+    }
+    stats_.events += processed;
+    return processed;
+}
+
+bool EmulatedMesh::hasRoute(NodeIndex node, NodeIndex target) const {
+    return node < nodes_.size() && nodes_[node].routes.count(target) > 0;
+}
+
+size_t EmulatedMesh::routeCount(NodeIndex target) const {
+    size_t count = 0;
+    for (const auto& node : nodes_) {
+        count += node.routes.count(target);
+    }
+    return count;
+}
+
+bool EmulatedMesh::convergenceTime(NodeIndex target, Duration& at) const {
+    if (target >= nodes_.size()) {
+        return false;
+    }
+    uint64_t last = 0;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        if (i == target) {
+            continue;
+        }
+        auto it = nodes_[i].routes.find(target);
+        if (it == nodes_[i].routes.end()) {
+            return false;
+        }
+        last = std::max(last, it->second.learned_at_us);
+    }
+    at = Duration(static_cast<Duration::rep>(last));
+    return true;
+}
+
+void EmulatedMesh::schedule(uint64_t at_us, NodeIndex node, NodeIndex from, uint32_t frame) {
+    events_.push(Event{at_us, next_seq_++, node, from, frame});
+}
+
+bool EmulatedMesh::enqueue(Node& node, NodeIndex index, Message&& message) {
+    if (!node.queue.push(std::move(message))) {
+        ++stats_.queue_full;
+        return false;
+    }
+    if (!node.transmitting) {
+        node.transmitting = true;
+        schedule(now_us_, index, index, kService);
+    }
+    return true;
+}
+
+void EmulatedMesh::transmit(NodeIndex index) {
+    Node& node = nodes_[index];
+    if (!node.queue.pop(scratch_)) {
+        node.transmitting = false;
+        return;
+    }
+
+    uint32_t frame = acquireFrame();
+    auto& bytes = frames_[frame].bytes;
+    size_t size = protocol::encodedSize(scratch_);
+    bytes.resize(size);
+    size_t written = 0;
+    if (size == 0 || !protocol::encodeMessage(scratch_, bytes.data(), bytes.size(), written)) {
+        releaseFrame(frame);
+        schedule(now_us_, index, index, kService);
+        return;
+    }
+
+    // Unicast follows the route if its next hop has not seen the message;
+    // anything else goes to every neighbour not already on the path
+    const Link* route = nullptr;
+    if (scratch_.to_id != protocol::kBroadcastId) {
+        protocol::NodeId to;
+        if (protocol::parseNodeId(scratch_.to_id, to)) {
+            auto it = node.routes.find(indexOf(to.data()));
+            if (it != node.routes.end() && !scratch_.path.contains(nodes_[it->second.next_hop].hop)) {
+                route = findLink(node, it->second.next_hop);
+            }
+        }
+        ++(route ? stats_.routed : stats_.flooded);
+    }
+
+    uint64_t at = now_us_;
+    if (route) {
+        at += static_cast<uint64_t>(config_.tx_time.count());
+        sendOnLink(index, *route, frame, written, at);
+    } else {
+        for (const auto& link : node.links) {
+            if (!scratch_.path.contains(nodes_[link.peer].hop)) {
+                at += static_cast<uint64_t>(config_.tx_time.count());
+                sendOnLink(index, link, frame, written, at);
+            }
+        }
+    }
+    if (frames_[frame].refs == 0) {
+        releaseFrame(frame);
+    }
+
+    // The next frame goes out once this one has been serialized
+    schedule(at, index, index, kService);
+}
+
+void EmulatedMesh::sendOnLink(NodeIndex index, const Link& link, uint32_t frame, size_t bytes, uint64_t at) {
+    uint64_t arrives = at + static_cast<uint64_t>(config_.link_delay.count());
+    if (link.model != kPlainLink) {
+        auto verdict = models_[link.model].transmit(link.direction, bytes, LinkModel::Duration(static_cast<int64_t>(at)));
+        switch (verdict.outcome) {
+        case LinkModel::Outcome::Delivered:
+            arrives = static_cast<uint64_t>(verdict.arrives_at.count());
+            break;
+        case LinkModel::Outcome::Lost:
+            ++stats_.transmissions;
+            stats_.bytes += bytes;
+            ++stats_.link_lost;
+            return;
+        default:
+            ++stats_.link_dropped;
+            return;
+        }
+    }
+    ++frames_[frame].refs;
+    schedule(arrives, link.peer, index, frame);
+    ++stats_.transmissions;
+    stats_.bytes += bytes;
+}
+
+void EmulatedMesh::receive(NodeIndex index, NodeIndex from, uint32_t frame) {
+    Node& node = nodes_[index];
+    const auto& bytes = frames_[frame].bytes;
+    MessageView view;
+    if (!view.parse(bytes.data(), bytes.size())) {
+        releaseFrame(frame);
+        return;
+    }
+
+    // Duplicates still teach routes: a later copy may have come a shorter way
+    NodeIndex origin = indexOf(view.fromId().data);
+    if (origin != index && origin < nodes_.size()) {
+        learnRoute(node, origin, from, static_cast<uint32_t>(view.hopCount()));
+    }
+    if (view.hasVisited(node.hop) || !markSeen(node, view.messageId())) {
+        ++stats_.duplicates;
+        releaseFrame(frame);
+        return;
+    }
+
+    bool broadcast = view.isBroadcast();
+    if (broadcast || view.isAddressedTo(node.id)) {
+        ++stats_.delivered;
+        auto sent = sent_at_.find(view.messageId());
+        uint64_t origin_us = sent != sent_at_.end() ? sent->second : now_us_;
+        if (deliver_) {
+            view.toMessage(scratch_);
+            deliver_(index, scratch_, Duration(static_cast<Duration::rep>(now_us_ - origin_us)));
+        }
+        if (!broadcast) {
+            if (sent != sent_at_.end()) {
+                sent_at_.erase(sent);
+            }
+            releaseFrame(frame);
+            return;
+        }
+    }
+
+    Message message;
+    bool decoded = view.toMessage(message);
+    releaseFrame(frame);
+    if (!decoded) {
+        return;
+    }
+    message.decrementTTL();
+    if (message.isExpired()) {
+        ++stats_.expired;
+        return;
+    }
+    message.path.append(node.hop);
+    enqueue(node, index, std::move(message));
+}
+
+void EmulatedMesh::learnRoute(Node& node, NodeIndex origin, NodeIndex via, uint32_t hops) {
+    auto [it, inserted] = node.routes.try_emplace(origin, Route{via, hops, now_us_});
+    if (!inserted && hops < it->second.hops) {
+        it->second.next_hop = via;
+        it->second.hops = hops;
+    }
+}
+
+bool EmulatedMesh::markSeen(Node& node, const protocol::MessageId& id) {
+    if (std::find(node.seen.begin(), node.seen.end(), id) != node.seen.end()) {
+        return false;
+    }
+    node.seen[node.seen_next] = id;
+    node.seen_next = (node.seen_next + 1) % node.seen.size();
+    return true;
+}
+
+uint32_t EmulatedMesh::acquireFrame() {
+    if (free_frames_.empty()) {
+        frames_.emplace_back();
+        return static_cast<uint32_t>(frames_.size() - 1);
+    }
+    uint32_t frame = free_frames_.back();
+    free_frames_.pop_back();
+    return frame;
+}
+
+void EmulatedMesh::releaseFrame(uint32_t frame) {
+    if (frames_[frame].refs > 0 && --frames_[frame].refs > 0) {
+        return;
+    }
+    frames_[frame].refs = 0;
+    free_frames_.push_back(frame);
+}
+
+} // namespace mesh::broker
@@ -0,0 +1,102 @@
+#include "mesh/broker/latency_histogram.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace mesh::broker {
+
+namespace {
+
+constexpr uint64_t kSubBucketCount = uint64_t(1) << LatencyHistogram::kSubBucketBits;
+
+} // namespace
+
+size_t LatencyHistogram::bucketIndex(uint64_t micros) {
+    if (micros < kSubBucketCount) {
+        return static_cast<size_t>(micros);
+    }
+    unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(micros));
+    if (exponent > kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    unsigned shift = exponent - kSubBucketBits;
+    return (static_cast<size_t>(shift + 1) << kSubBucketBits) +
+           static_cast<size_t>((micros >> shift) & (kSubBucketCount - 1));
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    unsigned shift = static_cast<unsigned>(index >> kSubBucketBits) - 1;
+    uint64_t low = (kSubBucketCount + (index & (kSubBucketCount - 1))) << shift;
+    return low + (uint64_t(1) << shift) - 1;
+}
+
+LatencySummary LatencyHistogram::summarize() const {
+    const LatencyHistogram* self = this;
+    return summarize(&self, 1);
+}
+
+LatencySummary LatencyHistogram::summarize(const LatencyHistogram* const* histograms, size_t count) {
+    std::array<uint64_t, kBucketCount> buckets{};
+    LatencySummary summary;
+    uint64_t sum = 0;
+    for (size_t h = 0; h < count; ++h) {
+        const LatencyHistogram& histogram = *histograms[h];
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            uint64_t n = histogram.buckets_[i].load(std::memory_order_relaxed);
+            buckets[i] += n;
+            summary.count += n;
+        }
+        sum += histogram.sum_us_.load(std::memory_order_relaxed);
+        summary.max_us = std::max(summary.max_us, histogram.max_us_.load(std::memory_order_relaxed));
+    }
+    if (summary.count == 0) {
+        return summary;
+    }
+    summary.mean_us = static_cast<double>(sum) / static_cast<double>(summary.count);
+
+    // Walk the buckets once, filling each percentile as its rank is passed
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    uint64_t* results[] = {&summary.p50_us, &summary.p90_us, &summary.p99_us, &summary.p999_us};
+    size_t next = 0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount && next < 4; ++i) {
+        seen += buckets[i];
+        while (next < 4) {
+            auto rank = static_cast<uint64_t>(std::ceil(quantiles[next] * static_cast<double>(summary.count)));
+            if (seen < std::max<uint64_t>(rank, 1)) {
+                break;
+            }
+            *results[next++] = std::min(bucketUpperBound(i), summary.max_us);
+        }
+    }
+    return summary;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    sum_us_.store(0, std::memory_order_relaxed);
+    max_us_.store(0, std::memory_order_relaxed);
+}
+
+LatencyStats PriorityLatency::summarize() const {
+    LatencyStats stats;
+    const LatencyHistogram* all[3];
+    for (size_t i = 0; i < histograms_.size(); ++i) {
+        stats.by_priority[i] = histograms_[i].summarize();
+        all[i] = &histograms_[i];
+    }
+    stats.all = LatencyHistogram::summarize(all, histograms_.size());
+    return stats;
+}
+
+void PriorityLatency::reset() {
+    for (auto& histogram : histograms_) {
+        histogram.reset();
+    }
+}
+
+} // namespace mesh::broker
@@ -0,0 +1,94 @@
+#include "mesh/broker/link_model.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace mesh::broker {
+
+double GilbertElliott::averageLoss() const {
+    double flips = good_to_bad + bad_to_good;
+    double bad = flips > 0.0 ? good_to_bad / flips : 0.0;
+    return bad * loss_bad + (1.0 - bad) * loss_good;
+}
+
+LinkProfile LinkProfile::wifi() {
+    LinkProfile profile;
+    profile.bandwidth_bps = 20'000'000;
+    profile.delay = std::chrono::microseconds(1000);
+    profile.jitter = std::chrono::microseconds(2000);
+    profile.mtu = 1500;
+    profile.max_backlog = std::chrono::microseconds(50000);
+    profile.half_duplex = true;
+    profile.loss = GilbertElliott{0.01, 0.25, 0.002, 0.4};
+    return profile;
+}
+
+LinkModel::LinkModel(const LinkProfile& profile, uint64_t seed)
+    : profile_(profile),
+      bytes_per_us_(static_cast<double>(std::max<uint64_t>(profile.bandwidth_bps, 1)) / 8e6),
+      burst_(static_cast<double>(profile.burst_bytes)),
+      rng_(seed) {
+    for (auto& channel : channels_) {
+        channel.tokens = burst_;
+    }
+}
+
+LinkModel::Verdict LinkModel::transmit(Direction direction, size_t bytes, Duration now) {
+    size_t dir = index(direction);
+    Stats& stats = stats_[dir];
+    ++stats.frames;
+
+    Verdict verdict;
+    verdict.departs_at = now;
+    if (bytes > profile_.mtu) {
+        ++stats.oversize;
+        verdict.outcome = Outcome::Oversize;
+        return verdict;
+    }
+
+    // Callers may hand frames over slightly out of time order, so the
+    // bucket only ever refills forwards
+    Channel& channel = channels_[profile_.half_duplex ? 0 : dir];
+    int64_t at = now.count();
+    if (at > channel.refilled_at) {
+        channel.tokens = std::min(burst_, channel.tokens + static_cast<double>(at - channel.refilled_at) * bytes_per_us_);
+        channel.refilled_at = at;
+    }
+    channel.tokens -= static_cast<double>(bytes);
+    int64_t departs = at;
+    if (channel.tokens < 0.0) {
+        departs = std::max(at, channel.refilled_at + static_cast<int64_t>(std::ceil(-channel.tokens / bytes_per_us_)));
+    }
+    if (departs - at > profile_.max_backlog.count()) {
+        channel.tokens += static_cast<double>(bytes);
+        ++stats.congested;
+        verdict.outcome = Outcome::Congested;
+        return verdict;
+    }
+    verdict.departs_at = Duration(departs);
+
+    const GilbertElliott& loss = profile_.loss;
+    if (loss.loss_good > 0.0 || loss.loss_bad > 0.0) {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        bad_[dir] = bad_[dir] ? uniform(rng_) >= loss.bad_to_good : uniform(rng_) < loss.good_to_bad;
+        if (uniform(rng_) < (bad_[dir] ? loss.loss_bad : loss.loss_good)) {
+            ++stats.lost;
+            verdict.outcome = Outcome::Lost;
+            return verdict;
+        }
+    }
+
+    int64_t arrives = departs + profile_.delay.count();
+    if (profile_.jitter.count() > 0) {
+        arrives += std::uniform_int_distribution<int64_t>(0, profile_.jitter.count())(rng_);
+    }
+    // Jitter delays a frame but never lets it overtake the one before
+    arrives = std::max(arrives, last_arrival_[dir]);
+    last_arrival_[dir] = arrives;
+
+    verdict.arrives_at = Duration(arrives);
+    ++stats.delivered;
+    stats.bytes_delivered += bytes;
+    return verdict;
+}
+
+} // namespace mesh::broker
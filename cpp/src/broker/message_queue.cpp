@@ -0,0 +1,232 @@
+#include "mesh/broker/message_queue.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace mesh::broker {
+
+using protocol::CoarseClock;
+using protocol::Message;
+using protocol::MessagePriority;
+
+MessageQueue::MessageQueue() : MessageQueue(Config()) {}
+
+MessageQueue::MessageQueue(const Config& config)
+    : config_(config),
+      lanes_{{Lane(config.max_depth), Lane(config.max_depth), Lane(config.max_depth)}} {
+    refillCredits();
+}
+
+size_t MessageQueue::laneIndex(MessagePriority priority) {
+    size_t index = static_cast<size_t>(priority);
+    return index < kClassCount ? index : static_cast<size_t>(MessagePriority::Normal);
+}
+
+bool MessageQueue::push(const Message& message) {
+    return enqueue(lanes_[laneIndex(message.priority)], [&](Entry& entry) {
+        entry.message = message;
+        entry.enqueued_at = CoarseClock::now();
+    });
+}
+
+bool MessageQueue::push(Message&& message) {
+    return enqueue(lanes_[laneIndex(message.priority)], [&](Entry& entry) {
+        entry.message = std::move(message);
+        entry.enqueued_at = CoarseClock::now();
+    });
+}
+
+template <typename Fill>
+bool MessageQueue::enqueue(Lane& lane, Fill&& fill) {
+    if (lane.ring.push(fill)) {
+        notifyConsumer();
+        return true;
+    }
+    if (config_.enqueue_policy == EnqueuePolicy::Reject) {
+        lane.rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Sleep on the futex until the consumer frees slots; registering
+    // before the retry means a pop between the two cannot be missed
+    lane.blocked.fetch_add(1, std::memory_order_relaxed);
+    auto deadline = std::chrono::steady_clock::now() + config_.block_timeout;
+    space_waiters_.fetch_add(1, std::memory_order_seq_cst);
+    bool pushed = false;
+    for (;;) {
+        uint32_t epoch = space_epoch_.load(std::memory_order_seq_cst);
+        if (lane.ring.push(fill)) {
+            pushed = true;
+            break;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            break;
+        }
+        futexWait(space_epoch_, epoch,
+                  std::chrono::duration_cast<std::chrono::microseconds>(deadline - now));
+    }
+    space_waiters_.fetch_sub(1, std::memory_order_relaxed);
+
+    if (!pushed) {
+        lane.rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    notifyConsumer();
+    return true;
+}
+
+void MessageQueue::notifyConsumer() {
+    // Pairs with the fence in prepareWait(): either the consumer sees the
+    // message, or we see it armed
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumer_armed_.load(std::memory_order_relaxed) &&
+        consumer_armed_.exchange(false, std::memory_order_acquire)) {
+        wake_->notify();
+    }
+}
+
+void MessageQueue::notifyProducers() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (space_waiters_.load(std::memory_order_relaxed) > 0) {
+        space_epoch_.fetch_add(1, std::memory_order_seq_cst);
+        futexWakeAll(space_epoch_);
+    }
+}
+
+bool MessageQueue::prepareWait() {
+    if (!wake_) {
+        wake_ = std::make_unique<EventFd>();
+    }
+    consumer_armed_.store(true, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (const auto& lane : lanes_) {
+        if (lane.ring.peek()) {
+            consumer_armed_.store(false, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    return true;
+}
+
+void MessageQueue::finishWait() {
+    consumer_armed_.store(false, std::memory_order_relaxed);
+    if (wake_) {
+        wake_->drain();
+    }
+}
+
+size_t MessageQueue::take(Lane& lane, Message* out, size_t max, CoarseClock::time_point now) {
+    int64_t total_wait = 0;
+    int64_t max_wait = 0;
+    size_t taken = lane.ring.popBatch(max, [&](Entry& entry) {
+        using std::swap;
+        swap(entry.message, *out++);
+        int64_t waited = std::max<int64_t>((now - entry.enqueued_at).count(), 0);
+        total_wait += waited;
+        max_wait = std::max(max_wait, waited);
+    });
+    if (taken == 0) {
+        return 0;
+    }
+
+    lane.dequeued.fetch_add(taken, std::memory_order_relaxed);
+    lane.total_wait_ms.fetch_add(total_wait, std::memory_order_relaxed);
+    if (max_wait > lane.max_wait_ms.load(std::memory_order_relaxed)) {
+        lane.max_wait_ms.store(max_wait, std::memory_order_relaxed);
+    }
+    return taken;
+}
+
+void MessageQueue::refillCredits() {
+    for (size_t i = 0; i < kClassCount; ++i) {
+        lanes_[i].credits = config_.weights[i] > 0 ? config_.weights[i] : 1;
+    }
+}
+
+bool MessageQueue::pop(Message& message) {
+    return popBatch(&message, 1) == 1;
+}
+
+size_t MessageQueue::popBatch(Message* out, size_t max) {
+    // One clock read per batch, never a tick()-cached one: the stamps
+    // being compared were taken on producer threads
+    auto now = CoarseClock::now();
+    size_t count = 0;
+
+    // Starvation guard: overdue Low messages jump the round
+    Lane& low = lanes_[laneIndex(MessagePriority::Low)];
+    while (count < max) {
+        const Entry* head = low.ring.peek();
+        if (!head || now - head->enqueued_at < config_.low_max_wait) {
+            break;
+        }
+        count += take(low, out + count, 1, now);
+    }
+
+    // Highest class with credits left; refill when only spent classes
+    // have work, so idle classes never stall the round
+    while (count < max) {
+        bool pending = false;
+        bool served = false;
+        for (size_t i = kClassCount; i-- > 0 && count < max;) {
+            Lane& lane = lanes_[i];
+            if (!lane.ring.peek()) {
+                continue;
+            }
+            pending = true;
+            if (lane.credits > 0) {
+                size_t taken = take(lane, out + count, std::min<size_t>(lane.credits, max - count), now);
+                lane.credits -= static_cast<uint32_t>(taken);
+                count += taken;
+                served = true;
+                break;
+            }
+        }
+        if (!pending) {
+            break;
+        }
+        if (!served) {
+            refillCredits();
+        }
+    }
+
+    if (count > 0) {
+        notifyProducers();
+    }
+    return count;
+}
+
+size_t MessageQueue::size() const {
+    size_t total = 0;
+    for (const auto& lane : lanes_) {
+        total += lane.ring.sizeApprox();
+    }
+    return total;
+}
+
+MessageQueue::ClassStats MessageQueue::getClassStats(MessagePriority priority) const {
+    const Lane& lane = lanes_[laneIndex(priority)];
+
+    ClassStats stats;
+    stats.depth = lane.ring.sizeApprox();
+    stats.dequeued = lane.dequeued.load(std::memory_order_relaxed);
+    stats.rejected = lane.rejected.load(std::memory_order_relaxed);
+    stats.blocked = lane.blocked.load(std::memory_order_relaxed);
+    if (stats.dequeued > 0) {
+        stats.avg_wait_ms = static_cast<double>(lane.total_wait_ms.load(std::memory_order_relaxed)) /
+                            static_cast<double>(stats.dequeued);
+    }
+    stats.max_wait_ms = static_cast<double>(lane.max_wait_ms.load(std::memory_order_relaxed));
+    return stats;
+}
+
+void MessageQueue::clear() {
+    // Queued messages stay in their slots until overwritten
+    for (auto& lane : lanes_) {
+        while (lane.ring.popBatch(lane.ring.capacity(), [](Entry&) {}) > 0) {
+        }
+    }
+    notifyProducers();
+}
+
+} // namespace mesh::broker
@@ -0,0 +1,501 @@
+#include "mesh/broker/message_spool.hpp"
+#include "protocol/wire_format.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace mesh::broker {
+
+using protocol::Message;
+using protocol::NodeId;
+namespace wire = protocol::wire;
+
+namespace {
+
+// Record: body length (u32) | CRC-32 of body (u32) | body. A zero length
+// marks the end of the written part of a segment.
+constexpr size_t kRecordHeader = 8;
+constexpr uint8_t kMessageRecord = 1;   // kind | frame
+constexpr uint8_t kAckRecord = 2;       // kind | peer (32) | segment (u32) | offset (u32)
+constexpr size_t kAckBody = 1 + 32 + 8;
+
+uint32_t bodyCrc(const uint8_t* body, size_t len) {
+    return static_cast<uint32_t>(crc32(0, body, static_cast<uInt>(len)));
+}
+
+size_t pageSize() {
+    static const auto size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+} // namespace
+
+struct MessageSpool::Segment {
+    ~Segment() {
+        if (data) {
+            munmap(data, size);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    uint32_t number = 0;
+    std::string path;
+    int fd = -1;
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t used = 0;
+    size_t synced = 0;
+    size_t live = 0;        // messages not yet acknowledged
+};
+
+size_t MessageSpool::NodeIdHash::operator()(const NodeId& id) const {
+    uint64_t hash = 0;
+    for (size_t i = 0; i < id.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, id.data() + i, sizeof(word));
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+    }
+    return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+MessageSpool::MessageSpool(const Config& config) : config_(config) {}
+
+MessageSpool::~MessageSpool() {
+    close();
+}
+
+bool MessageSpool::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (open_) {
+        return true;
+    }
+    if (mkdir(config_.directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        return false;
+    }
+    dir_fd_ = ::open(config_.directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd_ < 0) {
+        return false;
+    }
+
+    std::vector<uint32_t> numbers;
+    if (DIR* dir = fdopendir(dup(dir_fd_))) {
+        while (dirent* entry = readdir(dir)) {
+            unsigned number = 0;
+            const char* name = entry->d_name;
+            if (std::strlen(name) == 14 && std::strcmp(name + 8, ".spool") == 0 &&
+                std::sscanf(name, "%8u", &number) == 1 && number > 0) {
+                numbers.push_back(number);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(numbers.begin(), numbers.end());
+
+    stats_ = Stats();
+    for (uint32_t number : numbers) {
+        auto segment = openSegment(number, false);
+        if (!segment) {
+            segments_.clear();
+            queues_.clear();
+            pending_ = 0;
+            ::close(dir_fd_);
+            dir_fd_ = -1;
+            return false;
+        }
+        segments_[number] = segment;
+        recover(*segment);
+    }
+    stats_.recovered = pending_;
+
+    // Keep appending to the last segment; older ones are only read again
+    // if their peers reconnect
+    if (!segments_.empty()) {
+        active_ = segments_.rbegin()->second;
+        unsynced_from_ = active_->number;
+        for (auto& [number, segment] : segments_) {
+            if (segment != active_) {
+                madvise(segment->data, segment->size, MADV_DONTNEED);
+            }
+        }
+    }
+    dropDeadSegments();
+
+    appended_bytes_ = durable_bytes_ = 0;
+    sync_requested_ = commit_failed_ = false;
+    stopping_ = false;
+    open_ = true;
+    committer_ = std::thread([this] { runCommitter(); });
+    return true;
+}
+
+void MessageSpool::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!open_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    commit_wake_.notify_one();
+    if (committer_.joinable()) {
+        committer_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_ = false;
+    active_.reset();
+    segments_.clear();
+    queues_.clear();
+    pending_ = 0;
+    ::close(dir_fd_);
+    dir_fd_ = -1;
+    committed_.notify_all();
+}
+
+std::shared_ptr<MessageSpool::Segment> MessageSpool::openSegment(uint32_t number, bool create) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%08u.spool", number);
+
+    auto segment = std::make_shared<Segment>();
+    segment->number = number;
+    segment->path = config_.directory + "/" + name;
+    int flags = O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0);
+    segment->fd = ::open(segment->path.c_str(), flags, 0644);
+    if (segment->fd < 0) {
+        return nullptr;
+    }
+
+    if (create) {
+        if (ftruncate(segment->fd, static_cast<off_t>(config_.segment_bytes)) != 0) {
+            unlink(segment->path.c_str());
+            return nullptr;
+        }
+        segment->size = config_.segment_bytes;
+        // The new file's name and size must survive a crash before any
+        // record in it is reported durable
+        fsync(segment->fd);
+        fsync(dir_fd_);
+    } else {
+        struct stat info;
+        if (fstat(segment->fd, &info) != 0 || info.st_size <= 0) {
+            return nullptr;
+        }
+        segment->size = static_cast<size_t>(info.st_size);
+    }
+
+    void* data = mmap(nullptr, segment->size, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    segment->data = static_cast<uint8_t*>(data);
+    return segment;
+}
+
+void MessageSpool::recover(Segment& segment) {
+    size_t offset = 0;
+    while (offset + kRecordHeader <= segment.size) {
+        const uint8_t* record = segment.data + offset;
+        size_t len = wire::readU32(record);
+        if (len == 0) {
+            break;
+        }
+        const uint8_t* body = record + kRecordHeader;
+        if (len > segment.size - offset - kRecordHeader || wire::readU32(record + 4) != bodyCrc(body, len)) {
+            // Torn tail: clear it so later appends are not mistaken for it
+            std::memset(segment.data + offset, 0, std::min(segment.size - offset, kRecordHeader + len));
+            break;
+        }
+
+        NodeId peer;
+        if (body[0] == kMessageRecord && len >= 1 + protocol::kWireHeaderSize) {
+            std::memcpy(peer.data(), body + 1 + wire::kToIdOffset, peer.size());
+            queues_[peer].push_back(Entry{segment.number, static_cast<uint32_t>(offset), static_cast<uint32_t>(len - 1)});
+            ++segment.live;
+            ++pending_;
+        } else if (body[0] == kAckRecord && len == kAckBody) {
+            std::memcpy(peer.data(), body + 1, peer.size());
+            auto it = queues_.find(peer);
+            if (it != queues_.end()) {
+                retire(it->second, wire::readU32(body + 33), wire::readU32(body + 37));
+                if (it->second.empty()) {
+                    queues_.erase(it);
+                }
+            }
+        }
+        offset += kRecordHeader + len;
+    }
+    segment.used = segment.synced = offset;
+}
+
+uint8_t* MessageSpool::reserve(size_t body_len, Entry& at) {
+    size_t record = kRecordHeader + body_len;
+    if (record > config_.segment_bytes || body_len > UINT32_MAX) {
+        return nullptr;
+    }
+    if (!active_ || active_->used + record > active_->size) {
+        uint32_t number = segments_.empty() ? 1 : segments_.rbegin()->first + 1;
+        auto segment = openSegment(number, true);
+        if (!segment) {
+            return nullptr;
+        }
+        segments_[number] = segment;
+        active_ = segment;
+        dropDeadSegments();
+    }
+    at.segment = active_->number;
+    at.offset = static_cast<uint32_t>(active_->used);
+    return active_->data + active_->used + kRecordHeader;
+}
+
+void MessageSpool::seal(const Entry& at, size_t body_len) {
+    uint8_t* record = active_->data + at.offset;
+    wire::writeU32(record + 4, bodyCrc(record + kRecordHeader, body_len));
+    wire::writeU32(record, static_cast<uint32_t>(body_len));
+    active_->used += kRecordHeader + body_len;
+    appended_bytes_ += kRecordHeader + body_len;
+    if (appended_bytes_ - durable_bytes_ >= config_.commit_bytes) {
+        commit_wake_.notify_one();
+    }
+}
+
+bool MessageSpool::append(const Message& message) {
+    size_t size = protocol::encodedSize(message);
+    if (size == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_ || commit_failed_) {
+        return false;
+    }
+    Entry at;
+    uint8_t* body = reserve(1 + size, at);
+    size_t written = 0;
+    if (!body || !protocol::encodeMessage(message, body + 1, size, written)) {
+        return false;
+    }
+    body[0] = kMessageRecord;
+    seal(at, 1 + written);
+
+    NodeId peer;
+    std::memcpy(peer.data(), body + 1 + wire::kToIdOffset, peer.size());
+    at.length = static_cast<uint32_t>(written);
+    queues_[peer].push_back(at);
+    ++active_->live;
+    ++pending_;
+    ++stats_.appended;
+    return true;
+}
+
+bool MessageSpool::sync() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t target = appended_bytes_;
+    if (!open_ || commit_failed_) {
+        return false;
+    }
+    if (durable_bytes_ >= target) {
+        return true;
+    }
+    sync_requested_ = true;
+    commit_wake_.notify_one();
+    committed_.wait(lock, [&] { return durable_bytes_ >= target || commit_failed_ || !open_; });
+    return durable_bytes_ >= target;
+}
+
+size_t MessageSpool::stream(const NodeId& peer, size_t max, const SendFn& send) const {
+    struct Frame {
+        std::shared_ptr<Segment> segment;
+        const uint8_t* data;
+        size_t len;
+    };
+    std::vector<Frame> frames;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = queues_.find(peer);
+        if (it == queues_.end()) {
+            return 0;
+        }
+        size_t count = std::min(max, it->second.size());
+        frames.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            const Entry& entry = it->second[i];
+            const auto& segment = segments_.at(entry.segment);
+            frames.push_back(Frame{segment, segment->data + entry.offset + kRecordHeader + 1, entry.length});
+        }
+    }
+
+    // Outside the lock: the held segments stay mapped even if the frames
+    // are acknowledged meanwhile
+    size_t sent = 0;
+    for (const auto& frame : frames) {
+        if (!send(frame.data, frame.len)) {
+            break;
+        }
+        ++sent;
+    }
+    return sent;
+}
+
+size_t MessageSpool::acknowledge(const NodeId& peer, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = queues_.find(peer);
+    if (!open_ || it == queues_.end() || count == 0) {
+        return 0;
+    }
+    const Entry last = it->second[std::min(count, it->second.size()) - 1];
+
+    // If the ack record cannot be written the messages are still retired
+    // here and simply sent again after a restart
+    Entry at;
+    if (uint8_t* body = reserve(kAckBody, at)) {
+        body[0] = kAckRecord;
+        std::memcpy(body + 1, peer.data(), peer.size());
+        wire::writeU32(body + 33, last.segment);
+        wire::writeU32(body + 37, last.offset);
+        seal(at, kAckBody);
+    }
+
+    // reserve() may have rolled to a new segment, which never invalidates
+    // queue iterators
+    size_t retired = retire(it->second, last.segment, last.offset);
+    if (it->second.empty()) {
+        queues_.erase(it);
+    }
+    stats_.acknowledged += retired;
+    dropDeadSegments();
+    return retired;
+}
+
+size_t MessageSpool::retire(std::deque<Entry>& queue, uint32_t segment, uint32_t offset) {
+    size_t retired = 0;
+    while (!queue.empty()) {
+        const Entry& front = queue.front();
+        if (front.segment > segment || (front.segment == segment && front.offset > offset)) {
+            break;
+        }
+        auto it = segments_.find(front.segment);
+        if (it != segments_.end() && it->second->live > 0) {
+            --it->second->live;
+        }
+        queue.pop_front();
+        --pending_;
+        ++retired;
+    }
+    return retired;
+}
+
+void MessageSpool::dropDeadSegments() {
+    // Oldest first only: an ack record can retire messages in any earlier
+    // segment, so a segment is deleted only after everything before it
+    while (!segments_.empty()) {
+        auto oldest = segments_.begin();
+        if (oldest->second == active_ || oldest->second->live > 0) {
+            break;
+        }
+        unlink(oldest->second->path.c_str());
+        segments_.erase(oldest);
+    }
+}
+
+size_t MessageSpool::pending(const NodeId& peer) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = queues_.find(peer);
+    return it != queues_.end() ? it->second.size() : 0;
+}
+
+MessageSpool::Stats MessageSpool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.failing = commit_failed_;
+    stats.destinations = queues_.size();
+    stats.pending = pending_;
+    stats.segments = segments_.size();
+    for (const auto& [number, segment] : segments_) {
+        stats.disk_bytes += segment->size;
+    }
+    return stats;
+}
+
+void MessageSpool::runCommitter() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // After a failure nothing cuts the wait short, so the retry comes one
+    // commit_interval later rather than in a tight loop
+    auto due = [&] { return appended_bytes_ > durable_bytes_; };
+    while (!stopping_) {
+        commit_wake_.wait_for(lock, config_.commit_interval, [&] {
+            return stopping_ || (!commit_failed_ && (sync_requested_ ||
+                                 appended_bytes_ - durable_bytes_ >= config_.commit_bytes));
+        });
+        if (due()) {
+            commit(lock);
+        }
+    }
+    // Whatever close() raced with
+    if (due()) {
+        commit(lock);
+    }
+}
+
+void MessageSpool::commit(std::unique_lock<std::mutex>& lock) {
+    struct Range {
+        std::shared_ptr<Segment> segment;
+        size_t from;
+        size_t to;
+        bool full;
+    };
+
+    // One msync per dirty segment covers every append since the last
+    // commit, however many writers made them
+    std::vector<Range> ranges;
+    for (auto it = segments_.lower_bound(unsynced_from_); it != segments_.end(); ++it) {
+        const auto& segment = it->second;
+        if (segment->synced < segment->used) {
+            ranges.push_back(Range{segment, segment->synced, segment->used, segment != active_});
+        }
+    }
+    uint64_t target = appended_bytes_;
+    uint32_t synced_from = active_ ? active_->number : unsynced_from_;
+    sync_requested_ = false;
+    lock.unlock();
+
+    bool ok = true;
+    for (const auto& range : ranges) {
+        size_t from = range.from & ~(pageSize() - 1);
+        uint8_t* address = range.segment->data + from;
+        size_t len = range.to - from;
+        bool flushed = config_.flush ? config_.flush(address, len) : msync(address, len, MS_SYNC) == 0;
+        if (flushed && range.full) {
+            // Written out and finished: drop its pages from our footprint
+            madvise(range.segment->data, range.segment->size, MADV_DONTNEED);
+        }
+        ok &= flushed;
+    }
+
+    lock.lock();
+    if (ok) {
+        for (const auto& range : ranges) {
+            range.segment->synced = std::max(range.segment->synced, range.to);
+        }
+        durable_bytes_ = std::max(durable_bytes_, target);
+        unsynced_from_ = std::max(unsynced_from_, synced_from);
+        commit_failed_ = false;
+        ++stats_.commits;
+    } else {
+        // Ranges stay unsynced, so the retry covers them all again
+        commit_failed_ = true;
+        ++stats_.commit_failures;
+    }
+    committed_.notify_all();
+}
+
+} // namespace mesh::broker
@@ -0,0 +1,99 @@
+#include "mesh/broker/wakeup.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <linux/futex.h>
+#include <unistd.h>
+
+namespace mesh::broker {
+
+EventFd::EventFd() : fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    if (fd_ < 0) {
+        throw std::runtime_error("eventfd failed");
+    }
+}
+
+EventFd::~EventFd() {
+    close(fd_);
+}
+
+void EventFd::notify() {
+    uint64_t one = 1;
+    // EAGAIN means the counter is saturated, which is still readable
+    [[maybe_unused]] ssize_t written = write(fd_, &one, sizeof(one));
+}
+
+uint64_t EventFd::drain() {
+    uint64_t count = 0;
+    return read(fd_, &count, sizeof(count)) == sizeof(count) ? count : 0;
+}
+
+TimerFd::TimerFd(std::chrono::milliseconds interval)
+    : fd_(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) {
+    if (fd_ < 0) {
+        throw std::runtime_error("timerfd_create failed");
+    }
+    auto count = std::max<int64_t>(interval.count(), 1);
+    itimerspec spec{};
+    spec.it_interval.tv_sec = static_cast<time_t>(count / 1000);
+    spec.it_interval.tv_nsec = static_cast<long>(count % 1000) * 1000000;
+    spec.it_value = spec.it_interval;
+    timerfd_settime(fd_, 0, &spec, nullptr);
+}
+
+TimerFd::~TimerFd() {
+    close(fd_);
+}
+
+uint64_t TimerFd::drain() {
+    uint64_t expirations = 0;
+    return read(fd_, &expirations, sizeof(expirations)) == sizeof(expirations) ? expirations : 0;
+}
+
+uint32_t waitReadable(std::initializer_list<int> fds, std::chrono::milliseconds timeout) {
+    pollfd polled[32];
+    nfds_t count = 0;
+    for (int fd : fds) {
+        if (count == 32) {
+            break;
+        }
+        polled[count++] = {fd, POLLIN, 0};
+    }
+
+    int timeout_ms = timeout.count() < 0 ? -1 : static_cast<int>(std::min<int64_t>(timeout.count(), INT_MAX));
+    int ready;
+    do {
+        ready = poll(polled, count, timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+    if (ready <= 0) {
+        return 0;
+    }
+
+    uint32_t mask = 0;
+    for (nfds_t i = 0; i < count; ++i) {
+        if (polled[i].revents & (POLLIN | POLLERR | POLLHUP)) {
+            mask |= uint32_t(1) << i;
+        }
+    }
+    return mask;
+}
+
+void futexWait(const std::atomic<uint32_t>& word, uint32_t expected, std::chrono::microseconds timeout) {
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32-bit word");
+    auto micros = std::max<int64_t>(timeout.count(), 0);
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(micros / 1000000);
+    ts.tv_nsec = static_cast<long>(micros % 1000000) * 1000;
+    syscall(SYS_futex, reinterpret_cast<const uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, &ts, nullptr, 0);
+}
+
+void futexWakeAll(const std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<const uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+} // namespace mesh::broker
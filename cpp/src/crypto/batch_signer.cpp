@@ -0,0 +1,257 @@
+#include "mesh/crypto/batch_signer.hpp"
+#include "mesh/crypto.h"
+#include <algorithm>
+#include <cstring>
+
+namespace mesh::crypto {
+
+namespace {
+
+// Domain separation between leaves and inner nodes (RFC 6962 style)
+constexpr uint8_t kLeafPrefix = 0x00;
+constexpr uint8_t kNodePrefix = 0x01;
+
+const char kBatchContext[] = "katya-mesh-batch";
+constexpr size_t kContextSize = sizeof(kBatchContext) - 1;
+constexpr size_t kSignedSize = kContextSize + 2 + 32;
+
+Hash nodeHash(const Hash& left, const Hash& right) {
+    uint8_t buffer[1 + 32 + 32];
+    buffer[0] = kNodePrefix;
+    std::memcpy(buffer + 1, left.data(), 32);
+    std::memcpy(buffer + 33, right.data(), 32);
+
+    Hash hash;
+    mesh_crypto_sha256(buffer, sizeof(buffer), hash.data());
+    return hash;
+}
+
+// What the Ed25519 signature covers: context | leaf count | root
+void signedMessage(const Hash& root, uint16_t count, uint8_t* out) {
+    std::memcpy(out, kBatchContext, kContextSize);
+    out[kContextSize] = static_cast<uint8_t>(count);
+    out[kContextSize + 1] = static_cast<uint8_t>(count >> 8);
+    std::memcpy(out + kContextSize + 2, root.data(), 32);
+}
+
+} // namespace
+
+Hash batchLeafHash(const uint8_t* message, size_t len) {
+    std::vector<uint8_t> buffer(1 + len);
+    buffer[0] = kLeafPrefix;
+    if (len > 0) {
+        std::memcpy(buffer.data() + 1, message, len);
+    }
+
+    Hash hash;
+    mesh_crypto_sha256(buffer.data(), buffer.size(), hash.data());
+    return hash;
+}
+
+bool batchRootFromProof(const Hash& leaf, const BatchProof& proof, Hash& root) {
+    if (proof.leaf_count == 0 || proof.leaf_index >= proof.leaf_count) {
+        return false;
+    }
+
+    Hash hash = leaf;
+    size_t index = proof.leaf_index;
+    size_t count = proof.leaf_count;
+    size_t step = 0;
+
+    while (count > 1) {
+        if (index & 1) {
+            if (step >= proof.path.size()) {
+                return false;
+            }
+            hash = nodeHash(proof.path[step++], hash);
+        } else if (index + 1 < count) {
+            if (step >= proof.path.size()) {
+                return false;
+            }
+            hash = nodeHash(hash, proof.path[step++]);
+        }
+        // Otherwise the node is the odd one out and carries up unchanged
+        index >>= 1;
+        count = (count + 1) >> 1;
+    }
+
+    if (step != proof.path.size()) {
+        return false;
+    }
+
+    root = hash;
+    return true;
+}
+
+std::vector<uint8_t> BatchProof::encode() const {
+    std::vector<uint8_t> out(64 + 4 + path.size() * 32);
+    std::copy(signature.begin(), signature.end(), out.begin());
+    out[64] = static_cast<uint8_t>(leaf_index);
+    out[65] = static_cast<uint8_t>(leaf_index >> 8);
+    out[66] = static_cast<uint8_t>(leaf_count);
+    out[67] = static_cast<uint8_t>(leaf_count >> 8);
+    for (size_t i = 0; i < path.size(); ++i) {
+        std::copy(path[i].begin(), path[i].end(), out.begin() + 68 + i * 32);
+    }
+    return out;
+}
+
+bool BatchProof::decode(const uint8_t* data, size_t len, BatchProof& proof) {
+    if (!data || len < 68 || (len - 68) % 32 != 0) {
+        return false;
+    }
+
+    std::copy(data, data + 64, proof.signature.begin());
+    proof.leaf_index = static_cast<uint16_t>(data[64] | data[65] << 8);
+    proof.leaf_count = static_cast<uint16_t>(data[66] | data[67] << 8);
+
+    proof.path.resize((len - 68) / 32);
+    for (size_t i = 0; i < proof.path.size(); ++i) {
+        std::copy(data + 68 + i * 32, data + 68 + (i + 1) * 32, proof.path[i].begin());
+    }
+    return true;
+}
+
+BatchSigner::BatchSigner(const uint8_t private_key[32],
+                         std::chrono::milliseconds window,
+                         size_t max_batch)
+    : window_(window),
+      max_batch_(std::clamp<size_t>(max_batch, 1, kMaxBatchSize)) {
+    std::copy(private_key, private_key + 32, private_key_.begin());
+    leaves_.reserve(max_batch_);
+}
+
+BatchSigner::~BatchSigner() {
+    std::fill(private_key_.begin(), private_key_.end(), 0);
+}
+
+BatchSigner::AddResult BatchSigner::add(const uint8_t* message, size_t len) {
+    Hash leaf = batchLeafHash(message, len);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (leaves_.size() >= max_batch_) {
+        return AddResult::Rejected;
+    }
+    if (leaves_.empty()) {
+        first_added_ = std::chrono::steady_clock::now();
+    }
+    leaves_.push_back(leaf);
+    return leaves_.size() >= max_batch_ ? AddResult::Full : AddResult::Queued;
+}
+
+bool BatchSigner::isDue() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (leaves_.empty()) {
+        return false;
+    }
+    return leaves_.size() >= max_batch_ ||
+           std::chrono::steady_clock::now() - first_added_ >= window_;
+}
+
+bool BatchSigner::flush(std::vector<BatchProof>& proofs) {
+    std::vector<Hash> leaves;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        leaves.swap(leaves_);
+        leaves_.reserve(max_batch_);
+    }
+
+    proofs.clear();
+    if (leaves.empty()) {
+        return true;
+    }
+
+    // Build every level of the tree, leaves first
+    std::vector<std::vector<Hash>> levels;
+    levels.push_back(std::move(leaves));
+    while (levels.back().size() > 1) {
+        const std::vector<Hash>& level = levels.back();
+        std::vector<Hash> next;
+        next.reserve((level.size() + 1) / 2);
+        for (size_t i = 0; i < level.size(); i += 2) {
+            next.push_back(i + 1 < level.size() ? nodeHash(level[i], level[i + 1]) : level[i]);
+        }
+        levels.push_back(std::move(next));
+    }
+
+    const size_t count = levels.front().size();
+    uint8_t message[kSignedSize];
+    signedMessage(levels.back().front(), static_cast<uint16_t>(count), message);
+
+    Signature signature;
+    if (mesh_crypto_ed25519_sign(private_key_.data(), message, sizeof(message),
+                                 signature.data()) != MESH_CRYPTO_SUCCESS) {
+        return false;
+    }
+
+    proofs.resize(count);
+    for (size_t leaf = 0; leaf < count; ++leaf) {
+        BatchProof& proof = proofs[leaf];
+        proof.signature = signature;
+        proof.leaf_index = static_cast<uint16_t>(leaf);
+        proof.leaf_count = static_cast<uint16_t>(count);
+
+        size_t index = leaf;
+        for (size_t depth = 0; depth + 1 < levels.size(); ++depth) {
+            size_t sibling = index ^ 1;
+            if (sibling < levels[depth].size()) {
+                proof.path.push_back(levels[depth][sibling]);
+            }
+            index >>= 1;
+        }
+    }
+
+    return true;
+}
+
+size_t BatchSigner::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return leaves_.size();
+}
+
+BatchVerifier::BatchVerifier(const uint8_t public_key[32], size_t cache_size)
+    : cache_size_(std::max<size_t>(cache_size, 1)) {
+    std::copy(public_key, public_key + 32, public_key_.begin());
+}
+
+bool BatchVerifier::verify(const uint8_t* message, size_t len, const BatchProof& proof) {
+    Hash root;
+    if (!batchRootFromProof(batchLeafHash(message, len), proof, root)) {
+        return false;
+    }
+
+    auto key = std::make_pair(root, proof.leaf_count);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (verified_roots_.count(key)) {
+            stats_.cache_hits++;
+            return true;
+        }
+        stats_.signature_checks++;
+    }
+
+    // Signature check runs unlocked so receive threads do not serialize on it
+    uint8_t signed_message[kSignedSize];
+    signedMessage(root, proof.leaf_count, signed_message);
+    if (mesh_crypto_ed25519_verify(public_key_.data(), signed_message, sizeof(signed_message),
+                                   proof.signature.data()) != MESH_CRYPTO_SUCCESS) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (verified_roots_.insert(key).second) {
+        cache_order_.push_back(key);
+        while (cache_order_.size() > cache_size_) {
+            verified_roots_.erase(cache_order_.front());
+            cache_order_.pop_front();
+        }
+    }
+    return true;
+}
+
+BatchVerifier::Stats BatchVerifier::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace mesh::crypto
@@ -294,16 +294,37 @@ mesh_crypto_error_t mesh_crypto_derive_session_keys(
         key2, 32);
 }
 
-// Placeholder implementations for Ed25519 and ChaCha20
-// TODO: Implement with proper crypto libraries
-
 mesh_crypto_error_t mesh_crypto_ed25519_keypair_generate(
     mesh_key_t public_key,
     mesh_key_t private_key) {
-    // TODO: Implement Ed25519 key generation
-    return mesh_crypto_random_bytes(private_key, 32) == MESH_CRYPTO_SUCCESS &&
-           mesh_crypto_random_bytes(public_key, 32) == MESH_CRYPTO_SUCCESS ?
-           MESH_CRYPTO_SUCCESS : MESH_CRYPTO_ERROR_INVALID_DATA;
+
+    if (!public_key || !private_key) {
+        return MESH_CRYPTO_ERROR_INVALID_KEY;
+    }
+
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, nullptr);
+    if (!ctx) {
+        return MESH_CRYPTO_ERROR_OUT_OF_MEMORY;
+    }
+
+    EVP_PKEY* pkey = nullptr;
+    if (EVP_PKEY_keygen_init(ctx) <= 0 || EVP_PKEY_keygen(ctx, &pkey) <= 0) {
+        EVP_PKEY_CTX_free(ctx);
+        return MESH_CRYPTO_ERROR_INVALID_KEY;
+    }
+    EVP_PKEY_CTX_free(ctx);
+
+    // Private key is the 32-byte seed
+    size_t private_len = 32;
+    size_t public_len = 32;
+    if (EVP_PKEY_get_raw_private_key(pkey, private_key, &private_len) != 1 ||
+        EVP_PKEY_get_raw_public_key(pkey, public_key, &public_len) != 1) {
+        EVP_PKEY_free(pkey);
+        return MESH_CRYPTO_ERROR_INVALID_KEY;
+    }
+
+    EVP_PKEY_free(pkey);
+    return MESH_CRYPTO_SUCCESS;
 }
 
 mesh_crypto_error_t mesh_crypto_ed25519_sign(
@@ -311,8 +332,36 @@ mesh_crypto_error_t mesh_crypto_ed25519_sign(
     const uint8_t* message,
     size_t message_len,
     mesh_signature_t signature) {
-    // TODO: Implement Ed25519 signing
-    return MESH_CRYPTO_ERROR_INVALID_DATA;
+
+    if (!private_key || !signature || (!message && message_len > 0)) {
+        return MESH_CRYPTO_ERROR_INVALID_DATA;
+    }
+
+    EVP_PKEY* pkey = EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, nullptr, private_key, 32);
+    if (!pkey) {
+        return MESH_CRYPTO_ERROR_INVALID_KEY;
+    }
+
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    if (!ctx) {
+        EVP_PKEY_free(pkey);
+        return MESH_CRYPTO_ERROR_OUT_OF_MEMORY;
+    }
+
+    // Ed25519 is one-shot: no digest is configured
+    size_t signature_len = 64;
+    const uint8_t empty = 0;
+    if (EVP_DigestSignInit(ctx, nullptr, nullptr, nullptr, pkey) != 1 ||
+        EVP_DigestSign(ctx, signature, &signature_len,
+                       message ? message : &empty, message_len) != 1) {
+        EVP_MD_CTX_free(ctx);
+        EVP_PKEY_free(pkey);
+        return MESH_CRYPTO_ERROR_INVALID_KEY;
+    }
+
+    EVP_MD_CTX_free(ctx);
+    EVP_PKEY_free(pkey);
+    return MESH_CRYPTO_SUCCESS;
 }
 
 mesh_crypto_error_t mesh_crypto_ed25519_verify(
@@ -320,10 +369,37 @@ mesh_crypto_error_t mesh_crypto_ed25519_verify(
     const uint8_t* message,
     size_t message_len,
     const mesh_signature_t signature) {
-    // TODO: Implement Ed25519 verification
-    return MESH_CRYPTO_ERROR_INVALID_DATA;
+
+    if (!public_key || !signature || (!message && message_len > 0)) {
+        return MESH_CRYPTO_ERROR_INVALID_DATA;
+    }
+
+    EVP_PKEY* pkey = EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, nullptr, public_key, 32);
+    if (!pkey) {
+        return MESH_CRYPTO_ERROR_INVALID_KEY;
+    }
+
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    if (!ctx) {
+        EVP_PKEY_free(pkey);
+        return MESH_CRYPTO_ERROR_OUT_OF_MEMORY;
+    }
+
+    const uint8_t empty = 0;
+    int result = EVP_DigestVerifyInit(ctx, nullptr, nullptr, nullptr, pkey);
+    if (result == 1) {
+        result = EVP_DigestVerify(ctx, signature, 64,
+                                  message ? message : &empty, message_len);
+    }
+
+    EVP_MD_CTX_free(ctx);
+    EVP_PKEY_free(pkey);
+    return result == 1 ? MESH_CRYPTO_SUCCESS : MESH_CRYPTO_ERROR_SIGNATURE_INVALID;
 }
 
+// Placeholder implementations for ChaCha20
+// TODO: Implement with proper crypto libraries
+
 mesh_crypto_error_t mesh_crypto_chacha20_poly1305_encrypt(
     const mesh_key_t key,
     const mesh_nonce_t nonce,
@@ -0,0 +1,230 @@
+#include "mesh/crypto/group_session.hpp"
+#include "mesh/crypto.h"
+#include <algorithm>
+#include <cstring>
+
+namespace mesh::crypto {
+
+namespace {
+
+const char kMessageKeyInfo[] = "katya-group-msg";
+const char kChainKeyInfo[] = "katya-group-chain";
+
+// AES-GCM requires a non-null plaintext pointer even for empty payloads
+const uint8_t kEmpty[1] = {0};
+
+void writeU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint32_t readU32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) |
+           static_cast<uint32_t>(in[1]) << 8 |
+           static_cast<uint32_t>(in[2]) << 16 |
+           static_cast<uint32_t>(in[3]) << 24;
+}
+
+// Derives the message key for the current step and advances the chain
+bool ratchet(std::array<uint8_t, 32>& chain_key, std::array<uint8_t, 32>& message_key) {
+    std::array<uint8_t, 32> next_chain;
+    if (mesh_crypto_hkdf_sha256(chain_key.data(), chain_key.size(), nullptr, 0,
+                                reinterpret_cast<const uint8_t*>(kMessageKeyInfo),
+                                sizeof(kMessageKeyInfo) - 1,
+                                message_key.data(), message_key.size()) != MESH_CRYPTO_SUCCESS) {
+        return false;
+    }
+    if (mesh_crypto_hkdf_sha256(chain_key.data(), chain_key.size(), nullptr, 0,
+                                reinterpret_cast<const uint8_t*>(kChainKeyInfo),
+                                sizeof(kChainKeyInfo) - 1,
+                                next_chain.data(), next_chain.size()) != MESH_CRYPTO_SUCCESS) {
+        return false;
+    }
+    chain_key = next_chain;
+    std::fill(next_chain.begin(), next_chain.end(), 0);
+    return true;
+}
+
+void encodeNonce(uint32_t iteration, mesh_nonce_t nonce) {
+    std::memset(nonce, 0, sizeof(mesh_nonce_t));
+    writeU32(nonce, iteration);
+}
+
+} // namespace
+
+SenderKeySession::SenderKeySession() {
+    rotate();
+}
+
+SenderKeySession::~SenderKeySession() {
+    std::fill(chain_key_.begin(), chain_key_.end(), 0);
+}
+
+bool SenderKeySession::encrypt(const std::vector<uint8_t>& plaintext, std::vector<uint8_t>& out) {
+    if (!has_key_) {
+        return false;
+    }
+
+    std::array<uint8_t, 32> message_key;
+    uint32_t iteration = iteration_;
+    if (!ratchet(chain_key_, message_key)) {
+        return false;
+    }
+    ++iteration_;
+
+    out.resize(kFrameOverhead + plaintext.size());
+    writeU32(out.data(), key_id_);
+    writeU32(out.data() + 4, iteration);
+
+    mesh_nonce_t nonce;
+    encodeNonce(iteration, nonce);
+
+    size_t ciphertext_len = 0;
+    mesh_crypto_error_t err = mesh_crypto_aes_gcm_encrypt(
+        message_key.data(), nonce,
+        plaintext.empty() ? kEmpty : plaintext.data(), plaintext.size(),
+        out.data(), kHeaderSize,
+        out.data() + kHeaderSize, &ciphertext_len);
+    std::fill(message_key.begin(), message_key.end(), 0);
+
+    return err == MESH_CRYPTO_SUCCESS && ciphertext_len == plaintext.size() + kTagSize;
+}
+
+std::vector<uint8_t> SenderKeySession::createDistribution() const {
+    if (!has_key_) {
+        return {};
+    }
+
+    std::vector<uint8_t> distribution(kDistributionSize);
+    writeU32(distribution.data(), key_id_);
+    writeU32(distribution.data() + 4, iteration_);
+    std::copy(chain_key_.begin(), chain_key_.end(), distribution.begin() + 8);
+    return distribution;
+}
+
+bool SenderKeySession::rotate() {
+    // The old chain is dropped first, so a failed rotation leaves no key
+    // to broadcast under rather than the one that was meant to be retired
+    has_key_ = false;
+    iteration_ = 0;
+    std::fill(chain_key_.begin(), chain_key_.end(), 0);
+
+    uint32_t key_id = key_id_;
+    while (key_id == key_id_) {
+        if (mesh_crypto_random_bytes(reinterpret_cast<uint8_t*>(&key_id),
+                                     sizeof(key_id)) != MESH_CRYPTO_SUCCESS) {
+            return false;
+        }
+    }
+    if (mesh_crypto_random_bytes(chain_key_.data(), chain_key_.size()) != MESH_CRYPTO_SUCCESS) {
+        std::fill(chain_key_.begin(), chain_key_.end(), 0);
+        return false;
+    }
+    key_id_ = key_id;
+    has_key_ = true;
+    return true;
+}
+
+SenderKeyReceiver::~SenderKeyReceiver() {
+    std::fill(chain_key_.begin(), chain_key_.end(), 0);
+    for (auto& entry : skipped_keys_) {
+        std::fill(entry.second.begin(), entry.second.end(), 0);
+    }
+}
+
+bool SenderKeyReceiver::importDistribution(const std::vector<uint8_t>& distribution) {
+    if (distribution.size() != SenderKeySession::kDistributionSize) {
+        return false;
+    }
+
+    key_id_ = readU32(distribution.data());
+    iteration_ = readU32(distribution.data() + 4);
+    std::copy(distribution.begin() + 8, distribution.end(), chain_key_.begin());
+    for (auto& entry : skipped_keys_) {
+        std::fill(entry.second.begin(), entry.second.end(), 0);
+    }
+    skipped_keys_.clear();
+    has_key_ = true;
+    return true;
+}
+
+bool SenderKeyReceiver::decrypt(const std::vector<uint8_t>& frame, std::vector<uint8_t>& plaintext) {
+    if (!has_key_ || frame.size() < SenderKeySession::kFrameOverhead) {
+        return false;
+    }
+
+    if (readU32(frame.data()) != key_id_) {
+        return false;
+    }
+
+    uint32_t iteration = readU32(frame.data() + 4);
+    MessageKey message_key;
+
+    // Work on copies so a forged frame cannot advance the real chain
+    SenderKeySession::ChainKey chain_key = chain_key_;
+    uint32_t next_iteration = iteration_;
+    std::map<uint32_t, MessageKey> skipped;
+
+    if (iteration < iteration_) {
+        auto it = skipped_keys_.find(iteration);
+        if (it == skipped_keys_.end()) {
+            return false; // Replayed, or too old to still hold its key
+        }
+        message_key = it->second;
+    } else {
+        if (iteration - iteration_ > kMaxForwardSkip) {
+            return false;
+        }
+        while (next_iteration < iteration) {
+            MessageKey skipped_key;
+            if (!ratchet(chain_key, skipped_key)) {
+                return false;
+            }
+            skipped.emplace(next_iteration++, skipped_key);
+        }
+        if (!ratchet(chain_key, message_key)) {
+            return false;
+        }
+        ++next_iteration;
+    }
+
+    mesh_nonce_t nonce;
+    encodeNonce(iteration, nonce);
+
+    size_t ciphertext_len = frame.size() - SenderKeySession::kHeaderSize;
+    plaintext.resize(ciphertext_len - SenderKeySession::kTagSize + 1);
+
+    size_t plaintext_len = 0;
+    mesh_crypto_error_t err = mesh_crypto_aes_gcm_decrypt(
+        message_key.data(), nonce,
+        frame.data() + SenderKeySession::kHeaderSize, ciphertext_len,
+        frame.data(), SenderKeySession::kHeaderSize,
+        plaintext.data(), &plaintext_len);
+    std::fill(message_key.begin(), message_key.end(), 0);
+
+    if (err != MESH_CRYPTO_SUCCESS) {
+        plaintext.clear();
+        return false;
+    }
+    plaintext.resize(plaintext_len);
+
+    // Authenticated: commit the ratchet state
+    if (iteration < iteration_) {
+        auto it = skipped_keys_.find(iteration);
+        std::fill(it->second.begin(), it->second.end(), 0);
+        skipped_keys_.erase(it);
+    } else {
+        chain_key_ = chain_key;
+        iteration_ = next_iteration;
+        skipped_keys_.merge(skipped);
+        while (skipped_keys_.size() > kMaxSkippedKeys) {
+            auto oldest = skipped_keys_.begin();
+            std::fill(oldest->second.begin(), oldest->second.end(), 0);
+            skipped_keys_.erase(oldest);
+        }
+    }
+    return true;
+}
+
+} // namespace mesh::crypto
@@ -0,0 +1,235 @@
+#include "mesh/crypto/layered_frame.hpp"
+#include "mesh/core.h"
+#include "mesh/crypto.h"
+#include <algorithm>
+#include <cstring>
+
+namespace mesh::crypto {
+
+namespace {
+
+constexpr size_t kTaggedHeaderSize = 84;
+constexpr size_t kTagSize = 16;
+constexpr size_t kBodyOffset = kRoutingHeaderSize;
+
+// Nonce domains keep header tags and bodies apart under a shared counter
+constexpr uint8_t kHopNonceDomain = 'h';
+constexpr uint8_t kBodyNonceDomain = 'e';
+
+// AES-GCM requires non-null buffers even when no payload is processed
+const uint8_t kEmpty[1] = {0};
+
+void writeU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+void writeU64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint32_t readU32(const uint8_t* in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+uint64_t readU64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+void encodeNonce(uint8_t domain, uint64_t counter, mesh_nonce_t nonce) {
+    std::memset(nonce, 0, sizeof(mesh_nonce_t));
+    nonce[0] = domain;
+    writeU64(nonce + 4, counter);
+}
+
+void writeHeader(const RoutingHeader& header, uint8_t* out) {
+    out[0] = header.version;
+    out[1] = header.type;
+    out[2] = header.ttl;
+    out[3] = header.hops;
+    writeU32(out + 4, header.session_id);
+    writeU64(out + 8, header.hop_counter);
+    std::copy(header.source.begin(), header.source.end(), out + 16);
+    std::copy(header.destination.begin(), header.destination.end(), out + 48);
+    writeU32(out + 80, header.body_length);
+}
+
+void readHeader(const uint8_t* in, RoutingHeader& header) {
+    header.version = in[0];
+    header.type = in[1];
+    header.ttl = in[2];
+    header.hops = in[3];
+    header.session_id = readU32(in + 4);
+    header.hop_counter = readU64(in + 8);
+    std::copy(in + 16, in + 48, header.source.begin());
+    std::copy(in + 48, in + 80, header.destination.begin());
+    header.body_length = readU32(in + 80);
+}
+
+// GMAC: AES-GCM over an empty plaintext with the header as AAD
+bool tagHeader(uint8_t* frame, const SessionTable::Key& hop_key, uint64_t counter) {
+    mesh_nonce_t nonce;
+    encodeNonce(kHopNonceDomain, counter, nonce);
+
+    size_t tag_len = 0;
+    mesh_crypto_error_t err = mesh_crypto_aes_gcm_encrypt(
+        hop_key.data(), nonce, kEmpty, 0,
+        frame, kTaggedHeaderSize,
+        frame + kTaggedHeaderSize, &tag_len);
+    return err == MESH_CRYPTO_SUCCESS && tag_len == kTagSize;
+}
+
+// Additional data binding the body to the fields relays cannot change
+void bodyAad(const uint8_t* frame, uint8_t* aad) {
+    aad[0] = frame[0];
+    aad[1] = frame[1];
+    std::memcpy(aad + 2, frame + 16, 64);
+}
+
+} // namespace
+
+bool sealLayeredFrame(RoutingHeader header,
+                      const SessionTable::Key& e2e_key,
+                      uint64_t e2e_counter,
+                      const std::vector<uint8_t>& plaintext,
+                      const SessionTable::Key& hop_key,
+                      std::vector<uint8_t>& out) {
+    if (header.ttl == 0) {
+        return false;
+    }
+
+    header.version = kLayeredFrameVersion;
+    header.type = MESH_MSG_ENCRYPTED;
+    header.body_length = static_cast<uint32_t>(kLayeredBodyOverhead + plaintext.size());
+
+    out.resize(kRoutingHeaderSize + header.body_length);
+    writeHeader(header, out.data());
+
+    // End-to-end body
+    uint8_t* body = out.data() + kBodyOffset;
+    writeU64(body, e2e_counter);
+
+    mesh_nonce_t nonce;
+    encodeNonce(kBodyNonceDomain, e2e_counter, nonce);
+
+    uint8_t aad[66];
+    bodyAad(out.data(), aad);
+
+    size_t ciphertext_len = 0;
+    mesh_crypto_error_t err = mesh_crypto_aes_gcm_encrypt(
+        e2e_key.data(), nonce,
+        plaintext.empty() ? kEmpty : plaintext.data(), plaintext.size(),
+        aad, sizeof(aad),
+        body + 8, &ciphertext_len);
+    if (err != MESH_CRYPTO_SUCCESS || ciphertext_len != plaintext.size() + kTagSize) {
+        return false;
+    }
+
+    // Hop-by-hop header
+    return tagHeader(out.data(), hop_key, header.hop_counter);
+}
+
+bool verifyRoutingHeader(const uint8_t* frame, size_t len,
+                         const SessionTable::Key& hop_key,
+                         RoutingHeader& header) {
+    if (!frame || len < kRoutingHeaderSize + kLayeredBodyOverhead) {
+        return false;
+    }
+
+    readHeader(frame, header);
+    if (header.version != kLayeredFrameVersion ||
+        header.body_length != len - kRoutingHeaderSize) {
+        return false;
+    }
+
+    mesh_nonce_t nonce;
+    encodeNonce(kHopNonceDomain, header.hop_counter, nonce);
+
+    uint8_t scratch[1];
+    size_t plaintext_len = 0;
+    mesh_crypto_error_t err = mesh_crypto_aes_gcm_decrypt(
+        hop_key.data(), nonce,
+        frame + kTaggedHeaderSize, kTagSize,
+        frame, kTaggedHeaderSize,
+        scratch, &plaintext_len);
+    return err == MESH_CRYPTO_SUCCESS && plaintext_len == 0;
+}
+
+bool relayLayeredFrame(uint8_t* frame, size_t len,
+                       const SessionTable::Key& inbound_hop_key,
+                       SessionId outbound_session,
+                       uint64_t outbound_counter,
+                       const SessionTable::Key& outbound_hop_key) {
+    RoutingHeader header;
+    if (!verifyRoutingHeader(frame, len, inbound_hop_key, header)) {
+        return false;
+    }
+
+    if (header.ttl <= 1 || header.hops == UINT8_MAX) {
+        return false;
+    }
+
+    header.ttl--;
+    header.hops++;
+    header.session_id = outbound_session;
+    header.hop_counter = outbound_counter;
+
+    // Only the header is rewritten; body bytes are forwarded as received
+    uint8_t saved[kRoutingHeaderSize];
+    std::memcpy(saved, frame, kRoutingHeaderSize);
+    writeHeader(header, frame);
+    if (!tagHeader(frame, outbound_hop_key, outbound_counter)) {
+        std::memcpy(frame, saved, kRoutingHeaderSize);
+        return false;
+    }
+    return true;
+}
+
+bool openLayeredFrame(const uint8_t* frame, size_t len,
+                      const SessionTable::Key& hop_key,
+                      const SessionTable::Key& e2e_key,
+                      RoutingHeader& header,
+                      std::vector<uint8_t>& plaintext) {
+    if (!verifyRoutingHeader(frame, len, hop_key, header)) {
+        return false;
+    }
+
+    const uint8_t* body = frame + kBodyOffset;
+    uint64_t e2e_counter = readU64(body);
+
+    mesh_nonce_t nonce;
+    encodeNonce(kBodyNonceDomain, e2e_counter, nonce);
+
+    uint8_t aad[66];
+    bodyAad(frame, aad);
+
+    size_t ciphertext_len = header.body_length - 8;
+    plaintext.resize(ciphertext_len - kTagSize + 1);
+
+    size_t plaintext_len = 0;
+    mesh_crypto_error_t err = mesh_crypto_aes_gcm_decrypt(
+        e2e_key.data(), nonce,
+        body + 8, ciphertext_len,
+        aad, sizeof(aad),
+        plaintext.data(), &plaintext_len);
+    if (err != MESH_CRYPTO_SUCCESS) {
+        plaintext.clear();
+        return false;
+    }
+
+    plaintext.resize(plaintext_len);
+    return true;
+}
+
+} // namespace mesh::crypto
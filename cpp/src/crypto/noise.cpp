@@ -0,0 +1,314 @@
+#include "mesh/crypto/noise.hpp"
+#include "mesh/crypto.h"
+#include <algorithm>
+#include <cstring>
+
+namespace mesh::crypto {
+
+namespace {
+
+const char kProtocolName[] = "Noise_IK_25519_AESGCM_SHA256";
+
+std::vector<uint8_t> label(const char* text) {
+    return std::vector<uint8_t>(text, text + std::strlen(text));
+}
+
+const std::vector<uint8_t> kChainInfo = label("katya-noise-ck");
+const std::vector<uint8_t> kKeyInfo = label("katya-noise-k");
+const std::vector<uint8_t> kInitiatorInfo = label("katya-noise-i2r");
+const std::vector<uint8_t> kResponderInfo = label("katya-noise-r2i");
+
+// AES-GCM requires a non-null plaintext pointer even for empty payloads
+const uint8_t kEmpty[1] = {0};
+
+void encodeNonce(uint64_t counter, mesh_nonce_t nonce) {
+    std::memset(nonce, 0, sizeof(mesh_nonce_t));
+    for (int i = 0; i < 8; ++i) {
+        nonce[4 + i] = static_cast<uint8_t>(counter >> (8 * i));
+    }
+}
+
+bool isZero(const SharedSecret& secret) {
+    uint8_t acc = 0;
+    for (uint8_t b : secret) {
+        acc |= b;
+    }
+    return acc == 0;
+}
+
+} // namespace
+
+NoiseHandshake::NoiseHandshake(Role role, const KeyPair& static_key)
+    : role_(role), static_key_(static_key) {
+    // Protocol name fits in the hash length, so it is used directly (zero padded)
+    std::memcpy(hash_.data(), kProtocolName, sizeof(kProtocolName) - 1);
+    chaining_key_ = hash_;
+
+    // IK pre-message: the responder's static key is part of the transcript
+    if (role_ == Role::Responder) {
+        mixHash(static_key_.getPublicKey().data(), static_key_.getPublicKey().size());
+    }
+}
+
+bool NoiseHandshake::writeInitiation(const PublicKey& remote_static_key,
+                                     const std::vector<uint8_t>& early_data,
+                                     std::vector<uint8_t>& out) {
+    if (role_ != Role::Initiator || step_ != Step::Initiation) {
+        return false;
+    }
+
+    remote_static_ = remote_static_key;
+    mixHash(remote_static_.data(), remote_static_.size());
+
+    out.clear();
+    out.reserve(kInitiationOverhead + early_data.size());
+
+    // e
+    const PublicKey& e = ephemeral_key_.getPublicKey();
+    out.insert(out.end(), e.begin(), e.end());
+    mixHash(e.data(), e.size());
+
+    // es
+    if (!mixKey(ephemeral_key_.computeSharedSecret(remote_static_))) {
+        return fail();
+    }
+
+    // s
+    const PublicKey& s = static_key_.getPublicKey();
+    if (!encryptAndHash(s.data(), s.size(), out)) {
+        return fail();
+    }
+
+    // ss
+    if (!mixKey(static_key_.computeSharedSecret(remote_static_))) {
+        return fail();
+    }
+
+    if (!encryptAndHash(early_data.data(), early_data.size(), out)) {
+        return fail();
+    }
+
+    step_ = Step::Response;
+    return true;
+}
+
+bool NoiseHandshake::readInitiation(const std::vector<uint8_t>& in,
+                                    std::vector<uint8_t>& early_data) {
+    if (role_ != Role::Responder || step_ != Step::Initiation) {
+        return false;
+    }
+
+    if (in.size() < kInitiationOverhead) {
+        return false;
+    }
+
+    const uint8_t* p = in.data();
+
+    // e
+    std::copy(p, p + 32, remote_ephemeral_.begin());
+    mixHash(p, 32);
+    p += 32;
+
+    // es
+    if (!mixKey(static_key_.computeSharedSecret(remote_ephemeral_))) {
+        return fail();
+    }
+
+    // s
+    std::vector<uint8_t> s;
+    if (!decryptAndHash(p, 32 + kTagSize, s)) {
+        return fail();
+    }
+    std::copy(s.begin(), s.end(), remote_static_.begin());
+    p += 32 + kTagSize;
+
+    // ss
+    if (!mixKey(static_key_.computeSharedSecret(remote_static_))) {
+        return fail();
+    }
+
+    early_data.clear();
+    if (!decryptAndHash(p, in.size() - (p - in.data()), early_data)) {
+        return fail();
+    }
+
+    step_ = Step::Response;
+    return true;
+}
+
+bool NoiseHandshake::writeResponse(const std::vector<uint8_t>& payload,
+                                   std::vector<uint8_t>& out) {
+    if (role_ != Role::Responder || step_ != Step::Response) {
+        return false;
+    }
+
+    out.clear();
+    out.reserve(kResponseOverhead + payload.size());
+
+    // e
+    const PublicKey& e = ephemeral_key_.getPublicKey();
+    out.insert(out.end(), e.begin(), e.end());
+    mixHash(e.data(), e.size());
+
+    // ee
+    if (!mixKey(ephemeral_key_.computeSharedSecret(remote_ephemeral_))) {
+        return fail();
+    }
+
+    // se
+    if (!mixKey(ephemeral_key_.computeSharedSecret(remote_static_))) {
+        return fail();
+    }
+
+    if (!encryptAndHash(payload.data(), payload.size(), out)) {
+        return fail();
+    }
+
+    return split();
+}
+
+bool NoiseHandshake::readResponse(const std::vector<uint8_t>& in,
+                                  std::vector<uint8_t>& payload) {
+    if (role_ != Role::Initiator || step_ != Step::Response) {
+        return false;
+    }
+
+    if (in.size() < kResponseOverhead) {
+        return false;
+    }
+
+    // e
+    std::copy(in.begin(), in.begin() + 32, remote_ephemeral_.begin());
+    mixHash(in.data(), 32);
+
+    // ee
+    if (!mixKey(ephemeral_key_.computeSharedSecret(remote_ephemeral_))) {
+        return fail();
+    }
+
+    // se
+    if (!mixKey(static_key_.computeSharedSecret(remote_ephemeral_))) {
+        return fail();
+    }
+
+    payload.clear();
+    if (!decryptAndHash(in.data() + 32, in.size() - 32, payload)) {
+        return fail();
+    }
+
+    return split();
+}
+
+void NoiseHandshake::mixHash(const uint8_t* data, size_t len) {
+    std::vector<uint8_t> buffer;
+    buffer.reserve(hash_.size() + len);
+    buffer.insert(buffer.end(), hash_.begin(), hash_.end());
+    buffer.insert(buffer.end(), data, data + len);
+    mesh_crypto_sha256(buffer.data(), buffer.size(), hash_.data());
+}
+
+bool NoiseHandshake::mixKey(const SharedSecret& dh) {
+    // Reject low-order points, which yield an all-zero shared secret
+    if (isZero(dh)) {
+        return false;
+    }
+
+    std::vector<uint8_t> salt(chaining_key_.begin(), chaining_key_.end());
+    SessionKey next_chain = deriveSessionKey(dh, salt, kChainInfo);
+    SessionKey next_key = deriveSessionKey(dh, salt, kKeyInfo);
+    if (next_chain.size() != chaining_key_.size() || next_key.size() != 32) {
+        return false;
+    }
+
+    std::copy(next_chain.begin(), next_chain.end(), chaining_key_.begin());
+    cipher_key_ = std::move(next_key);
+    nonce_ = 0;
+    return true;
+}
+
+bool NoiseHandshake::encryptAndHash(const uint8_t* plaintext, size_t len,
+                                    std::vector<uint8_t>& out) {
+    mesh_nonce_t nonce;
+    encodeNonce(nonce_++, nonce);
+
+    size_t offset = out.size();
+    out.resize(offset + len + kTagSize);
+
+    size_t ciphertext_len = 0;
+    mesh_crypto_error_t err = mesh_crypto_aes_gcm_encrypt(
+        cipher_key_.data(), nonce,
+        len > 0 ? plaintext : kEmpty, len,
+        hash_.data(), hash_.size(),
+        out.data() + offset, &ciphertext_len);
+    if (err != MESH_CRYPTO_SUCCESS || ciphertext_len != len + kTagSize) {
+        return false;
+    }
+
+    mixHash(out.data() + offset, ciphertext_len);
+    return true;
+}
+
+bool NoiseHandshake::decryptAndHash(const uint8_t* ciphertext, size_t len,
+                                    std::vector<uint8_t>& out) {
+    if (len < kTagSize) {
+        return false;
+    }
+
+    mesh_nonce_t nonce;
+    encodeNonce(nonce_++, nonce);
+
+    // Keep a scratch byte so the output pointer is valid for empty payloads
+    out.resize(len - kTagSize + 1);
+
+    size_t plaintext_len = 0;
+    mesh_crypto_error_t err = mesh_crypto_aes_gcm_decrypt(
+        cipher_key_.data(), nonce,
+        ciphertext, len,
+        hash_.data(), hash_.size(),
+        out.data(), &plaintext_len);
+    if (err != MESH_CRYPTO_SUCCESS || plaintext_len != len - kTagSize) {
+        return false;
+    }
+    out.resize(plaintext_len);
+
+    mixHash(ciphertext, len);
+    return true;
+}
+
+bool NoiseHandshake::split() {
+    SharedSecret chain;
+    std::copy(chaining_key_.begin(), chaining_key_.end(), chain.begin());
+    std::vector<uint8_t> salt(hash_.begin(), hash_.end());
+
+    SessionKey initiator_key = deriveSessionKey(chain, salt, kInitiatorInfo);
+    SessionKey responder_key = deriveSessionKey(chain, salt, kResponderInfo);
+    if (initiator_key.empty() || responder_key.empty()) {
+        return fail();
+    }
+
+    if (role_ == Role::Initiator) {
+        send_key_ = std::move(initiator_key);
+        receive_key_ = std::move(responder_key);
+    } else {
+        send_key_ = std::move(responder_key);
+        receive_key_ = std::move(initiator_key);
+    }
+
+    // Handshake secrets are no longer needed
+    std::fill(chaining_key_.begin(), chaining_key_.end(), 0);
+    std::fill(cipher_key_.begin(), cipher_key_.end(), 0);
+
+    step_ = Step::Done;
+    complete_ = true;
+    return true;
+}
+
+bool NoiseHandshake::fail() {
+    step_ = Step::Failed;
+    complete_ = false;
+    std::fill(chaining_key_.begin(), chaining_key_.end(), 0);
+    std::fill(cipher_key_.begin(), cipher_key_.end(), 0);
+    return false;
+}
+
+} // namespace mesh::crypto
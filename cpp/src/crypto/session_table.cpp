@@ -0,0 +1,208 @@
+#include "mesh/crypto/session_table.hpp"
+#include "mesh/crypto/noise.hpp"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace mesh::crypto {
+
+SessionTable::SessionTable(size_t capacity)
+    : capacity_(std::clamp<size_t>(capacity, 1, kMaxCapacity)),
+      slots_(new Slot[capacity_]),
+      next_free_(new std::atomic<uint32_t>[capacity_]) {
+    // Chain every slot onto the free stack in index order
+    for (size_t i = 0; i < capacity_; ++i) {
+        uint32_t next = i + 1 < capacity_ ? static_cast<uint32_t>(i + 1) : kEmptyStack;
+        next_free_[i].store(next, std::memory_order_relaxed);
+    }
+    free_head_.store(0, std::memory_order_release);
+}
+
+SessionTable::~SessionTable() {
+    // Scrub key material before the slots are released
+    for (size_t i = 0; i < capacity_; ++i) {
+        for (auto& word : slots_[i].words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+SessionId SessionTable::insert(const Entry& entry) {
+    uint32_t index;
+    if (!popFree(index)) {
+        return kInvalidSessionId;
+    }
+
+    Slot& slot = slots_[index];
+    lockSlot(slot);
+
+    uint64_t words[kKeyWords];
+    std::memcpy(words, &entry, sizeof(Entry));
+    for (size_t i = 0; i < kKeyWords; ++i) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    // Generation 0 is reserved so that no issued id equals kInvalidSessionId
+    if (++slot.generation == 0) {
+        slot.generation = 1;
+    }
+    slot.send_counter.store(0, std::memory_order_relaxed);
+    slot.tag.store(slot.generation, std::memory_order_relaxed);
+
+    unlockSlot(slot);
+    size_.fetch_add(1, std::memory_order_relaxed);
+
+    return (static_cast<SessionId>(slot.generation) << 16) | index;
+}
+
+SessionId SessionTable::insert(const NoiseHandshake& handshake) {
+    if (!handshake.isComplete()) {
+        return kInvalidSessionId;
+    }
+
+    const SessionKey& send_key = handshake.getSendKey();
+    const SessionKey& receive_key = handshake.getReceiveKey();
+    if (send_key.size() != 32 || receive_key.size() != 32) {
+        return kInvalidSessionId;
+    }
+
+    Entry entry;
+    entry.peer_key = handshake.getRemoteStaticKey();
+    std::copy(send_key.begin(), send_key.end(), entry.send_key.begin());
+    std::copy(receive_key.begin(), receive_key.end(), entry.receive_key.begin());
+    return insert(entry);
+}
+
+bool SessionTable::evict(SessionId id) {
+    uint32_t index = indexOf(id);
+    if (id == kInvalidSessionId || index >= capacity_) {
+        return false;
+    }
+
+    Slot& slot = slots_[index];
+    lockSlot(slot);
+
+    if (slot.tag.load(std::memory_order_relaxed) != tagOf(id)) {
+        unlockSlot(slot);
+        return false;
+    }
+
+    slot.tag.store(0, std::memory_order_relaxed);
+    for (auto& word : slot.words) {
+        word.store(0, std::memory_order_relaxed);
+    }
+
+    unlockSlot(slot);
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    pushFree(index);
+    return true;
+}
+
+bool SessionTable::lookup(SessionId id, Entry& out) const {
+    uint32_t index = indexOf(id);
+    if (id == kInvalidSessionId || index >= capacity_) {
+        return false;
+    }
+
+    const Slot& slot = slots_[index];
+    uint64_t words[kKeyWords];
+
+    while (true) {
+        uint32_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+
+        bool match = slot.tag.load(std::memory_order_relaxed) == tagOf(id);
+        for (size_t i = 0; i < kKeyWords; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before) {
+            continue;
+        }
+
+        if (!match) {
+            return false;
+        }
+        std::memcpy(&out, words, sizeof(Entry));
+        return true;
+    }
+}
+
+bool SessionTable::nextSendCounter(SessionId id, uint64_t& counter) {
+    uint32_t index = indexOf(id);
+    if (id == kInvalidSessionId || index >= capacity_) {
+        return false;
+    }
+
+    Slot& slot = slots_[index];
+    uint32_t before = slot.sequence.load(std::memory_order_acquire);
+    if ((before & 1) || slot.tag.load(std::memory_order_relaxed) != tagOf(id)) {
+        return false;
+    }
+
+    // An evict and insert between the tag check and the increment would
+    // hand out the next session's counter under this id. insert() resets
+    // the counter inside its write section, so a reserved value that came
+    // from a reset is always paired with a moved sequence; such a counter
+    // is discarded (the new session merely skips it) and the call fails.
+    counter = slot.send_counter.fetch_add(1, std::memory_order_acq_rel);
+    return slot.sequence.load(std::memory_order_acquire) == before;
+}
+
+void SessionTable::lockSlot(Slot& slot) {
+    uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    while (true) {
+        if (!(sequence & 1) &&
+            slot.sequence.compare_exchange_weak(sequence, sequence + 1,
+                                                std::memory_order_acquire,
+                                                std::memory_order_relaxed)) {
+            break;
+        }
+        if (sequence & 1) {
+            std::this_thread::yield();
+            sequence = slot.sequence.load(std::memory_order_relaxed);
+        }
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void SessionTable::unlockSlot(Slot& slot) {
+    slot.sequence.fetch_add(1, std::memory_order_release);
+}
+
+bool SessionTable::popFree(uint32_t& index) {
+    uint64_t head = free_head_.load(std::memory_order_acquire);
+    while (true) {
+        uint32_t top = static_cast<uint32_t>(head);
+        if (top == kEmptyStack) {
+            return false;
+        }
+
+        uint64_t next = ((head >> 32) + 1) << 32 |
+                        next_free_[top].load(std::memory_order_relaxed);
+        if (free_head_.compare_exchange_weak(head, next,
+                                             std::memory_order_acquire,
+                                             std::memory_order_acquire)) {
+            index = top;
+            return true;
+        }
+    }
+}
+
+void SessionTable::pushFree(uint32_t index) {
+    uint64_t head = free_head_.load(std::memory_order_relaxed);
+    while (true) {
+        next_free_[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        uint64_t next = ((head >> 32) + 1) << 32 | index;
+        if (free_head_.compare_exchange_weak(head, next,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+} // namespace mesh::crypto
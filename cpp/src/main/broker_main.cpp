@@ -1,42 +1,76 @@
 #include <iostream>
 #include <csignal>
 #include <memory>
+#include <string>
+#include <vector>
 #include "mesh/broker/broker.hpp"
+#include "mesh/broker/wakeup.hpp"
 
 std::unique_ptr<mesh::broker::Broker> g_broker;
+std::unique_ptr<mesh::broker::EventFd> g_shutdown;
+volatile std::sig_atomic_t g_signal = 0;
 
+// Only async-signal-safe work here; main wakes up and shuts down
 void signalHandler(int signal) {
-    std::cout << "\nReceived signal " << signal << ", shutting down...\n";
-    if (g_broker) {
-        g_broker->stop();
-    }
-    std::exit(0);
+    g_signal = signal;
+    g_shutdown->notify();
 }
 
 int main(int argc, char* argv[]) {
-    std::string adapter = "emulated";
+    std::vector<std::string> adapters;
+    std::string spool_dir;
     int port = 8081;
 
-    // Parse arguments (simplified)
+    // Parse arguments (simplified); --adapter may repeat or take a
+    // comma-separated list to bridge several adapters in one process
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "--adapter" && i + 1 < argc) {
-            adapter = argv[++i];
+            std::string list = argv[++i];
+            size_t start = 0;
+            while (start <= list.size()) {
+                size_t end = list.find(',', start);
+                if (end == std::string::npos) {
+                    end = list.size();
+                }
+                if (end > start) {
+                    adapters.push_back(list.substr(start, end - start));
+                }
+                start = end + 1;
+            }
         } else if (arg == "--port" && i + 1 < argc) {
             port = std::stoi(argv[++i]);
+        } else if (arg == "--spool" && i + 1 < argc) {
+            spool_dir = argv[++i];
         }
     }
+    if (adapters.empty()) {
+        adapters.push_back("emulated");
+    }
 
     std::cout << "Katya Mesh C++ Broker\n";
-    std::cout << "Adapter: " << adapter << "\n";
+    std::cout << "Adapters:";
+    for (const auto& adapter : adapters) {
+        std::cout << " " << adapter;
+    }
+    std::cout << "\n";
     std::cout << "Port: " << port << "\n";
+    if (!spool_dir.empty()) {
+        std::cout << "Spool: " << spool_dir << "\n";
+    }
 
     // Setup signal handlers
+    g_shutdown = std::make_unique<mesh::broker::EventFd>();
     std::signal(SIGINT, signalHandler);
     std::signal(SIGTERM, signalHandler);
 
     // Create and start broker
-    g_broker = std::make_unique<mesh::broker::Broker>(adapter);
+    g_broker = std::make_unique<mesh::broker::Broker>(adapters);
+    if (!spool_dir.empty()) {
+        mesh::broker::MessageSpool::Config spool;
+        spool.directory = spool_dir;
+        g_broker->enableSpool(spool);
+    }
     if (!g_broker->start()) {
         std::cerr << "Failed to start broker\n";
         return 1;
@@ -45,16 +79,59 @@ int main(int argc, char* argv[]) {
     std::cout << "Broker started successfully\n";
     std::cout << "Press Ctrl+C to stop\n";
 
-    // Keep running
-    while (true) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        
+    // Sleep until the stats timer fires or a signal arrives
+    mesh::broker::TimerFd stats_timer(std::chrono::seconds(1));
+    for (;;) {
+        uint32_t ready = mesh::broker::waitReadable({stats_timer.fd(), g_shutdown->fd()});
+        if (ready & 2) {
+            std::cout << "\nReceived signal " << g_signal << ", shutting down...\n";
+            g_broker->stop();
+            break;
+        }
+        stats_timer.drain();
+
         // Print stats periodically
         auto stats = g_broker->getStats();
         if (stats.total_peers > 0 || stats.messages_in_queue > 0) {
             std::cout << "Stats - Peers: " << stats.total_peers 
                       << ", Queue: " << stats.messages_in_queue
                       << ", Success: " << stats.success_rate << "%\n";
+
+            static const char* const kClassNames[] = {"low", "normal", "high"};
+            std::cout << "Queue -";
+            for (size_t i = 0; i < stats.queue_classes.size(); ++i) {
+                const auto& queue = stats.queue_classes[i];
+                std::cout << " " << kClassNames[i] << ": " << queue.depth
+                          << " (avg wait " << queue.avg_wait_ms << "ms, max " << queue.max_wait_ms
+                          << "ms, rejected " << queue.rejected << ", blocked " << queue.blocked << ")";
+            }
+            std::cout << "\n";
+
+            auto printLatency = [](const char* name, const mesh::broker::LatencySummary& latency) {
+                std::cout << "  " << name << ": n=" << latency.count << " p50 " << latency.p50_us
+                          << "us, p90 " << latency.p90_us << "us, p99 " << latency.p99_us << "us, p999 "
+                          << latency.p999_us << "us, max " << latency.max_us << "us\n";
+            };
+            std::cout << "Latency -\n";
+            printLatency("enqueue->send", stats.enqueue_to_send.all);
+            printLatency("send->ack", stats.send_to_ack.all);
+            printLatency("end-to-end", stats.end_to_end.all);
+            for (size_t i = 0; i < stats.end_to_end.by_priority.size(); ++i) {
+                std::string name = std::string("end-to-end ") + kClassNames[i];
+                printLatency(name.c_str(), stats.end_to_end.by_priority[i]);
+            }
+
+            for (const auto& adapter : stats.adapters) {
+                std::cout << "Adapter " << adapter.name << " - queued " << adapter.queued
+                          << ", received " << adapter.received << ", sent " << adapter.sent
+                          << ", failed " << adapter.failed << ", dropped " << adapter.dropped << "\n";
+            }
+
+            if (stats.spool.pending > 0) {
+                std::cout << "Spool - pending " << stats.spool.pending << " for "
+                          << stats.spool.destinations << " peers, " << stats.spool.segments
+                          << " segments, " << stats.spool.disk_bytes / (1024 * 1024) << " MiB\n";
+            }
         }
     }
 
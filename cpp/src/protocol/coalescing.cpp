@@ -0,0 +1,128 @@
+#include "mesh/protocol/coalescing.hpp"
+#include "protocol/wire_format.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace mesh::protocol {
+
+bool BatchReader::reset(const uint8_t* data, size_t len) {
+    if (!data || !isBatch(data, len)) {
+        in_ = end_ = nullptr;
+        count_ = remaining_ = 0;
+        return false;
+    }
+    in_ = data + kBatchHeaderSize;
+    end_ = data + len;
+    count_ = remaining_ = data[1];
+    return true;
+}
+
+bool BatchReader::next(ByteView& frame) {
+    if (remaining_ == 0) {
+        return false;
+    }
+
+    uint64_t len;
+    if (!wire::readVarint(in_, end_, len) || len > static_cast<uint64_t>(end_ - in_)) {
+        remaining_ = 0;
+        return false;
+    }
+    frame = {in_, static_cast<size_t>(len)};
+    in_ += len;
+    --remaining_;
+    return true;
+}
+
+Coalescer::Coalescer(const Config& config, SendFn send)
+    : config_(config), send_(std::move(send)) {
+    config_.max_batch_count = std::min(std::max<size_t>(config_.max_batch_count, 1), kMaxBatchCount);
+}
+
+void Coalescer::submit(uint64_t next_hop, const uint8_t* frame, size_t len, Clock::time_point now) {
+    ++stats_.messages;
+
+    size_t entry_size = wire::varintSize(len) + len;
+    if (len > config_.max_message_bytes || kBatchHeaderSize + entry_size > config_.max_batch_bytes) {
+        flush(next_hop);
+        ++stats_.bypassed;
+        ++stats_.frames;
+        send_(next_hop, frame, len);
+        return;
+    }
+
+    Batch& batch = batches_[next_hop];
+    if (batch.count > 0 && batch.buffer.size() + entry_size > config_.max_batch_bytes) {
+        emit(next_hop, batch);
+    }
+    if (batch.count == 0) {
+        batch.buffer.resize(kBatchHeaderSize);
+        batch.buffer[0] = kBatchMarker;
+        batch.deadline = now + config_.max_delay;
+    }
+
+    size_t offset = batch.buffer.size();
+    batch.buffer.resize(offset + entry_size);
+    uint8_t* out = wire::writeVarint(batch.buffer.data() + offset, len);
+    std::copy(frame, frame + len, out);
+    ++batch.count;
+
+    if (batch.count >= config_.max_batch_count || batch.buffer.size() >= config_.max_batch_bytes) {
+        emit(next_hop, batch);
+    }
+}
+
+void Coalescer::emit(uint64_t next_hop, Batch& batch) {
+    if (batch.count == 0) {
+        return;
+    }
+
+    ++stats_.frames;
+    if (batch.count == 1) {
+        // A lone frame goes out bare, without the batch wrapper
+        const uint8_t* in = batch.buffer.data() + kBatchHeaderSize;
+        uint64_t len;
+        wire::readVarint(in, batch.buffer.data() + batch.buffer.size(), len);
+        send_(next_hop, in, static_cast<size_t>(len));
+    } else {
+        ++stats_.batches;
+        batch.buffer[1] = static_cast<uint8_t>(batch.count);
+        send_(next_hop, batch.buffer.data(), batch.buffer.size());
+    }
+
+    // Keep the buffer's capacity for the next batch to this hop
+    batch.buffer.clear();
+    batch.count = 0;
+}
+
+void Coalescer::poll(Clock::time_point now) {
+    for (auto& [next_hop, batch] : batches_) {
+        if (batch.count > 0 && now >= batch.deadline) {
+            emit(next_hop, batch);
+        }
+    }
+}
+
+Coalescer::Clock::time_point Coalescer::nextDeadline() const {
+    auto deadline = Clock::time_point::max();
+    for (const auto& entry : batches_) {
+        if (entry.second.count > 0) {
+            deadline = std::min(deadline, entry.second.deadline);
+        }
+    }
+    return deadline;
+}
+
+void Coalescer::flush(uint64_t next_hop) {
+    auto it = batches_.find(next_hop);
+    if (it != batches_.end()) {
+        emit(next_hop, it->second);
+    }
+}
+
+void Coalescer::flushAll() {
+    for (auto& [next_hop, batch] : batches_) {
+        emit(next_hop, batch);
+    }
+}
+
+} // namespace mesh::protocol
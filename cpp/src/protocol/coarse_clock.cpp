@@ -0,0 +1,20 @@
+#include "mesh/protocol/coarse_clock.hpp"
+#include <time.h>
+
+namespace mesh::protocol {
+
+CoarseClock::rep CoarseClock::read() {
+    rep millis;
+#ifdef CLOCK_MONOTONIC_COARSE
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    millis = static_cast<rep>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+#else
+    millis = std::chrono::duration_cast<duration>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    // Zero marks an empty cache; a clock reading of exactly zero is bumped
+    return millis != 0 ? millis : 1;
+}
+
+} // namespace mesh::protocol
@@ -0,0 +1,161 @@
+#include "mesh/protocol/codec.hpp"
+#include "mesh/protocol/message_view.hpp"
+#include "protocol/wire_format.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace mesh::protocol {
+
+using namespace wire;
+
+const char kBroadcastId[] = "broadcast";
+
+namespace {
+
+const char kHexDigits[] = "0123456789abcdef";
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Decodes exactly 2 * len hex digits
+bool parseHex(const std::string& text, uint8_t* out, size_t len) {
+    if (text.size() != 2 * len) {
+        return false;
+    }
+    for (size_t i = 0; i < len; ++i) {
+        int hi = hexValue(text[2 * i]);
+        int lo = hexValue(text[2 * i + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        out[i] = static_cast<uint8_t>(hi << 4 | lo);
+    }
+    return true;
+}
+
+size_t variableSize(const Message& message) {
+    size_t type_size = typeCode(message.type) == kNamedTypeCode
+                           ? varintSize(message.type.size()) + message.type.size() : 0;
+    return varintSize(zigzag(message.ttl)) +
+           varintSize(static_cast<uint64_t>(message.priority)) +
+           type_size +
+           varintSize(message.content.size()) + message.content.size();
+}
+
+bool writeNodeId(const std::string& text, uint8_t* out) {
+    if (text == kBroadcastId) {
+        std::memset(out, 0xFF, 32);
+        return true;
+    }
+    return parseHex(text, out, 32);
+}
+
+} // namespace
+
+bool parseNodeId(const std::string& text, NodeId& id) {
+    return writeNodeId(text, id.data());
+}
+
+std::string formatNodeId(const NodeId& id) {
+    if (std::all_of(id.begin(), id.end(), [](uint8_t b) { return b == 0xFF; })) {
+        return kBroadcastId;
+    }
+
+    std::string text;
+    text.reserve(64);
+    for (uint8_t b : id) {
+        text.push_back(kHexDigits[b >> 4]);
+        text.push_back(kHexDigits[b & 0x0F]);
+    }
+    return text;
+}
+
+size_t encodedSize(const Message& message) {
+    uint8_t scratch[32];
+    if (!writeNodeId(message.from_id, scratch) ||
+        !writeNodeId(message.to_id, scratch)) {
+        return 0;
+    }
+    return kWireHeaderSize + variableSize(message);
+}
+
+bool encodeMessage(const Message& message, uint8_t* buffer, size_t capacity, size_t& written) {
+    written = 0;
+    if (!buffer) {
+        return false;
+    }
+
+    // Exact size check up front, so a short buffer is never partially written
+    if (capacity < kWireHeaderSize + variableSize(message)) {
+        return false;
+    }
+
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+        message.timestamp.time_since_epoch()).count();
+
+    buffer[0] = kWireVersion;
+    buffer[1] = 0;
+    buffer[2] = typeCode(message.type);
+    buffer[3] = static_cast<uint8_t>(message.path.totalHops());
+    writeU64(buffer + 4, static_cast<uint64_t>(millis));
+    message.id.toBytes(buffer + 12);
+    if (!writeNodeId(message.from_id, buffer + kFromIdOffset) ||
+        !writeNodeId(message.to_id, buffer + kToIdOffset)) {
+        return false;
+    }
+
+    writeU64(buffer + kHopSummaryOffset, message.path.summary());
+    for (size_t i = 0; i < HopPath::kCapacity; ++i) {
+        writeU32(buffer + kHopsOffset + i * 4, i < message.path.size() ? message.path.at(i) : 0);
+    }
+
+    uint8_t* out = buffer + kWireHeaderSize;
+    out = writeVarint(out, zigzag(message.ttl));
+    out = writeVarint(out, static_cast<uint64_t>(message.priority));
+
+    if (buffer[2] == kNamedTypeCode) {
+        out = writeVarint(out, message.type.size());
+        std::memcpy(out, message.type.data(), message.type.size());
+        out += message.type.size();
+    }
+
+    out = writeVarint(out, message.content.size());
+    std::memcpy(out, message.content.data(), message.content.size());
+    out += message.content.size();
+
+    written = static_cast<size_t>(out - buffer);
+    return true;
+}
+
+bool decodeMessage(const uint8_t* data, size_t len, Message& message) {
+    MessageView view;
+    return view.parse(data, len) && view.toMessage(message);
+}
+
+bool appendHop(uint8_t* frame, size_t len, HopId hop) {
+    if (!frame || len < kWireHeaderSize || frame[0] != kWireVersion) {
+        return false;
+    }
+
+    size_t total = frame[3];
+    size_t held = std::min(total, HopPath::kCapacity);
+    uint8_t* hops = frame + kHopsOffset;
+    if (held == HopPath::kCapacity) {
+        std::memmove(hops, hops + 4, (HopPath::kCapacity - 1) * 4);
+        held = HopPath::kCapacity - 1;
+    }
+    writeU32(hops + held * 4, hop);
+
+    if (total < UINT8_MAX) {
+        frame[3] = static_cast<uint8_t>(total + 1);
+    }
+    writeU64(frame + kHopSummaryOffset,
+             readU64(frame + kHopSummaryOffset) | HopPath::summaryBits(hop));
+    return true;
+}
+
+} // namespace mesh::protocol
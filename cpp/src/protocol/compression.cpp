@@ -0,0 +1,248 @@
+#include "mesh/protocol/compression.hpp"
+#include "mesh/protocol/codec.hpp"
+#include "mesh/protocol/message_view.hpp"
+#include "protocol/wire_format.hpp"
+#include <zlib.h>
+#include <cstring>
+
+namespace mesh::protocol {
+
+// zlib weighs later dictionary bytes higher, so the most common text is last
+const std::string_view kChatDictionary =
+    "\"priority\":0,\"priority\":1,\"priority\":2,\"ttl\":10,\"hops\":"
+    "route_request route_reply route_error link_state peer_discovery "
+    "peer_announce key_exchange sender_key delivery_receipt read_receipt "
+    "typing presence online offline battery signal rssi channel group "
+    "poll vote proposal result heartbeat ping pong ack nack retry "
+    "\"fromId\":\"\"toId\":\"broadcast\"\"timestamp\":\"type\":\"chat\""
+    "\"message\":\"\"content\":\"\"id\":\"\"status\":\"ok\"\"error\":\""
+    "Sorry, I can't talk right now. Call me when you can. I'm on my way. "
+    "Where are you? Are you okay? I'm safe. Need help. Thank you! "
+    "Good morning! Good night. See you soon. What's up? How are you? "
+    "Yes, no problem. No, thanks. Okay, sounds good. Let me know. "
+    "Hello! Hi! Hey, thanks! ok, the and you to is it in that for of ";
+
+namespace {
+
+// Raw deflate: no zlib header or checksum
+constexpr int kWindowBits = -15;
+
+// Dictionary codecs serve short messages; a 4 KiB window still covers the
+// dictionary, and the smaller hash table makes each per-message reset cheap
+constexpr int kSmallWindowBits = -12;
+constexpr int kSmallMemLevel = 4;
+
+class DeflateCodec : public PayloadCodec {
+public:
+    DeflateCodec(uint8_t id, std::string_view dictionary, int level)
+        : id_(id), dictionary_(dictionary) {
+        bool small = !dictionary.empty();
+        deflate_ok_ = deflateInit2(&deflate_, level, Z_DEFLATED,
+                                   small ? kSmallWindowBits : kWindowBits,
+                                   small ? kSmallMemLevel : 8, Z_DEFAULT_STRATEGY) == Z_OK;
+        inflate_ok_ = inflateInit2(&inflate_, kWindowBits) == Z_OK;
+    }
+
+    ~DeflateCodec() override {
+        if (deflate_ok_) {
+            deflateEnd(&deflate_);
+        }
+        if (inflate_ok_) {
+            inflateEnd(&inflate_);
+        }
+    }
+
+    DeflateCodec(const DeflateCodec&) = delete;
+    DeflateCodec& operator=(const DeflateCodec&) = delete;
+
+    uint8_t id() const override { return id_; }
+
+    bool compress(const uint8_t* data, size_t len, std::vector<uint8_t>& out) override {
+        // Streams are reset rather than rebuilt, keeping zlib's window allocated
+        if (!deflate_ok_ || deflateReset(&deflate_) != Z_OK || !primeDeflate()) {
+            return false;
+        }
+
+        size_t start = out.size();
+        out.resize(start + deflateBound(&deflate_, static_cast<uLong>(len)));
+
+        deflate_.next_in = const_cast<Bytef*>(data);
+        deflate_.avail_in = static_cast<uInt>(len);
+        deflate_.next_out = out.data() + start;
+        deflate_.avail_out = static_cast<uInt>(out.size() - start);
+        if (::deflate(&deflate_, Z_FINISH) != Z_STREAM_END) {
+            out.resize(start);
+            return false;
+        }
+        out.resize(out.size() - deflate_.avail_out);
+        return true;
+    }
+
+    bool decompress(const uint8_t* data, size_t len, uint8_t* out, size_t out_len) override {
+        if (!inflate_ok_ || inflateReset(&inflate_) != Z_OK || !primeInflate()) {
+            return false;
+        }
+
+        inflate_.next_in = const_cast<Bytef*>(data);
+        inflate_.avail_in = static_cast<uInt>(len);
+        inflate_.next_out = out;
+        inflate_.avail_out = static_cast<uInt>(out_len);
+        int result = ::inflate(&inflate_, Z_FINISH);
+        return result == Z_STREAM_END && inflate_.avail_out == 0 && inflate_.avail_in == 0;
+    }
+
+private:
+    bool primeDeflate() {
+        return dictionary_.empty() ||
+               deflateSetDictionary(&deflate_, reinterpret_cast<const Bytef*>(dictionary_.data()),
+                                    static_cast<uInt>(dictionary_.size())) == Z_OK;
+    }
+
+    bool primeInflate() {
+        return dictionary_.empty() ||
+               inflateSetDictionary(&inflate_, reinterpret_cast<const Bytef*>(dictionary_.data()),
+                                    static_cast<uInt>(dictionary_.size())) == Z_OK;
+    }
+
+    uint8_t id_;
+    std::string dictionary_;
+    z_stream deflate_{};
+    z_stream inflate_{};
+    bool deflate_ok_ = false;
+    bool inflate_ok_ = false;
+};
+
+// Length of the frame up to (not including) the content length prefix
+bool contentPrefix(const MessageView& view, size_t& prefix) {
+    ByteView content = view.contentBytes();
+    const uint8_t* frame = view.frame().data;
+    size_t length_size = wire::varintSize(content.size);
+    prefix = static_cast<size_t>(content.data - frame) - length_size;
+
+    // Reject non-minimal length prefixes so the rewrite is exact
+    const uint8_t* in = frame + prefix;
+    uint64_t value;
+    return wire::readVarint(in, content.data, value) && in == content.data &&
+           value == content.size;
+}
+
+} // namespace
+
+std::unique_ptr<PayloadCodec> makeDeflateCodec(uint8_t id, std::string_view dictionary, int level) {
+    return std::make_unique<DeflateCodec>(id, dictionary, level);
+}
+
+CompressionStage::CompressionStage() : CompressionStage(Config()) {}
+
+CompressionStage::CompressionStage(const Config& config) : config_(config) {
+    registerCodec(makeDeflateCodec(kCodecDeflate));
+    registerCodec(makeDeflateCodec(kCodecChatDictionary, kChatDictionary, 9));
+}
+
+CompressionStage::~CompressionStage() = default;
+
+void CompressionStage::registerCodec(std::unique_ptr<PayloadCodec> codec) {
+    if (codec) {
+        uint8_t id = codec->id();
+        codecs_[id] = std::move(codec);
+    }
+}
+
+PayloadCodec* CompressionStage::findCodec(uint8_t id) const {
+    return codecs_[id].get();
+}
+
+bool CompressionStage::compressFrame(const uint8_t* frame, size_t len, std::vector<uint8_t>& out,
+                                     bool* wasCompressed) {
+    if (wasCompressed) {
+        *wasCompressed = false;
+    }
+
+    MessageView view;
+    size_t prefix;
+    if (!view.parse(frame, len) || !contentPrefix(view, prefix)) {
+        return false;
+    }
+
+    ByteView content = view.contentBytes();
+    PayloadCodec* codec = findCodec(content.size <= config_.dictionary_max_size
+                                        ? small_codec_ : large_codec_);
+    if (view.isCompressed() || content.size < config_.min_size ||
+        content.size > config_.max_content_size || !codec) {
+        out.assign(frame, frame + len);
+        return true;
+    }
+
+    uint8_t header[1 + kMaxVarintSize];
+    header[0] = codec->id();
+    size_t header_size = static_cast<size_t>(wire::writeVarint(header + 1, content.size) - header);
+
+    scratch_.clear();
+    scratch_.insert(scratch_.end(), header, header + header_size);
+    if (!codec->compress(content.data, content.size, scratch_) || scratch_.size() >= content.size) {
+        out.assign(frame, frame + len);
+        return true;
+    }
+
+    out.resize(prefix + wire::varintSize(scratch_.size()) + scratch_.size());
+    std::memcpy(out.data(), frame, prefix);
+    out[1] |= kFlagCompressed;
+    uint8_t* body = wire::writeVarint(out.data() + prefix, scratch_.size());
+    std::memcpy(body, scratch_.data(), scratch_.size());
+
+    if (wasCompressed) {
+        *wasCompressed = true;
+    }
+    return true;
+}
+
+bool CompressionStage::decompressFrame(const uint8_t* frame, size_t len, std::vector<uint8_t>& out) {
+    MessageView view;
+    size_t prefix;
+    if (!view.parse(frame, len) || !contentPrefix(view, prefix)) {
+        return false;
+    }
+    if (!view.isCompressed()) {
+        out.assign(frame, frame + len);
+        return true;
+    }
+
+    ByteView content = view.contentBytes();
+    if (content.empty()) {
+        return false;
+    }
+    const uint8_t* in = content.data + 1;
+    uint64_t original_size;
+    if (!wire::readVarint(in, content.end(), original_size) ||
+        original_size > config_.max_content_size) {
+        return false;
+    }
+    PayloadCodec* codec = findCodec(content.data[0]);
+    if (!codec) {
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(original_size);
+    out.resize(prefix + wire::varintSize(size) + size);
+    std::memcpy(out.data(), frame, prefix);
+    out[1] &= static_cast<uint8_t>(~kFlagCompressed);
+    uint8_t* body = wire::writeVarint(out.data() + prefix, size);
+    return codec->decompress(in, static_cast<size_t>(content.end() - in), body, size);
+}
+
+bool CompressionStage::encode(const Message& message, std::vector<uint8_t>& out) {
+    std::vector<uint8_t> plain(encodedSize(message));
+    size_t written = 0;
+    return !plain.empty() &&
+           encodeMessage(message, plain.data(), plain.size(), written) &&
+           compressFrame(plain.data(), written, out);
+}
+
+bool CompressionStage::decode(const uint8_t* frame, size_t len, Message& message) {
+    if (!decompressFrame(frame, len, scratch_)) {
+        return false;
+    }
+    return decodeMessage(scratch_.data(), scratch_.size(), message);
+}
+
+} // namespace mesh::protocol
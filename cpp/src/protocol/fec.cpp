@@ -0,0 +1,529 @@
+#include "mesh/protocol/fec.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <unordered_set>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MESH_FEC_X86 1
+#include <tmmintrin.h>
+#endif
+
+namespace mesh::protocol {
+
+namespace gf256 {
+
+namespace {
+
+struct Tables {
+    uint8_t exp[510];
+    uint8_t log[256];
+    uint8_t product[256][256];
+};
+
+constexpr Tables makeTables() {
+    Tables tables{};
+    unsigned x = 1;
+    for (unsigned i = 0; i < 255; ++i) {
+        tables.exp[i] = static_cast<uint8_t>(x);
+        tables.exp[i + 255] = static_cast<uint8_t>(x);
+        tables.log[x] = static_cast<uint8_t>(i);
+        x <<= 1;
+        if (x & 0x100) {
+            x ^= 0x11d;
+        }
+    }
+    for (unsigned a = 1; a < 256; ++a) {
+        for (unsigned b = 1; b < 256; ++b) {
+            tables.product[a][b] = tables.exp[tables.log[a] + tables.log[b]];
+        }
+    }
+    return tables;
+}
+
+constexpr Tables kTables = makeTables();
+
+} // namespace
+
+uint8_t mul(uint8_t a, uint8_t b) {
+    return kTables.product[a][b];
+}
+
+uint8_t inv(uint8_t a) {
+    return a == 0 ? 0 : kTables.exp[255 - kTables.log[a]];
+}
+
+void mulAddRegionScalar(uint8_t* dst, const uint8_t* src, uint8_t c, size_t len) {
+    if (c == 0) {
+        return;
+    }
+    const uint8_t* row = kTables.product[c];
+    for (size_t i = 0; i < len; ++i) {
+        dst[i] ^= row[src[i]];
+    }
+}
+
+#if defined(MESH_FEC_X86)
+
+namespace {
+
+// Built for SSSE3 whatever the baseline flags, and only called once the
+// CPU has been checked
+__attribute__((target("ssse3")))
+void mulAddRegionPshufb(uint8_t* dst, const uint8_t* src, const uint8_t* row, size_t len) {
+    // Products of c with every low and high nibble; c * s is the xor of the two
+    alignas(16) uint8_t low[16];
+    alignas(16) uint8_t high[16];
+    for (unsigned n = 0; n < 16; ++n) {
+        low[n] = row[n];
+        high[n] = row[n << 4];
+    }
+    const __m128i low_table = _mm_load_si128(reinterpret_cast<const __m128i*>(low));
+    const __m128i high_table = _mm_load_si128(reinterpret_cast<const __m128i*>(high));
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i lo = _mm_shuffle_epi8(low_table, _mm_and_si128(s, mask));
+        __m128i hi = _mm_shuffle_epi8(high_table, _mm_and_si128(_mm_srli_epi64(s, 4), mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(d, _mm_xor_si128(lo, hi)));
+    }
+    for (; i < len; ++i) {
+        dst[i] ^= row[src[i]];
+    }
+}
+
+bool hasSsse3() {
+    static const bool has = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3") != 0;
+    }();
+    return has;
+}
+
+} // namespace
+
+bool mulAddRegionSsse3(uint8_t* dst, const uint8_t* src, uint8_t c, size_t len) {
+    if (!hasSsse3()) {
+        return false;
+    }
+    if (c != 0) {
+        mulAddRegionPshufb(dst, src, kTables.product[c], len);
+    }
+    return true;
+}
+
+#else
+
+bool mulAddRegionSsse3(uint8_t*, const uint8_t*, uint8_t, size_t) {
+    return false;
+}
+
+#endif
+
+void mulAddRegion(uint8_t* dst, const uint8_t* src, uint8_t c, size_t len) {
+    if (!mulAddRegionSsse3(dst, src, c, len)) {
+        mulAddRegionScalar(dst, src, c, len);
+    }
+}
+
+} // namespace gf256
+
+namespace {
+
+struct ShardHeader {
+    uint16_t stream;
+    uint8_t index;
+    uint8_t k;
+    uint8_t n;
+    size_t total;
+};
+
+void writeHeader(uint8_t* out, const ShardHeader& header) {
+    out[0] = kFecMarker;
+    out[1] = static_cast<uint8_t>(header.stream);
+    out[2] = static_cast<uint8_t>(header.stream >> 8);
+    out[3] = header.index;
+    out[4] = header.k;
+    out[5] = header.n;
+    out[6] = static_cast<uint8_t>(header.total);
+    out[7] = static_cast<uint8_t>(header.total >> 8);
+    out[8] = static_cast<uint8_t>(header.total >> 16);
+}
+
+ShardHeader readHeader(const uint8_t* in) {
+    ShardHeader header;
+    header.stream = static_cast<uint16_t>(in[1] | in[2] << 8);
+    header.index = in[3];
+    header.k = in[4];
+    header.n = in[5];
+    header.total = static_cast<size_t>(in[6]) | static_cast<size_t>(in[7]) << 8 |
+                   static_cast<size_t>(in[8]) << 16;
+    return header;
+}
+
+// Generator entry for parity row r and data column j. Points k + r and j
+// are distinct, so every square submatrix is invertible.
+uint8_t cauchy(size_t k, size_t r, size_t j) {
+    return gf256::inv(static_cast<uint8_t>((k + r) ^ j));
+}
+
+// Gauss-Jordan inversion of a size x size matrix in place; false if singular
+bool invert(std::vector<uint8_t>& matrix, size_t size) {
+    std::vector<uint8_t> inverse(size * size, 0);
+    for (size_t i = 0; i < size; ++i) {
+        inverse[i * size + i] = 1;
+    }
+
+    for (size_t col = 0; col < size; ++col) {
+        size_t pivot = col;
+        while (pivot < size && matrix[pivot * size + col] == 0) {
+            ++pivot;
+        }
+        if (pivot == size) {
+            return false;
+        }
+        if (pivot != col) {
+            std::swap_ranges(matrix.begin() + pivot * size, matrix.begin() + (pivot + 1) * size,
+                             matrix.begin() + col * size);
+            std::swap_ranges(inverse.begin() + pivot * size, inverse.begin() + (pivot + 1) * size,
+                             inverse.begin() + col * size);
+        }
+
+        uint8_t scale = gf256::inv(matrix[col * size + col]);
+        for (size_t j = 0; j < size; ++j) {
+            matrix[col * size + j] = gf256::mul(matrix[col * size + j], scale);
+            inverse[col * size + j] = gf256::mul(inverse[col * size + j], scale);
+        }
+
+        for (size_t row = 0; row < size; ++row) {
+            uint8_t factor = matrix[row * size + col];
+            if (row == col || factor == 0) {
+                continue;
+            }
+            gf256::mulAddRegion(&matrix[row * size], &matrix[col * size], factor, size);
+            gf256::mulAddRegion(&inverse[row * size], &inverse[col * size], factor, size);
+        }
+    }
+
+    matrix.swap(inverse);
+    return true;
+}
+
+} // namespace
+
+void LossEstimator::record(size_t sent, size_t lost) {
+    if (sent == 0) {
+        return;
+    }
+    double sample = static_cast<double>(std::min(lost, sent)) / static_cast<double>(sent);
+    loss_rate_ += alpha_ * (sample - loss_rate_);
+}
+
+FecEncoder::FecEncoder(size_t mtu) : FecEncoder(mtu, Config()) {}
+
+FecEncoder::FecEncoder(size_t mtu, const Config& config) : mtu_(mtu), config_(config) {}
+
+size_t FecEncoder::dataShardCount(size_t len) const {
+    if (mtu_ <= kFecHeaderSize || len == 0 || len > kMaxFecFrameSize) {
+        return 0;
+    }
+    size_t payload = mtu_ - kFecHeaderSize;
+    size_t count = (len + payload - 1) / payload;
+    return count <= kMaxFecShards ? count : 0;
+}
+
+size_t FecEncoder::parityShardCount(size_t data_shards, double loss_rate) const {
+    if (data_shards == 0 || data_shards > kMaxFecShards) {
+        return 0;
+    }
+    size_t limit = std::min(config_.max_parity, kMaxFecShards - data_shards);
+    size_t parity = std::min(config_.min_parity, limit);
+    if (loss_rate <= 0.0) {
+        return parity;
+    }
+    if (loss_rate >= 1.0) {
+        return limit;
+    }
+
+    // Smallest m with P(more than m of k + m shards lost) <= target_failure
+    double ratio = loss_rate / (1.0 - loss_rate);
+    for (; parity < limit; ++parity) {
+        size_t n = data_shards + parity;
+        double term = 1.0;
+        for (size_t i = 0; i < n; ++i) {
+            term *= 1.0 - loss_rate;
+        }
+        double delivered = 0.0;
+        for (size_t i = 0; i <= parity; ++i) {
+            delivered += term;
+            term *= ratio * static_cast<double>(n - i) / static_cast<double>(i + 1);
+        }
+        if (1.0 - delivered <= config_.target_failure) {
+            break;
+        }
+    }
+    return parity;
+}
+
+size_t FecEncoder::encode(const uint8_t* frame, size_t len, uint16_t stream, double loss_rate,
+                          std::vector<std::vector<uint8_t>>& shards) {
+    size_t k = dataShardCount(len);
+    if (!frame || k == 0) {
+        return 0;
+    }
+    size_t m = parityShardCount(k, loss_rate);
+    size_t n = k + m;
+    size_t shard_size = (len + k - 1) / k;
+
+    shards.resize(n);
+    for (size_t index = 0; index < n; ++index) {
+        auto& shard = shards[index];
+        shard.assign(kFecHeaderSize + shard_size, 0);
+        writeHeader(shard.data(), {stream, static_cast<uint8_t>(index), static_cast<uint8_t>(k),
+                                   static_cast<uint8_t>(n), len});
+        if (index < k) {
+            size_t offset = index * shard_size;
+            std::memcpy(shard.data() + kFecHeaderSize, frame + offset, std::min(shard_size, len - offset));
+        }
+    }
+
+    // Data shards are already padded in place, so parity reads them directly
+    for (size_t r = 0; r < m; ++r) {
+        uint8_t* parity = shards[k + r].data() + kFecHeaderSize;
+        for (size_t j = 0; j < k; ++j) {
+            gf256::mulAddRegion(parity, shards[j].data() + kFecHeaderSize, cauchy(k, r, j), shard_size);
+        }
+    }
+    return n;
+}
+
+FecDecoder::FecDecoder() : FecDecoder(Config()) {}
+
+FecDecoder::FecDecoder(const Config& config) : config_(config) {}
+
+FecDecoder::Result FecDecoder::receive(uint64_t source, const uint8_t* shard, size_t len,
+                                       std::vector<uint8_t>& frame) {
+    if (!shard || !isFecShard(shard, len)) {
+        ++stats_.invalid;
+        return Result::Invalid;
+    }
+
+    ShardHeader header = readHeader(shard);
+    if (header.k == 0 || header.n < header.k || header.index >= header.n || header.total < header.k) {
+        ++stats_.invalid;
+        return Result::Invalid;
+    }
+    size_t shard_size = (header.total + header.k - 1) / header.k;
+    if (len - kFecHeaderSize != shard_size) {
+        ++stats_.invalid;
+        return Result::Invalid;
+    }
+    const uint8_t* payload = shard + kFecHeaderSize;
+
+    auto now = CoarseClock::now();
+    StreamKey key{source, header.stream};
+    auto it = partials_.find(key);
+    if (it != partials_.end() && it->second.done &&
+        (it->second.k != header.k || it->second.n != header.n || it->second.total != header.total)) {
+        // The sender's stream id wrapped onto a finished stream
+        partials_.erase(it);
+        it = partials_.end();
+    }
+    if (it == partials_.end()) {
+        size_t parity_slots = std::min<size_t>(header.k, header.n - header.k);
+        size_t bytes = (header.k + parity_slots) * shard_size;
+        if (!reserve(bytes, now)) {
+            return Result::OverBudget;
+        }
+        Partial partial;
+        if (!spare_buffers_.empty()) {
+            partial.data = std::move(spare_buffers_.back());
+            spare_buffers_.pop_back();
+        }
+        partial.data.resize(header.k * shard_size);
+        partial.parity.reserve(parity_slots * shard_size);
+        partial.reserved = bytes;
+        partial.total = header.total;
+        partial.shard_size = shard_size;
+        partial.k = header.k;
+        partial.n = header.n;
+        partial.deadline = now + config_.timeout;
+        partial.generation = ++next_generation_;
+        it = partials_.emplace(key, std::move(partial)).first;
+        reserved_ += bytes;
+    } else if (it->second.k != header.k || it->second.n != header.n || it->second.total != header.total) {
+        ++stats_.invalid;
+        return Result::Invalid;
+    }
+
+    Partial& partial = it->second;
+    uint64_t bit = uint64_t(1) << (header.index & 63);
+    uint64_t& word = partial.received[header.index >> 6];
+    if (partial.done || (word & bit)) {
+        ++stats_.duplicates;
+        return Result::Duplicate;
+    }
+    word |= bit;
+
+    if (header.index < header.k) {
+        std::memcpy(partial.data.data() + header.index * shard_size, payload, shard_size);
+    } else {
+        partial.parity.insert(partial.parity.end(), payload, payload + shard_size);
+        partial.parity_rows.push_back(static_cast<uint8_t>(header.index - header.k));
+    }
+    if (++partial.have < partial.k) {
+        return Result::Incomplete;
+    }
+
+    if (!partial.parity_rows.empty()) {
+        recover(partial);
+        ++stats_.recovered;
+    }
+    partial.data.resize(partial.total);
+    frame = std::move(partial.data);
+    release(key, partial);
+    ++stats_.completed;
+    return Result::Complete;
+}
+
+void FecDecoder::recover(Partial& partial) {
+    size_t k = partial.k;
+    size_t size = partial.shard_size;
+
+    std::vector<size_t> missing;
+    for (size_t j = 0; j < k; ++j) {
+        if (!(partial.received[j >> 6] & (uint64_t(1) << (j & 63)))) {
+            missing.push_back(j);
+        }
+    }
+
+    // Strip the data shards we have from each parity shard, leaving a
+    // system in the missing ones only
+    size_t count = missing.size();
+    for (size_t a = 0; a < count; ++a) {
+        uint8_t* syndrome = partial.parity.data() + a * size;
+        for (size_t j = 0, next = 0; j < k; ++j) {
+            if (next < count && missing[next] == j) {
+                ++next;
+                continue;
+            }
+            gf256::mulAddRegion(syndrome, partial.data.data() + j * size,
+                                cauchy(k, partial.parity_rows[a], j), size);
+        }
+    }
+
+    std::vector<uint8_t> matrix(count * count);
+    for (size_t a = 0; a < count; ++a) {
+        for (size_t b = 0; b < count; ++b) {
+            matrix[a * count + b] = cauchy(k, partial.parity_rows[a], missing[b]);
+        }
+    }
+    // A Cauchy submatrix is never singular
+    invert(matrix, count);
+
+    for (size_t b = 0; b < count; ++b) {
+        uint8_t* out = partial.data.data() + missing[b] * size;
+        std::memset(out, 0, size);
+        for (size_t a = 0; a < count; ++a) {
+            gf256::mulAddRegion(out, partial.parity.data() + a * size, matrix[b * count + a], size);
+        }
+    }
+}
+
+bool FecDecoder::reserve(size_t bytes, CoarseClock::time_point now) {
+    if (bytes > config_.memory_budget) {
+        return false;
+    }
+    if (reserved_ + bytes <= config_.memory_budget) {
+        return true;
+    }
+
+    sweep(now);
+    while (reserved_ + bytes > config_.memory_budget) {
+        auto oldest = partials_.end();
+        for (auto it = partials_.begin(); it != partials_.end(); ++it) {
+            if (!it->second.done && (oldest == partials_.end() || it->second.deadline < oldest->second.deadline)) {
+                oldest = it;
+            }
+        }
+        if (oldest == partials_.end()) {
+            break;
+        }
+        release(oldest->first, oldest->second);
+        ++stats_.evicted;
+    }
+    return true;
+}
+
+void FecDecoder::recycle(std::vector<uint8_t>&& buffer) {
+    // Spares sit outside the budget, so keep only modest ones
+    if (spare_buffers_.size() < kMaxSpareBuffers && buffer.capacity() > 0 &&
+        buffer.capacity() <= config_.memory_budget / kMaxSpareBuffers) {
+        spare_buffers_.push_back(std::move(buffer));
+    }
+}
+
+void FecDecoder::release(const StreamKey& key, Partial& partial) {
+    // Keep the entry as a tombstone so late shards are recognised
+    reserved_ -= partial.reserved;
+    partial.reserved = 0;
+    partial.done = true;
+    partial.data = {};
+    partial.parity = {};
+    partial.parity_rows = {};
+
+    // Tombstones sit outside the budget, so only the source's most recent
+    // ones are kept; an id already reopened by a new stream is left alone
+    std::deque<Finished>& finished = finished_[key.source];
+    finished.push_back(Finished{key.stream, partial.generation});
+    if (finished.size() > kMaxFinishedPerSource) {
+        Finished oldest = finished.front();
+        finished.pop_front();
+        auto it = partials_.find(StreamKey{key.source, oldest.stream});
+        if (it != partials_.end() && it->second.generation == oldest.generation) {
+            partials_.erase(it);
+        }
+    }
+}
+
+size_t FecDecoder::sweep(CoarseClock::time_point now) {
+    size_t dropped = 0;
+    for (auto it = partials_.begin(); it != partials_.end();) {
+        if (now >= it->second.deadline) {
+            if (!it->second.done) {
+                reserved_ -= it->second.reserved;
+                ++dropped;
+            }
+            it = partials_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // Forget the finish order of sources with nothing left to remember
+    std::unordered_set<uint64_t> sources;
+    for (const auto& entry : partials_) {
+        sources.insert(entry.first.source);
+    }
+    for (auto it = finished_.begin(); it != finished_.end();) {
+        it = sources.count(it->first) ? std::next(it) : finished_.erase(it);
+    }
+    stats_.expired += dropped;
+    return dropped;
+}
+
+FecDecoder::Stats FecDecoder::getStats() const {
+    Stats stats = stats_;
+    for (const auto& entry : partials_) {
+        if (!entry.second.done) {
+            ++stats.partial_streams;
+        } else {
+            ++stats.finished_streams;
+        }
+    }
+    stats.reserved_bytes = reserved_;
+    return stats;
+}
+
+} // namespace mesh::protocol
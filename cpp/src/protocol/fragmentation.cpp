@@ -0,0 +1,205 @@
+#include "mesh/protocol/fragmentation.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace mesh::protocol {
+
+namespace {
+
+struct FragmentHeader {
+    uint16_t stream;
+    uint8_t index;
+    uint8_t count;
+    size_t total;
+};
+
+void writeHeader(uint8_t* out, const FragmentHeader& header) {
+    out[0] = kFragmentMarker;
+    out[1] = static_cast<uint8_t>(header.stream);
+    out[2] = static_cast<uint8_t>(header.stream >> 8);
+    out[3] = header.index;
+    out[4] = header.count;
+    out[5] = static_cast<uint8_t>(header.total);
+    out[6] = static_cast<uint8_t>(header.total >> 8);
+    out[7] = static_cast<uint8_t>(header.total >> 16);
+}
+
+FragmentHeader readHeader(const uint8_t* in) {
+    FragmentHeader header;
+    header.stream = static_cast<uint16_t>(in[1] | in[2] << 8);
+    header.index = in[3];
+    header.count = in[4];
+    header.total = static_cast<size_t>(in[5]) | static_cast<size_t>(in[6]) << 8 |
+                   static_cast<size_t>(in[7]) << 16;
+    return header;
+}
+
+// Payload carried by every fragment except the last
+size_t stride(size_t total, size_t count) {
+    return (total + count - 1) / count;
+}
+
+} // namespace
+
+Fragmenter::Fragmenter(size_t mtu) : mtu_(mtu) {}
+
+size_t Fragmenter::fragmentCount(size_t len) const {
+    if (mtu_ <= kFragmentHeaderSize || len == 0 || len > kMaxFragmentedSize) {
+        return 0;
+    }
+    size_t payload = mtu_ - kFragmentHeaderSize;
+    size_t count = (len + payload - 1) / payload;
+    return count <= kMaxFragmentCount ? count : 0;
+}
+
+size_t Fragmenter::writeFragment(const uint8_t* frame, size_t len, uint16_t stream, size_t index,
+                                 uint8_t* out) const {
+    size_t count = fragmentCount(len);
+    if (!frame || !out || index >= count) {
+        return 0;
+    }
+
+    size_t step = stride(len, count);
+    size_t offset = index * step;
+    size_t size = std::min(step, len - offset);
+
+    writeHeader(out, {stream, static_cast<uint8_t>(index), static_cast<uint8_t>(count), len});
+    std::memcpy(out + kFragmentHeaderSize, frame + offset, size);
+    return kFragmentHeaderSize + size;
+}
+
+Reassembler::Reassembler() : Reassembler(Config()) {}
+
+Reassembler::Reassembler(const Config& config) : config_(config) {}
+
+Reassembler::Result Reassembler::receive(uint64_t source, const uint8_t* fragment, size_t len,
+                                         std::vector<uint8_t>& frame) {
+    if (!fragment || !isFragment(fragment, len)) {
+        ++stats_.invalid;
+        return Result::Invalid;
+    }
+
+    FragmentHeader header = readHeader(fragment);
+    if (header.count == 0 || header.index >= header.count || header.total < header.count) {
+        ++stats_.invalid;
+        return Result::Invalid;
+    }
+
+    // Every fragment must carry exactly its share of the frame
+    size_t step = stride(header.total, header.count);
+    size_t offset = header.index * step;
+    size_t expected = std::min(step, header.total - std::min(offset, header.total));
+    size_t payload = len - kFragmentHeaderSize;
+    if (offset >= header.total || payload != expected) {
+        ++stats_.invalid;
+        return Result::Invalid;
+    }
+    const uint8_t* data = fragment + kFragmentHeaderSize;
+
+    if (header.count == 1) {
+        frame.assign(data, data + payload);
+        ++stats_.completed;
+        return Result::Complete;
+    }
+
+    auto now = CoarseClock::now();
+    StreamKey key{source, header.stream};
+    auto it = partials_.find(key);
+    if (it == partials_.end()) {
+        if (!reserve(header.total, now)) {
+            return Result::OverBudget;
+        }
+        Partial partial;
+        if (!spare_buffers_.empty()) {
+            partial.buffer = std::move(spare_buffers_.back());
+            spare_buffers_.pop_back();
+        }
+        partial.buffer.resize(header.total);
+        partial.reserved = header.total;
+        partial.count = header.count;
+        partial.remaining = header.count;
+        partial.deadline = now + config_.timeout;
+        it = partials_.emplace(key, std::move(partial)).first;
+        reserved_ += header.total;
+    } else if (it->second.count != header.count || it->second.reserved != header.total) {
+        ++stats_.invalid;
+        return Result::Invalid;
+    }
+
+    Partial& partial = it->second;
+    uint64_t bit = uint64_t(1) << (header.index & 63);
+    uint64_t& word = partial.received[header.index >> 6];
+    if (word & bit) {
+        ++stats_.duplicates;
+        return Result::Duplicate;
+    }
+    word |= bit;
+    std::memcpy(partial.buffer.data() + offset, data, payload);
+
+    if (--partial.remaining > 0) {
+        return Result::Incomplete;
+    }
+
+    frame = std::move(partial.buffer);
+    release(it);
+    ++stats_.completed;
+    return Result::Complete;
+}
+
+bool Reassembler::reserve(size_t bytes, CoarseClock::time_point now) {
+    if (bytes > config_.memory_budget) {
+        return false;
+    }
+    if (reserved_ + bytes <= config_.memory_budget) {
+        return true;
+    }
+
+    sweep(now);
+    while (reserved_ + bytes > config_.memory_budget && !partials_.empty()) {
+        auto oldest = std::min_element(partials_.begin(), partials_.end(),
+                                       [](const auto& a, const auto& b) {
+                                           return a.second.deadline < b.second.deadline;
+                                       });
+        release(oldest);
+        ++stats_.evicted;
+    }
+    return true;
+}
+
+void Reassembler::recycle(std::vector<uint8_t>&& buffer) {
+    // Spares sit outside the budget, so keep only modest ones
+    if (spare_buffers_.size() < kMaxSpareBuffers && buffer.capacity() > 0 &&
+        buffer.capacity() <= config_.memory_budget / kMaxSpareBuffers) {
+        spare_buffers_.push_back(std::move(buffer));
+    }
+}
+
+void Reassembler::release(std::unordered_map<StreamKey, Partial, StreamKeyHash>::iterator it) {
+    reserved_ -= it->second.reserved;
+    partials_.erase(it);
+}
+
+size_t Reassembler::sweep(CoarseClock::time_point now) {
+    size_t dropped = 0;
+    for (auto it = partials_.begin(); it != partials_.end();) {
+        if (now >= it->second.deadline) {
+            auto next = std::next(it);
+            release(it);
+            it = next;
+            ++dropped;
+        } else {
+            ++it;
+        }
+    }
+    stats_.expired += dropped;
+    return dropped;
+}
+
+Reassembler::Stats Reassembler::getStats() const {
+    Stats stats = stats_;
+    stats.partial_streams = partials_.size();
+    stats.reserved_bytes = reserved_;
+    return stats;
+}
+
+} // namespace mesh::protocol
@@ -0,0 +1,137 @@
+#include "mesh/protocol/message_id.hpp"
+#include <chrono>
+
+namespace mesh::protocol {
+
+namespace {
+
+const char kHexDigits[] = "0123456789abcdef";
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool isDashPosition(size_t pos) {
+    return pos == 8 || pos == 13 || pos == 18 || pos == 23;
+}
+
+std::atomic<uint64_t> g_next_instance{1};
+
+// Reserved blocks, each tagged with the generator that owns it. A thread
+// keeps one per generator it has used recently, most recent first, so
+// alternating between a few generators does not throw blocks away.
+struct ThreadBlock {
+    uint64_t instance = 0;
+    uint64_t next = 0;
+    uint64_t end = 0;
+};
+
+constexpr size_t kThreadBlocks = 4;
+
+thread_local ThreadBlock t_blocks[kThreadBlocks];
+
+} // namespace
+
+void MessageId::toBytes(uint8_t* out) const {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<uint8_t>(high >> (56 - 8 * i));
+        out[8 + i] = static_cast<uint8_t>(low >> (56 - 8 * i));
+    }
+}
+
+MessageId MessageId::fromBytes(const uint8_t* in) {
+    MessageId id;
+    for (int i = 0; i < 8; ++i) {
+        id.high = (id.high << 8) | in[i];
+        id.low = (id.low << 8) | in[8 + i];
+    }
+    return id;
+}
+
+void MessageId::toHex(char* out) const {
+    uint8_t bytes[kSize];
+    toBytes(bytes);
+    size_t pos = 0;
+    for (size_t i = 0; i < kSize; ++i) {
+        if (isDashPosition(pos)) {
+            out[pos++] = '-';
+        }
+        out[pos++] = kHexDigits[bytes[i] >> 4];
+        out[pos++] = kHexDigits[bytes[i] & 0x0F];
+    }
+}
+
+std::string MessageId::toHex() const {
+    std::string text(kHexSize, '\0');
+    toHex(&text[0]);
+    return text;
+}
+
+MessageId MessageId::fromHex(std::string_view text) {
+    bool dashed = text.size() == kHexSize;
+    if (!dashed && text.size() != 2 * kSize) {
+        return {};
+    }
+
+    uint8_t bytes[kSize];
+    size_t pos = 0;
+    for (size_t i = 0; i < kSize; ++i) {
+        if (dashed && isDashPosition(pos)) {
+            if (text[pos++] != '-') {
+                return {};
+            }
+        }
+        int hi = hexValue(text[pos]);
+        int lo = hexValue(text[pos + 1]);
+        if (hi < 0 || lo < 0) {
+            return {};
+        }
+        bytes[i] = static_cast<uint8_t>(hi << 4 | lo);
+        pos += 2;
+    }
+    return fromBytes(bytes);
+}
+
+MessageIdGenerator::MessageIdGenerator(uint64_t node_prefix)
+    : prefix_(node_prefix),
+      instance_(g_next_instance.fetch_add(1, std::memory_order_relaxed)),
+      next_block_(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count())) {}
+
+uint64_t MessageIdGenerator::prefixFor(std::string_view node_id) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : node_id) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+MessageId MessageIdGenerator::next() {
+    ThreadBlock* blocks = t_blocks;
+    if (blocks[0].instance != instance_) {
+        // Move this generator's block to the front, or give it the least
+        // recently used slot
+        size_t i = 1;
+        while (i + 1 < kThreadBlocks && blocks[i].instance != instance_) {
+            ++i;
+        }
+        ThreadBlock found = blocks[i];
+        for (; i > 0; --i) {
+            blocks[i] = blocks[i - 1];
+        }
+        blocks[0] = found.instance == instance_ ? found : ThreadBlock{instance_, 0, 0};
+    }
+
+    ThreadBlock& block = blocks[0];
+    if (block.next == block.end) {
+        block.next = next_block_.fetch_add(kBlockSize, std::memory_order_relaxed);
+        block.end = block.next + kBlockSize;
+    }
+    return {prefix_, block.next++};
+}
+
+} // namespace mesh::protocol
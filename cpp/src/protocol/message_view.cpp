@@ -0,0 +1,144 @@
+#include "mesh/protocol/message_view.hpp"
+#include "protocol/wire_format.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace mesh::protocol {
+
+bool MessageView::parse(const uint8_t* data, size_t len) {
+    data_ = nullptr;
+    size_ = 0;
+
+    if (!data || len < kWireHeaderSize || data[0] != kWireVersion) {
+        return false;
+    }
+
+    // Type codes past kMaxTypeCode come from newer nodes and still parse,
+    // so relays forward them; only dispatch and typeName() leave them alone
+    if ((data[1] & ~kFlagCompressed) != 0) {
+        return false;
+    }
+
+    const uint8_t* in = data + kWireHeaderSize;
+    const uint8_t* end = data + len;
+
+    uint64_t ttl, priority;
+    if (!wire::readVarint(in, end, ttl) || !wire::readVarint(in, end, priority) ||
+        priority > static_cast<uint64_t>(MessagePriority::High)) {
+        return false;
+    }
+
+    // Well-known types travel as a code only
+    type_offset_ = 0;
+    type_size_ = 0;
+    if (data[2] == kNamedTypeCode) {
+        uint64_t type_len;
+        if (!wire::readVarint(in, end, type_len) || type_len > static_cast<uint64_t>(end - in)) {
+            return false;
+        }
+        type_offset_ = static_cast<size_t>(in - data);
+        type_size_ = static_cast<size_t>(type_len);
+        in += type_len;
+    }
+
+    uint64_t content_len;
+    if (!wire::readVarint(in, end, content_len) || content_len != static_cast<uint64_t>(end - in)) {
+        return false;
+    }
+    content_offset_ = static_cast<size_t>(in - data);
+    content_size_ = static_cast<size_t>(content_len);
+
+    ttl_ = wire::unzigzag(ttl);
+    priority_ = static_cast<MessagePriority>(priority);
+    data_ = data;
+    size_ = len;
+    return true;
+}
+
+uint64_t MessageView::timestampMillis() const {
+    return wire::readU64(data_ + 4);
+}
+
+std::chrono::system_clock::time_point MessageView::timestamp() const {
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::milliseconds(static_cast<int64_t>(timestampMillis()))));
+}
+
+ByteView MessageView::fromId() const {
+    return {data_ + wire::kFromIdOffset, 32};
+}
+
+ByteView MessageView::toId() const {
+    return {data_ + wire::kToIdOffset, 32};
+}
+
+bool MessageView::isBroadcast() const {
+    ByteView to = toId();
+    return std::all_of(to.begin(), to.end(), [](uint8_t b) { return b == 0xFF; });
+}
+
+bool MessageView::isAddressedTo(const NodeId& node) const {
+    return isBroadcast() || std::memcmp(data_ + wire::kToIdOffset, node.data(), node.size()) == 0;
+}
+
+std::string_view MessageView::type() const {
+    if (typeCode() != kNamedTypeCode) {
+        return typeName(typeCode());
+    }
+    return std::string_view(reinterpret_cast<const char*>(data_ + type_offset_), type_size_);
+}
+
+std::string_view MessageView::content() const {
+    return std::string_view(reinterpret_cast<const char*>(data_ + content_offset_), content_size_);
+}
+
+bool MessageView::hasVisited(HopId hop) const {
+    uint64_t bits = HopPath::summaryBits(hop);
+    if ((wire::readU64(data_ + wire::kHopSummaryOffset) & bits) != bits) {
+        return false;
+    }
+    size_t held = std::min(hopCount(), HopPath::kCapacity);
+    for (size_t i = 0; i < held; ++i) {
+        if (wire::readU32(data_ + wire::kHopsOffset + i * 4) == hop) {
+            return true;
+        }
+    }
+    return hopCount() > HopPath::kCapacity;
+}
+
+HopPath MessageView::hopPath() const {
+    HopId hops[HopPath::kCapacity];
+    size_t held = std::min(hopCount(), HopPath::kCapacity);
+    for (size_t i = 0; i < held; ++i) {
+        hops[i] = wire::readU32(data_ + wire::kHopsOffset + i * 4);
+    }
+    HopPath path;
+    path.restore(hops, held, data_[3], wire::readU64(data_ + wire::kHopSummaryOffset));
+    return path;
+}
+
+bool MessageView::toMessage(Message& message) const {
+    if (!isValid() || isCompressed()) {
+        return false;
+    }
+
+    NodeId node;
+    message.id = messageId();
+    std::memcpy(node.data(), data_ + wire::kFromIdOffset, 32);
+    message.from_id = formatNodeId(node);
+    std::memcpy(node.data(), data_ + wire::kToIdOffset, 32);
+    message.to_id = formatNodeId(node);
+
+    message.content.assign(content());
+    message.type.assign(type());
+    message.timestamp = timestamp();
+    message.expires_at = CoarseClock::time_point::max();
+    message.ttl = ttl_;
+    message.priority = priority_;
+
+    message.path = hopPath();
+    return true;
+}
+
+} // namespace mesh::protocol
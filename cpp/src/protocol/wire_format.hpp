@@ -0,0 +1,81 @@
+#ifndef MESH_PROTOCOL_WIRE_FORMAT_HPP
+#define MESH_PROTOCOL_WIRE_FORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Internal helpers shared by the codec and MessageView
+namespace mesh::protocol::wire {
+
+inline size_t varintSize(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+inline uint8_t* writeVarint(uint8_t* out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(value);
+    return out;
+}
+
+inline bool readVarint(const uint8_t*& in, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && in < end; shift += 7) {
+        uint8_t byte = *in++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline uint64_t zigzag(int32_t value) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(value)) << 1) ^
+           static_cast<uint64_t>(static_cast<int64_t>(value) >> 63);
+}
+
+inline int32_t unzigzag(uint64_t value) {
+    return static_cast<int32_t>(static_cast<uint32_t>(value >> 1) ^ -static_cast<uint32_t>(value & 1));
+}
+
+inline void writeU64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+inline uint64_t readU64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+inline void writeU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+inline uint32_t readU32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | static_cast<uint32_t>(in[1]) << 8 |
+           static_cast<uint32_t>(in[2]) << 16 | static_cast<uint32_t>(in[3]) << 24;
+}
+
+constexpr size_t kFromIdOffset = 28;
+constexpr size_t kToIdOffset = 60;
+constexpr size_t kHopSummaryOffset = 92;
+constexpr size_t kHopsOffset = 100;
+
+} // namespace mesh::protocol::wire
+
+#endif // MESH_PROTOCOL_WIRE_FORMAT_HPP
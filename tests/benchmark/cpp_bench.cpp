@@ -1,7 +1,46 @@
 #include <benchmark/benchmark.h>
 #include <mesh/core.h>
 #include <mesh/crypto.h>
+#include <mesh/broker/adapter_hub.hpp>
+#include <mesh/broker/emulated_mesh.hpp>
+#include <mesh/broker/latency_histogram.hpp>
+#include <mesh/broker/link_model.hpp>
+#include <mesh/broker/message_queue.hpp>
+#include <mesh/broker/message_spool.hpp>
+#include <mesh/broker/mpmc_ring.hpp>
+#include <mesh/broker/sharded_counters.hpp>
+#include <mesh/broker/snapshot.hpp>
+#include <mesh/broker/wakeup.hpp>
+#include <mesh/crypto/batch_signer.hpp>
+#include <mesh/crypto/group_session.hpp>
+#include <mesh/crypto/layered_frame.hpp>
+#include <mesh/crypto/noise.hpp>
+#include <mesh/protocol/coarse_clock.hpp>
+#include <mesh/protocol/codec.hpp>
+#include <mesh/protocol/coalescing.hpp>
+#include <mesh/protocol/compression.hpp>
+#include <mesh/protocol/dispatch.hpp>
+#include <mesh/protocol/fec.hpp>
+#include <mesh/protocol/fragmentation.hpp>
+#include <mesh/protocol/message_id.hpp>
+#include <mesh/protocol/message_view.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <malloc.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 static void BM_CppNodeCreation(benchmark::State& state) {
     mesh_init();
@@ -175,4 +214,1113 @@ static void BM_CppConsensusProtocol(benchmark::State& state) {
 }
 BENCHMARK(BM_CppConsensusProtocol);
 
+static void BM_CppNoiseHandshake(benchmark::State& state) {
+    mesh::crypto::KeyPair initiator_static;
+    mesh::crypto::KeyPair responder_static;
+    std::vector<uint8_t> early_data(64, 'e');
+    std::vector<uint8_t> reply(64, 'r');
+
+    for (auto _ : state) {
+        mesh::crypto::NoiseHandshake initiator(mesh::crypto::NoiseHandshake::Role::Initiator,
+                                               initiator_static);
+        mesh::crypto::NoiseHandshake responder(mesh::crypto::NoiseHandshake::Role::Responder,
+                                               responder_static);
+
+        std::vector<uint8_t> initiation, response, received;
+        initiator.writeInitiation(responder_static.getPublicKey(), early_data, initiation);
+        responder.readInitiation(initiation, received);
+        responder.writeResponse(reply, response);
+        bool ok = initiator.readResponse(response, received);
+        benchmark::DoNotOptimize(ok);
+    }
+
+    // Each iteration is one full handshake (both sides) on a single core
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CppNoiseHandshake);
+
+// Broadcast to N peers over pairwise sessions: one AES-GCM pass per peer
+static void BM_CppBroadcastPairwise(benchmark::State& state) {
+    const size_t peers = static_cast<size_t>(state.range(0));
+    std::vector<uint8_t> payload(256, 'b');
+    std::vector<uint8_t> ciphertext(payload.size() + 16);
+    mesh_key_t key = {0};
+    mesh_nonce_t nonce = {0};
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < peers; ++i) {
+            size_t ciphertext_len = 0;
+            mesh_crypto_aes_gcm_encrypt(key, nonce, payload.data(), payload.size(),
+                                        nullptr, 0, ciphertext.data(), &ciphertext_len);
+            benchmark::DoNotOptimize(ciphertext.data());
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CppBroadcastPairwise)->Arg(8)->Arg(64);
+
+// Same broadcast with a sender key: one AES-GCM pass regardless of N
+static void BM_CppBroadcastSenderKey(benchmark::State& state) {
+    mesh::crypto::SenderKeySession session;
+    std::vector<uint8_t> payload(256, 'b');
+    std::vector<uint8_t> frame;
+
+    for (auto _ : state) {
+        bool ok = session.encrypt(payload, frame);
+        benchmark::DoNotOptimize(ok);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CppBroadcastSenderKey);
+
+// Relay hop on a layered frame: header verify + re-tag, body untouched
+static void BM_CppLayeredFrameRelay(benchmark::State& state) {
+    mesh::crypto::SessionTable::Key e2e_key{}, link_key{};
+    e2e_key.fill(0x01);
+    link_key.fill(0x02);
+
+    mesh::crypto::RoutingHeader header;
+    header.ttl = 255;
+    std::vector<uint8_t> payload(static_cast<size_t>(state.range(0)), 'p');
+    std::vector<uint8_t> frame;
+    mesh::crypto::sealLayeredFrame(header, e2e_key, 0, payload, link_key, frame);
+
+    uint64_t counter = 0;
+    for (auto _ : state) {
+        bool ok = mesh::crypto::relayLayeredFrame(frame.data(), frame.size(),
+                                                  link_key, 1, ++counter, link_key);
+        benchmark::DoNotOptimize(ok);
+
+        // Reseal once the TTL runs out
+        if (frame[2] <= 1) {
+            state.PauseTiming();
+            mesh::crypto::sealLayeredFrame(header, e2e_key, 0, payload, link_key, frame);
+            state.ResumeTiming();
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_CppLayeredFrameRelay)->Arg(64)->Arg(1024)->Arg(16384);
+
+// One Ed25519 signature per message
+static void BM_CppSignEachMessage(benchmark::State& state) {
+    mesh_key_t public_key, private_key;
+    mesh_crypto_ed25519_keypair_generate(public_key, private_key);
+    const char* vote = "vote:round-1:yes";
+    mesh_signature_t signature;
+
+    for (auto _ : state) {
+        mesh_crypto_error_t err = mesh_crypto_ed25519_sign(private_key,
+                                                           reinterpret_cast<const uint8_t*>(vote),
+                                                           strlen(vote), signature);
+        benchmark::DoNotOptimize(err);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CppSignEachMessage);
+
+// One Ed25519 signature per Merkle batch of N messages
+static void BM_CppBatchSign(benchmark::State& state) {
+    mesh_key_t public_key, private_key;
+    mesh_crypto_ed25519_keypair_generate(public_key, private_key);
+    const size_t batch = static_cast<size_t>(state.range(0));
+    mesh::crypto::BatchSigner signer(private_key, std::chrono::milliseconds(5), batch);
+    const char* vote = "vote:round-1:yes";
+    std::vector<mesh::crypto::BatchProof> proofs;
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < batch; ++i) {
+            signer.add(reinterpret_cast<const uint8_t*>(vote), strlen(vote));
+        }
+        bool ok = signer.flush(proofs);
+        benchmark::DoNotOptimize(ok);
+    }
+
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_CppBatchSign)->Arg(16)->Arg(256);
+
+static mesh::protocol::Message makeBenchMessage(size_t content_size) {
+    mesh::protocol::Message message;
+    message.id = mesh::protocol::MessageId::fromHex("6f1c2a3b-4d5e-4f60-8a7b-9c0d1e2f3a4b");
+    message.from_id = std::string(64, 'a');
+    message.to_id = std::string(64, 'b');
+    message.content = std::string(content_size, 'x');
+    message.timestamp = std::chrono::system_clock::now();
+    message.path.append(mesh::protocol::makeHopId(std::string(64, 'a')));
+    message.path.append(mesh::protocol::makeHopId(std::string(64, 'c')));
+    message.type = "chat";
+    return message;
+}
+
+// JSON baseline mirroring the Go wire format
+static std::string encodeJson(const mesh::protocol::Message& message) {
+    boost::property_tree::ptree tree;
+    tree.put("id", message.id.toHex());
+    tree.put("fromId", message.from_id);
+    tree.put("toId", message.to_id);
+    tree.put("message", message.content);
+    tree.put("timestamp", std::chrono::duration_cast<std::chrono::milliseconds>(
+        message.timestamp.time_since_epoch()).count());
+    tree.put("ttl", message.ttl);
+    tree.put("priority", static_cast<int>(message.priority));
+    tree.put("type", message.type);
+    boost::property_tree::ptree path;
+    for (size_t i = 0; i < message.path.size(); ++i) {
+        boost::property_tree::ptree entry;
+        entry.put("", message.path.at(i));
+        path.push_back(std::make_pair("", entry));
+    }
+    tree.add_child("path", path);
+
+    std::ostringstream out;
+    boost::property_tree::write_json(out, tree, false);
+    return out.str();
+}
+
+static void BM_CppMessageEncodeBinary(benchmark::State& state) {
+    auto message = makeBenchMessage(static_cast<size_t>(state.range(0)));
+    std::vector<uint8_t> buffer(mesh::protocol::encodedSize(message));
+
+    for (auto _ : state) {
+        size_t written = 0;
+        bool ok = mesh::protocol::encodeMessage(message, buffer.data(), buffer.size(), written);
+        benchmark::DoNotOptimize(ok);
+    }
+
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_CppMessageEncodeBinary)->Arg(32)->Arg(1024);
+
+static void BM_CppMessageDecodeBinary(benchmark::State& state) {
+    auto message = makeBenchMessage(static_cast<size_t>(state.range(0)));
+    std::vector<uint8_t> buffer(mesh::protocol::encodedSize(message));
+    size_t written = 0;
+    mesh::protocol::encodeMessage(message, buffer.data(), buffer.size(), written);
+
+    for (auto _ : state) {
+        mesh::protocol::Message decoded;
+        bool ok = mesh::protocol::decodeMessage(buffer.data(), written, decoded);
+        benchmark::DoNotOptimize(ok);
+    }
+
+    state.SetBytesProcessed(state.iterations() * written);
+}
+BENCHMARK(BM_CppMessageDecodeBinary)->Arg(32)->Arg(1024);
+
+static void BM_CppMessageEncodeJson(benchmark::State& state) {
+    auto message = makeBenchMessage(static_cast<size_t>(state.range(0)));
+    size_t size = 0;
+
+    for (auto _ : state) {
+        std::string json = encodeJson(message);
+        size = json.size();
+        benchmark::DoNotOptimize(json);
+    }
+
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_CppMessageEncodeJson)->Arg(32)->Arg(1024);
+
+static void BM_CppMessageDecodeJson(benchmark::State& state) {
+    auto message = makeBenchMessage(static_cast<size_t>(state.range(0)));
+    std::string json = encodeJson(message);
+
+    for (auto _ : state) {
+        std::istringstream in(json);
+        boost::property_tree::ptree tree;
+        boost::property_tree::read_json(in, tree);
+
+        mesh::protocol::Message decoded;
+        decoded.id = mesh::protocol::MessageId::fromHex(tree.get<std::string>("id"));
+        decoded.from_id = tree.get<std::string>("fromId");
+        decoded.to_id = tree.get<std::string>("toId");
+        decoded.content = tree.get<std::string>("message");
+        decoded.ttl = tree.get<int32_t>("ttl");
+        decoded.type = tree.get<std::string>("type");
+        for (const auto& hop : tree.get_child("path")) {
+            decoded.path.append(hop.second.get_value<mesh::protocol::HopId>());
+        }
+        benchmark::DoNotOptimize(decoded);
+    }
+
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_CppMessageDecodeJson)->Arg(32)->Arg(1024);
+
+// Relay inspection through MessageView: validate, check TTL and destination
+static void BM_CppMessageViewInspect(benchmark::State& state) {
+    auto message = makeBenchMessage(static_cast<size_t>(state.range(0)));
+    std::vector<uint8_t> buffer(mesh::protocol::encodedSize(message));
+    size_t written = 0;
+    mesh::protocol::encodeMessage(message, buffer.data(), buffer.size(), written);
+
+    mesh::protocol::NodeId self;
+    self.fill(0xcc);
+
+    for (auto _ : state) {
+        mesh::protocol::MessageView view;
+        bool forward = view.parse(buffer.data(), written) &&
+                       view.ttl() > 0 && !view.isAddressedTo(self);
+        benchmark::DoNotOptimize(forward);
+    }
+
+    state.SetBytesProcessed(state.iterations() * written);
+}
+BENCHMARK(BM_CppMessageViewInspect)->Arg(32)->Arg(1024);
+
+// Per-relay loop check and hop stamp on a frame that has already taken
+// range(0) hops; cost and frame size stay flat as the route grows
+static void BM_CppRelayHopStamp(benchmark::State& state) {
+    auto message = makeBenchMessage(32);
+    message.path.clear();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        message.path.append(mesh::protocol::makeHopId("relay-" + std::to_string(i)));
+    }
+    std::vector<uint8_t> buffer(mesh::protocol::encodedSize(message));
+    size_t written = 0;
+    mesh::protocol::encodeMessage(message, buffer.data(), buffer.size(), written);
+    const std::vector<uint8_t> original = buffer;
+
+    mesh::protocol::HopId self = mesh::protocol::makeHopId(std::string(64, 'c'));
+
+    for (auto _ : state) {
+        mesh::protocol::MessageView view;
+        bool loop = view.parse(buffer.data(), written) && view.hasVisited(self);
+        if (!loop) {
+            mesh::protocol::appendHop(buffer.data(), written, self);
+        }
+        std::memcpy(buffer.data(), original.data(), written);
+        benchmark::DoNotOptimize(loop);
+    }
+
+    state.counters["frame_bytes"] = static_cast<double>(written);
+}
+BENCHMARK(BM_CppRelayHopStamp)->Arg(2)->Arg(16)->Arg(64);
+
+// Chat-like content of the requested size, not copied from the dictionary
+static std::string makeChatContent(size_t size) {
+    static const char* const kLines[] = {
+        "Are we still meeting at the north gate at six? ",
+        "Battery at 40%, switching to low power mode. ",
+        "Thanks, got it. Heading there now with the supplies. ",
+        "{\"type\":\"presence\",\"status\":\"online\",\"rssi\":-67} ",
+        "Can someone relay this to the east camp please? ",
+    };
+    std::string content;
+    for (size_t i = 0; content.size() < size; ++i) {
+        content += kLines[i % 5];
+    }
+    content.resize(size);
+    return content;
+}
+
+// Compression ratio and CPU per size class. range(1) = 0 runs the stage's
+// default selection, 1 forces plain deflate for every size.
+static void BM_CppCompressFrame(benchmark::State& state) {
+    auto message = makeBenchMessage(0);
+    message.content = makeChatContent(static_cast<size_t>(state.range(0)));
+    std::vector<uint8_t> plain(mesh::protocol::encodedSize(message));
+    size_t written = 0;
+    mesh::protocol::encodeMessage(message, plain.data(), plain.size(), written);
+
+    mesh::protocol::CompressionStage stage;
+    if (state.range(1) == 1) {
+        stage.setSmallCodec(mesh::protocol::kCodecDeflate);
+    }
+
+    std::vector<uint8_t> frame;
+    for (auto _ : state) {
+        stage.compressFrame(plain.data(), written, frame);
+        benchmark::DoNotOptimize(frame.data());
+    }
+
+    mesh::protocol::MessageView view;
+    view.parse(frame.data(), frame.size());
+    state.counters["content_ratio"] =
+        static_cast<double>(view.contentBytes().size) / static_cast<double>(message.content.size());
+    state.counters["frame_bytes"] = static_cast<double>(frame.size());
+    state.SetBytesProcessed(state.iterations() * message.content.size());
+}
+BENCHMARK(BM_CppCompressFrame)
+    ->ArgsProduct({{32, 64, 128, 256, 1024, 4096}, {0, 1}});
+
+static void BM_CppDecompressFrame(benchmark::State& state) {
+    auto message = makeBenchMessage(0);
+    message.content = makeChatContent(static_cast<size_t>(state.range(0)));
+    mesh::protocol::CompressionStage stage;
+    std::vector<uint8_t> frame;
+    stage.encode(message, frame);
+
+    std::vector<uint8_t> plain;
+    for (auto _ : state) {
+        bool ok = stage.decompressFrame(frame.data(), frame.size(), plain);
+        benchmark::DoNotOptimize(ok);
+    }
+
+    state.SetBytesProcessed(state.iterations() * message.content.size());
+}
+BENCHMARK(BM_CppDecompressFrame)->Arg(64)->Arg(256)->Arg(4096);
+
+static void BM_CppMessageIdNext(benchmark::State& state) {
+    static mesh::protocol::MessageIdGenerator generator(
+        mesh::protocol::MessageIdGenerator::prefixFor(std::string(64, 'a')));
+
+    for (auto _ : state) {
+        auto id = generator.next();
+        benchmark::DoNotOptimize(id);
+    }
+}
+BENCHMARK(BM_CppMessageIdNext)->Threads(1)->Threads(4);
+
+// Baseline: the UUID strings other implementations generate
+static void BM_CppMessageIdUuidString(benchmark::State& state) {
+    boost::uuids::random_generator generator;
+
+    for (auto _ : state) {
+        std::string id = boost::uuids::to_string(generator());
+        benchmark::DoNotOptimize(id);
+    }
+}
+BENCHMARK(BM_CppMessageIdUuidString);
+
+// Dedup table hit rate of 50%: half the lookups are ids already seen
+static void BM_CppDedupBinaryId(benchmark::State& state) {
+    mesh::protocol::MessageIdGenerator generator(1);
+    std::vector<mesh::protocol::MessageId> ids(8192);
+    for (auto& id : ids) {
+        id = generator.next();
+    }
+    std::unordered_set<mesh::protocol::MessageId> seen(ids.begin(), ids.begin() + ids.size() / 2);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        bool duplicate = seen.count(ids[i++ % ids.size()]) != 0;
+        benchmark::DoNotOptimize(duplicate);
+    }
+}
+BENCHMARK(BM_CppDedupBinaryId);
+
+static void BM_CppDedupStringId(benchmark::State& state) {
+    mesh::protocol::MessageIdGenerator generator(1);
+    std::vector<std::string> ids(8192);
+    for (auto& id : ids) {
+        id = generator.next().toHex();
+    }
+    std::unordered_set<std::string> seen(ids.begin(), ids.begin() + ids.size() / 2);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        bool duplicate = seen.count(ids[i++ % ids.size()]) != 0;
+        benchmark::DoNotOptimize(duplicate);
+    }
+}
+BENCHMARK(BM_CppDedupStringId);
+
+// Queue scan of 1024 messages: precise wall-clock read per message against
+// one coarse clock read per scan
+static void BM_CppExpiryScanSystemClock(benchmark::State& state) {
+    std::vector<std::chrono::system_clock::time_point> deadlines(
+        1024, std::chrono::system_clock::now() + std::chrono::minutes(5));
+
+    for (auto _ : state) {
+        size_t expired = 0;
+        for (const auto& deadline : deadlines) {
+            expired += std::chrono::system_clock::now() >= deadline;
+        }
+        benchmark::DoNotOptimize(expired);
+    }
+
+    state.SetItemsProcessed(state.iterations() * deadlines.size());
+}
+BENCHMARK(BM_CppExpiryScanSystemClock);
+
+static void BM_CppExpiryScanCoarseClock(benchmark::State& state) {
+    std::vector<mesh::protocol::Message> queue(1024);
+    for (auto& message : queue) {
+        message.setMaxAge(std::chrono::minutes(5));
+    }
+
+    for (auto _ : state) {
+        auto now = mesh::protocol::CoarseClock::tick();
+        size_t expired = 0;
+        for (const auto& message : queue) {
+            expired += message.isExpired(now);
+        }
+        benchmark::DoNotOptimize(expired);
+    }
+
+    state.SetItemsProcessed(state.iterations() * queue.size());
+}
+BENCHMARK(BM_CppExpiryScanCoarseClock);
+
+// Producer-to-consumer cost of one message through the priority queue
+static void BM_CppMessageQueuePushPop(benchmark::State& state) {
+    mesh::broker::MessageQueue queue;
+    auto message = makeBenchMessage(32);
+    mesh::protocol::Message out;
+    int priority = 0;
+
+    for (auto _ : state) {
+        message.priority = static_cast<mesh::protocol::MessagePriority>(priority++ % 3);
+        queue.push(message);
+        queue.pop(out);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CppMessageQueuePushPop);
+
+// Dequeues a High message waits behind a standing backlog of Low traffic
+static void BM_CppMessageQueueHighUnderFlood(benchmark::State& state) {
+    mesh::broker::MessageQueue queue;
+    auto bulk = makeBenchMessage(32);
+    bulk.priority = mesh::protocol::MessagePriority::Low;
+    auto control = makeBenchMessage(32);
+    control.priority = mesh::protocol::MessagePriority::High;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        queue.push(bulk);
+    }
+
+    mesh::protocol::Message out;
+    size_t ahead = 0;
+    for (auto _ : state) {
+        queue.push(control);
+        ahead = 0;
+        while (queue.pop(out) && out.priority != mesh::protocol::MessagePriority::High) {
+            queue.push(out);
+            ++ahead;
+        }
+    }
+
+    state.counters["dequeues_ahead"] = static_cast<double>(ahead);
+}
+BENCHMARK(BM_CppMessageQueueHighUnderFlood)->Arg(1024);
+
+// range(0) producers push 4096 messages each while one consumer drains;
+// the previous design (vector under a mutex) is the baseline
+static void BM_CppMessageQueueProducers(benchmark::State& state) {
+    const int producers = static_cast<int>(state.range(0));
+    constexpr size_t kPerProducer = 4096;
+    mesh::broker::MessageQueue queue;
+    auto message = makeBenchMessage(32);
+    std::vector<mesh::protocol::Message> batch(64);
+
+    for (auto _ : state) {
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&] {
+                for (size_t i = 0; i < kPerProducer; ++i) {
+                    while (!queue.push(message)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        size_t remaining = producers * kPerProducer;
+        while (remaining > 0) {
+            remaining -= queue.popBatch(batch.data(), batch.size());
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * producers * kPerProducer);
+}
+BENCHMARK(BM_CppMessageQueueProducers)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+static void BM_CppMutexQueueProducers(benchmark::State& state) {
+    const int producers = static_cast<int>(state.range(0));
+    constexpr size_t kPerProducer = 4096;
+    std::mutex mutex;
+    std::vector<mesh::protocol::Message> queue;
+    auto message = makeBenchMessage(32);
+    std::vector<mesh::protocol::Message> drained;
+
+    for (auto _ : state) {
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&] {
+                for (size_t i = 0; i < kPerProducer; ++i) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    queue.push_back(message);
+                }
+            });
+        }
+        size_t remaining = producers * kPerProducer;
+        while (remaining > 0) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                drained.swap(queue);
+            }
+            remaining -= drained.size();
+            drained.clear();
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * producers * kPerProducer);
+}
+BENCHMARK(BM_CppMutexQueueProducers)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+// Push-to-pop latency for an idle consumer. range(0) = 0 sleeps on the
+// queue's eventfd; otherwise the consumer polls every range(0) microseconds.
+static void BM_CppQueueWakeLatency(benchmark::State& state) {
+    using Clock = std::chrono::steady_clock;
+    const auto poll_interval = std::chrono::microseconds(state.range(0));
+    mesh::broker::MessageQueue queue;
+    mesh::broker::EventFd stop;
+    std::atomic<bool> running{true};
+    std::atomic<int64_t> popped_at{0};
+
+    std::thread consumer([&] {
+        mesh::protocol::Message message;
+        while (running.load(std::memory_order_relaxed)) {
+            if (queue.pop(message)) {
+                popped_at.store(Clock::now().time_since_epoch().count(), std::memory_order_release);
+            } else if (poll_interval.count() > 0) {
+                std::this_thread::sleep_for(poll_interval);
+            } else if (queue.prepareWait()) {
+                mesh::broker::waitReadable({queue.wakeFd(), stop.fd()});
+                queue.finishWait();
+            }
+        }
+    });
+
+    auto message = makeBenchMessage(32);
+    for (auto _ : state) {
+        // Let the consumer go idle first
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        popped_at.store(0, std::memory_order_relaxed);
+        auto pushed = Clock::now();
+        queue.push(message);
+        int64_t done;
+        while ((done = popped_at.load(std::memory_order_acquire)) == 0) {
+            std::this_thread::yield();
+        }
+        state.SetIterationTime(std::chrono::duration<double>(Clock::duration(done) - pushed.time_since_epoch()).count());
+    }
+
+    running = false;
+    stop.notify();
+    consumer.join();
+}
+BENCHMARK(BM_CppQueueWakeLatency)->Arg(0)->Arg(1000)->UseManualTime()->Iterations(200);
+
+// Cost of bumping a send counter from every thread at once: sharded
+// relaxed atomics against the previous mutex-guarded Stats
+static mesh::broker::ShardedCounters<3> g_sharded_counters;
+
+static void BM_CppShardedCounterAdd(benchmark::State& state) {
+    for (auto _ : state) {
+        g_sharded_counters.add(0);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CppShardedCounterAdd)->ThreadRange(1, 8)->UseRealTime();
+
+static std::mutex g_stats_mutex;
+static size_t g_stats_sent = 0;
+
+static void BM_CppMutexCounterAdd(benchmark::State& state) {
+    for (auto _ : state) {
+        std::lock_guard<std::mutex> lock(g_stats_mutex);
+        ++g_stats_sent;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CppMutexCounterAdd)->ThreadRange(1, 8)->UseRealTime();
+
+// Recording cost on the send path, all threads into one histogram
+static mesh::broker::PriorityLatency g_send_latency;
+
+static void BM_CppLatencyRecord(benchmark::State& state) {
+    uint64_t sample = 0x9E3779B97F4A7C15ull * static_cast<uint64_t>(state.thread_index() + 1);
+    for (auto _ : state) {
+        sample = sample * 6364136223846793005ull + 1442695040888963407ull;
+        g_send_latency.record(mesh::protocol::MessagePriority::Normal,
+                              std::chrono::nanoseconds((sample >> 40) & 0xfffff));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CppLatencyRecord)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_CppLatencySummarize(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(g_send_latency.summarize());
+    }
+}
+BENCHMARK(BM_CppLatencySummarize);
+
+// Reading a 64-peer table: an immutable snapshot against the previous
+// mutex-and-copy getPeers()
+using BenchPeerTable = std::map<std::string, std::shared_ptr<std::string>>;
+
+static BenchPeerTable makeBenchPeers() {
+    BenchPeerTable peers;
+    for (int i = 0; i < 64; ++i) {
+        peers["peer-" + std::to_string(i)] = std::make_shared<std::string>(64, 'p');
+    }
+    return peers;
+}
+
+static mesh::broker::SnapshotCell<BenchPeerTable> g_peer_snapshot;
+
+static void BM_CppPeersSnapshot(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        g_peer_snapshot.update([](BenchPeerTable& table) { table = makeBenchPeers(); });
+    }
+    for (auto _ : state) {
+        auto snapshot = g_peer_snapshot.load();
+        benchmark::DoNotOptimize(snapshot->value.size());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CppPeersSnapshot)->ThreadRange(1, 4)->UseRealTime();
+
+static std::mutex g_peers_mutex;
+static BenchPeerTable g_peers = makeBenchPeers();
+
+static void BM_CppPeersMutexCopy(benchmark::State& state) {
+    for (auto _ : state) {
+        std::vector<std::shared_ptr<std::string>> peers;
+        {
+            std::lock_guard<std::mutex> lock(g_peers_mutex);
+            peers.reserve(g_peers.size());
+            for (const auto& entry : g_peers) {
+                peers.push_back(entry.second);
+            }
+        }
+        benchmark::DoNotOptimize(peers.size());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CppPeersMutexCopy)->ThreadRange(1, 4)->UseRealTime();
+
+// Messages received on one adapter and bridged to another in-process,
+// timed until the destination adapter's I/O thread has sent them all
+class CountingAdapter : public mesh::broker::Adapter {
+public:
+    explicit CountingAdapter(std::atomic<uint64_t>& sent) : sent_(sent) {}
+    std::string name() const override { return "bench"; }
+    bool send(const mesh::protocol::Message&) override {
+        sent_.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::atomic<uint64_t>& sent_;
+};
+
+static void BM_CppAdapterHubBridge(benchmark::State& state) {
+    std::atomic<uint64_t> sent{0};
+    mesh::broker::AdapterHub hub("gateway", [](const mesh::protocol::Message&) {});
+    size_t wifi = hub.addAdapter(std::make_unique<CountingAdapter>(sent));
+    size_t ble = hub.addAdapter(std::make_unique<CountingAdapter>(sent));
+    hub.setRoute("phone", ble);
+    hub.start();
+
+    auto message = makeBenchMessage(32);
+    message.to_id = "phone";
+    uint64_t routed = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < 256; ++i) {
+            while (!hub.route(message, wifi)) {
+                std::this_thread::yield();
+            }
+        }
+        routed += 256;
+        while (sent.load(std::memory_order_acquire) < routed) {
+            std::this_thread::yield();
+        }
+    }
+    hub.stop();
+
+    state.SetItemsProcessed(static_cast<int64_t>(routed));
+}
+BENCHMARK(BM_CppAdapterHubBridge)->UseRealTime();
+
+// Heap bytes in use, for memory per emulated node
+static size_t heapInUse() {
+    return mallinfo2().uordblks;
+}
+
+// A gateway beacon flooding a random mesh of range(0) nodes until every
+// node has a route back; convergence is in virtual time
+static void BM_CppEmulatedMeshConverge(benchmark::State& state) {
+    auto nodes = static_cast<size_t>(state.range(0));
+    double converged_ms = 0.0;
+    double bytes_per_node = 0.0;
+    uint64_t events = 0;
+    uint64_t transmissions = 0;
+    for (auto _ : state) {
+        size_t heap_before = heapInUse();
+        mesh::broker::EmulatedMesh mesh;
+        mesh.addNodes(nodes);
+        mesh.connectRandom(2, 42);
+        mesh.send(0, mesh::broker::EmulatedMesh::kBroadcast, "beacon");
+        mesh.run();
+        bytes_per_node = static_cast<double>(heapInUse() - heap_before) / static_cast<double>(nodes);
+
+        mesh::broker::EmulatedMesh::Duration at(0);
+        mesh.convergenceTime(0, at);
+        converged_ms = static_cast<double>(at.count()) / 1000.0;
+        events += mesh.getStats().events;
+        transmissions = mesh.getStats().transmissions;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(events));
+    state.counters["converged_ms"] = converged_ms;
+    state.counters["frames_per_node"] = static_cast<double>(transmissions) / static_cast<double>(nodes);
+    state.counters["bytes_per_node"] = bytes_per_node;
+}
+BENCHMARK(BM_CppEmulatedMeshConverge)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+// Routing overhead once converged: 256 random nodes report to the gateway
+// per iteration; items are events processed
+static void BM_CppEmulatedMeshUnicast(benchmark::State& state) {
+    using mesh::broker::EmulatedMesh;
+    auto nodes = static_cast<size_t>(state.range(0));
+    EmulatedMesh mesh;
+    mesh.addNodes(nodes);
+    mesh.connectRandom(2, 42);
+    mesh.send(0, EmulatedMesh::kBroadcast, "beacon");
+    mesh.run();
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<EmulatedMesh::NodeIndex> pick(1, static_cast<EmulatedMesh::NodeIndex>(nodes - 1));
+    auto before = mesh.getStats();
+    for (auto _ : state) {
+        for (int i = 0; i < 256; ++i) {
+            mesh.send(pick(rng), 0, "reading");
+        }
+        mesh.run();
+    }
+    auto after = mesh.getStats();
+    uint64_t delivered = after.delivered - before.delivered;
+    state.SetItemsProcessed(static_cast<int64_t>(after.events - before.events));
+    state.counters["frames_per_message"] =
+        delivered > 0 ? static_cast<double>(after.transmissions - before.transmissions) / static_cast<double>(delivered) : 0.0;
+    state.counters["delivery_ratio"] =
+        static_cast<double>(delivered) / static_cast<double>(after.originated - before.originated);
+}
+BENCHMARK(BM_CppEmulatedMeshUnicast)->Arg(1000)->Arg(10000);
+
+// Cost of timing one frame through a lossy, jittery link model
+static void BM_CppLinkModelTransmit(benchmark::State& state) {
+    mesh::broker::LinkModel link(mesh::broker::LinkProfile::wifi());
+    int64_t now = 0;
+    for (auto _ : state) {
+        now += 500;
+        benchmark::DoNotOptimize(link.transmit(mesh::broker::LinkModel::Direction::AtoB, 600,
+                                               std::chrono::microseconds(now)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CppLinkModelTransmit);
+
+// Bulk transfer over four WiFi-profile hops, in virtual time: what the
+// routing and queue code achieves under loss, jitter and half-duplex
+// contention for range(0)-byte messages
+static void BM_CppEmulatedMeshWifiChain(benchmark::State& state) {
+    using mesh::broker::EmulatedMesh;
+    auto size = static_cast<size_t>(state.range(0));
+    EmulatedMesh::Config config;
+    config.queue_depth = 64;
+    EmulatedMesh chain(config);
+    chain.addNodes(5);
+    for (EmulatedMesh::NodeIndex i = 0; i < 4; ++i) {
+        chain.connect(i, i + 1, mesh::broker::LinkProfile::wifi());
+    }
+    mesh::broker::LatencyHistogram latency;
+    chain.setDeliverHandler([&](EmulatedMesh::NodeIndex, const mesh::protocol::Message&,
+                                EmulatedMesh::Duration elapsed) {
+        latency.record(elapsed);
+    });
+
+    std::string payload(size, 'x');
+    auto start = chain.now();
+    for (auto _ : state) {
+        for (int i = 0; i < 64; ++i) {
+            chain.send(4, 0, payload);
+        }
+        chain.run();
+    }
+    auto stats = chain.getStats();
+    auto summary = latency.summarize();
+    double seconds = std::chrono::duration<double>(chain.now() - start).count();
+    state.SetItemsProcessed(static_cast<int64_t>(stats.events));
+    state.counters["delivery_ratio"] = static_cast<double>(summary.count) / static_cast<double>(stats.originated);
+    state.counters["goodput_kbps"] = seconds > 0 ? static_cast<double>(summary.count * size) * 8 / 1000 / seconds : 0.0;
+    state.counters["p50_ms"] = static_cast<double>(summary.p50_us) / 1000.0;
+    state.counters["p99_ms"] = static_cast<double>(summary.p99_us) / 1000.0;
+}
+BENCHMARK(BM_CppEmulatedMeshWifiChain)->Arg(200)->Arg(1000);
+
+// Spool directory under /tmp, removed when the benchmark ends
+class ScratchSpoolDir {
+public:
+    ScratchSpoolDir() {
+        char path[] = "/tmp/mesh-spool-bench-XXXXXX";
+        path_ = mkdtemp(path) ? path : "/tmp/mesh-spool-bench";
+    }
+    ~ScratchSpoolDir() {
+        std::string command = "rm -rf " + path_;
+        [[maybe_unused]] int status = std::system(command.c_str());
+    }
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+// Spooling for an offline peer. Arg 0 leaves durability to the group
+// commit; arg 1 waits for the disk after every message, which is what
+// group commit saves. Batches are acknowledged as they go so the disk
+// footprint stays bounded.
+static void BM_CppSpoolAppend(benchmark::State& state) {
+    ScratchSpoolDir dir;
+    mesh::broker::MessageSpool::Config config;
+    config.directory = dir.path();
+    mesh::broker::MessageSpool spool(config);
+    spool.open();
+    auto message = makeBenchMessage(256);
+    mesh::protocol::NodeId peer;
+    mesh::protocol::parseNodeId(message.to_id, peer);
+    bool sync_each = state.range(0) != 0;
+    uint64_t appended = 0;
+    for (auto _ : state) {
+        spool.append(message);
+        if (sync_each) {
+            spool.sync();
+        }
+        if (++appended % 4096 == 0) {
+            spool.acknowledge(peer, 4096);
+        }
+    }
+    spool.sync();
+    state.SetItemsProcessed(state.iterations());
+    state.counters["commits"] = static_cast<double>(spool.getStats().commits);
+}
+BENCHMARK(BM_CppSpoolAppend)->Arg(0)->Arg(1)->UseRealTime();
+
+// A reconnecting peer draining its backlog straight out of the mapping
+static void BM_CppSpoolStream(benchmark::State& state) {
+    ScratchSpoolDir dir;
+    mesh::broker::MessageSpool::Config config;
+    config.directory = dir.path();
+    mesh::broker::MessageSpool spool(config);
+    spool.open();
+    auto message = makeBenchMessage(256);
+    mesh::protocol::NodeId peer;
+    mesh::protocol::parseNodeId(message.to_id, peer);
+    for (int i = 0; i < 10000; ++i) {
+        spool.append(message);
+    }
+    uint64_t bytes = 0;
+    for (auto _ : state) {
+        spool.stream(peer, 10000, [&](const uint8_t* frame, size_t len) {
+            benchmark::DoNotOptimize(frame);
+            bytes += len;
+            return true;
+        });
+    }
+    state.SetItemsProcessed(state.iterations() * 10000);
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_CppSpoolStream);
+
+// open() after a restart with range(0) messages spooled
+static void BM_CppSpoolRecover(benchmark::State& state) {
+    ScratchSpoolDir dir;
+    mesh::broker::MessageSpool::Config config;
+    config.directory = dir.path();
+    {
+        mesh::broker::MessageSpool spool(config);
+        spool.open();
+        auto message = makeBenchMessage(256);
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            spool.append(message);
+        }
+    }
+    for (auto _ : state) {
+        mesh::broker::MessageSpool spool(config);
+        spool.open();
+        benchmark::DoNotOptimize(spool.getStats().recovered);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CppSpoolRecover)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// Split an encoded frame for a BLE link and reassemble it on the far side
+static void BM_CppFragmentReassemble(benchmark::State& state) {
+    auto message = makeBenchMessage(static_cast<size_t>(state.range(0)));
+    std::vector<uint8_t> encoded(mesh::protocol::encodedSize(message));
+    size_t written = 0;
+    mesh::protocol::encodeMessage(message, encoded.data(), encoded.size(), written);
+
+    mesh::protocol::Fragmenter fragmenter(mesh::protocol::kBleDefaultMtu);
+    mesh::protocol::Reassembler reassembler;
+    size_t count = fragmenter.fragmentCount(written);
+    std::vector<uint8_t> fragment(fragmenter.getMtu());
+    std::vector<uint8_t> frame;
+
+    for (auto _ : state) {
+        uint16_t stream = fragmenter.nextStreamId();
+        for (size_t i = 0; i < count; ++i) {
+            size_t size = fragmenter.writeFragment(encoded.data(), written, stream, i, fragment.data());
+            reassembler.receive(1, fragment.data(), size, frame);
+        }
+        reassembler.recycle(std::move(frame));
+    }
+
+    state.counters["fragments"] = static_cast<double>(count);
+    state.SetBytesProcessed(state.iterations() * written);
+}
+BENCHMARK(BM_CppFragmentReassemble)->Arg(512)->Arg(4096)->Arg(32768);
+
+// Region multiply-add, the inner loop of FEC encode and decode
+static void BM_CppGf256MulAdd(benchmark::State& state) {
+    std::vector<uint8_t> src(static_cast<size_t>(state.range(0)), 0x5a);
+    std::vector<uint8_t> dst(src.size());
+    for (auto _ : state) {
+        mesh::protocol::gf256::mulAddRegion(dst.data(), src.data(), 0x8e, src.size());
+        benchmark::DoNotOptimize(dst.data());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CppGf256MulAdd)->Arg(236)->Arg(4096);
+
+// FEC over a BLE link at 10% loss; range(0) is the frame size, and the
+// decoder loses as many data shards as there are parity shards
+static void BM_CppFecEncodeDecode(benchmark::State& state) {
+    std::vector<uint8_t> frame(static_cast<size_t>(state.range(0)), 0xa5);
+    mesh::protocol::FecEncoder encoder(mesh::protocol::kBleDefaultMtu);
+    mesh::protocol::FecDecoder decoder;
+    std::vector<std::vector<uint8_t>> shards;
+    std::vector<uint8_t> out;
+    size_t k = encoder.dataShardCount(frame.size());
+    size_t n = 0;
+
+    for (auto _ : state) {
+        n = encoder.encode(frame.data(), frame.size(), encoder.nextStreamId(), 0.1, shards);
+        for (size_t i = n - k; i < n; ++i) {
+            decoder.receive(1, shards[i].data(), shards[i].size(), out);
+        }
+        decoder.recycle(std::move(out));
+    }
+
+    state.counters["data_shards"] = static_cast<double>(k);
+    state.counters["parity_shards"] = static_cast<double>(n - k);
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CppFecEncodeDecode)->Arg(4096)->Arg(32768);
+
+// Heartbeat-sized frames to 8 next hops arriving every 50us of virtual time;
+// range(0) is the coalescing delay in microseconds (0 = disabled)
+static void BM_CppCoalesceSmallFrames(benchmark::State& state) {
+    auto message = makeBenchMessage(8);
+    message.type = "heartbeat";
+    std::vector<uint8_t> frame(mesh::protocol::encodedSize(message));
+    size_t written = 0;
+    mesh::protocol::encodeMessage(message, frame.data(), frame.size(), written);
+
+    mesh::protocol::Coalescer::Config config;
+    config.max_delay = std::chrono::microseconds(state.range(0));
+    size_t bytes_sent = 0;
+    mesh::protocol::Coalescer coalescer(config, [&](uint64_t, const uint8_t*, size_t len) {
+        bytes_sent += len;
+    });
+
+    auto now = mesh::protocol::Coalescer::Clock::now();
+    uint64_t hop = 0;
+    for (auto _ : state) {
+        now += std::chrono::microseconds(50);
+        coalescer.poll(now);
+        coalescer.submit(hop++ % 8, frame.data(), written, now);
+    }
+    coalescer.flushAll();
+
+    state.counters["frames_per_message"] = coalescer.getStats().framesPerMessage();
+    state.SetBytesProcessed(static_cast<int64_t>(bytes_sent));
+}
+BENCHMARK(BM_CppCoalesceSmallFrames)->Arg(0)->Arg(500)->Arg(2000);
+
+// Frames of eight types, dispatched by header type code or by comparing
+// the type name against each handler in turn
+static std::vector<std::vector<uint8_t>> makeTypedFrames() {
+    static const char* const kTypes[] = {"data", "control", "discovery", "encrypted",
+                                         "chat", "ack", "heartbeat", "typing"};
+    std::vector<std::vector<uint8_t>> frames;
+    for (const char* type : kTypes) {
+        auto message = makeBenchMessage(16);
+        message.type = type;
+        std::vector<uint8_t> frame(mesh::protocol::encodedSize(message));
+        size_t written = 0;
+        mesh::protocol::encodeMessage(message, frame.data(), frame.size(), written);
+        frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+static void BM_CppDispatchTypeCode(benchmark::State& state) {
+    namespace types = mesh::protocol::types;
+    using mesh::protocol::MessageView;
+    using mesh::protocol::on;
+
+    auto frames = makeTypedFrames();
+    std::vector<MessageView> views(frames.size());
+    for (size_t i = 0; i < frames.size(); ++i) {
+        views[i].parse(frames[i].data(), frames[i].size());
+    }
+    auto count = [](const MessageView&, std::array<int, 8>& hits, size_t slot) { ++hits[slot]; };
+    auto dispatcher = mesh::protocol::makeDispatcher<std::array<int, 8>>(
+        on<types::Data>([&](const MessageView& v, std::array<int, 8>& h) { count(v, h, 0); }),
+        on<types::Control>([&](const MessageView& v, std::array<int, 8>& h) { count(v, h, 1); }),
+        on<types::Discovery>([&](const MessageView& v, std::array<int, 8>& h) { count(v, h, 2); }),
+        on<types::Encrypted>([&](const MessageView& v, std::array<int, 8>& h) { count(v, h, 3); }),
+        on<types::Chat>([&](const MessageView& v, std::array<int, 8>& h) { count(v, h, 4); }),
+        on<types::Ack>([&](const MessageView& v, std::array<int, 8>& h) { count(v, h, 5); }),
+        on<types::Heartbeat>([&](const MessageView& v, std::array<int, 8>& h) { count(v, h, 6); }),
+        on<types::Typing>([&](const MessageView& v, std::array<int, 8>& h) { count(v, h, 7); }));
+
+    std::array<int, 8> hits{};
+    size_t i = 0;
+    for (auto _ : state) {
+        dispatcher.dispatch(views[i++ % views.size()], hits);
+    }
+    benchmark::DoNotOptimize(hits);
+}
+BENCHMARK(BM_CppDispatchTypeCode);
+
+static void BM_CppDispatchStringCompare(benchmark::State& state) {
+    auto frames = makeTypedFrames();
+    std::vector<mesh::protocol::Message> messages(frames.size());
+    for (size_t i = 0; i < frames.size(); ++i) {
+        mesh::protocol::decodeMessage(frames[i].data(), frames[i].size(), messages[i]);
+    }
+
+    std::array<int, 8> hits{};
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& type = messages[i++ % messages.size()].type;
+        if (type == "data") ++hits[0];
+        else if (type == "control") ++hits[1];
+        else if (type == "discovery") ++hits[2];
+        else if (type == "encrypted") ++hits[3];
+        else if (type == "chat") ++hits[4];
+        else if (type == "ack") ++hits[5];
+        else if (type == "heartbeat") ++hits[6];
+        else if (type == "typing") ++hits[7];
+    }
+    benchmark::DoNotOptimize(hits);
+}
+BENCHMARK(BM_CppDispatchStringCompare);
+
 BENCHMARK_MAIN();
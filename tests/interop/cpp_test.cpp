@@ -1,9 +1,41 @@
 #include <gtest/gtest.h>
 #include <mesh/core.h>
 #include <mesh/crypto.h>
+#include <mesh/broker/adapter_hub.hpp>
+#include <mesh/broker/emulated_link.hpp>
+#include <mesh/broker/emulated_mesh.hpp>
+#include <mesh/broker/link_model.hpp>
+#include <mesh/broker/latency_histogram.hpp>
+#include <mesh/broker/message_queue.hpp>
+#include <mesh/broker/message_spool.hpp>
+#include <mesh/broker/mpmc_ring.hpp>
+#include <mesh/broker/sharded_counters.hpp>
+#include <mesh/broker/snapshot.hpp>
+#include <mesh/broker/wakeup.hpp>
+#include <mesh/protocol/coarse_clock.hpp>
+#include <mesh/protocol/codec.hpp>
+#include <mesh/protocol/coalescing.hpp>
+#include <mesh/protocol/compression.hpp>
+#include <mesh/protocol/dispatch.hpp>
+#include <mesh/protocol/fec.hpp>
+#include <mesh/protocol/fragmentation.hpp>
+#include <mesh/protocol/message_id.hpp>
+#include <mesh/protocol/message_view.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
 #include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
 #include <thread>
 #include <chrono>
+#include <condition_variable>
+#include <atomic>
+#include <mutex>
+#include <unistd.h>
+#include <sys/mman.h>
 
 class CppInteropTest : public ::testing::Test {
 protected:
@@ -183,3 +215,1677 @@ TEST_F(CppInteropTest, PerformanceBenchmark) {
 
     mesh_node_destroy(node);
 }
+
+TEST_F(CppInteropTest, BinaryMessageCodec) {
+    mesh::protocol::Message message;
+    message.id = mesh::protocol::MessageId::fromHex("6f1c2a3b-4d5e-4f60-8a7b-9c0d1e2f3a4b");
+    message.from_id = std::string(64, 'a');
+    message.to_id = mesh::protocol::kBroadcastId;
+    message.content = "Hello over the binary wire";
+    message.timestamp = std::chrono::system_clock::time_point(std::chrono::milliseconds(1700000000123));
+    message.ttl = 7;
+    message.path.append(mesh::protocol::makeHopId(std::string(64, 'a')));
+    message.path.append(mesh::protocol::makeHopId(std::string(64, 'c')));
+    message.priority = mesh::protocol::MessagePriority::High;
+    message.type = "chat";
+
+    size_t size = mesh::protocol::encodedSize(message);
+    ASSERT_GT(size, mesh::protocol::kWireHeaderSize);
+
+    // Short buffers are rejected without writing
+    std::vector<uint8_t> buffer(size);
+    size_t written = 0;
+    EXPECT_FALSE(mesh::protocol::encodeMessage(message, buffer.data(), size - 1, written));
+    ASSERT_TRUE(mesh::protocol::encodeMessage(message, buffer.data(), buffer.size(), written));
+    EXPECT_EQ(written, size);
+
+    mesh::protocol::Message decoded;
+    ASSERT_TRUE(mesh::protocol::decodeMessage(buffer.data(), written, decoded));
+    EXPECT_EQ(decoded.id, message.id);
+    EXPECT_EQ(decoded.from_id, message.from_id);
+    EXPECT_EQ(decoded.to_id, message.to_id);
+    EXPECT_EQ(decoded.content, message.content);
+    EXPECT_EQ(decoded.timestamp, message.timestamp);
+    EXPECT_EQ(decoded.ttl, message.ttl);
+    EXPECT_EQ(decoded.path, message.path);
+    EXPECT_EQ(decoded.priority, message.priority);
+    EXPECT_EQ(decoded.type, message.type);
+
+    // Truncation and unknown versions fail cleanly
+    EXPECT_FALSE(mesh::protocol::decodeMessage(buffer.data(), written - 1, decoded));
+    buffer[0] = mesh::protocol::kWireVersion + 1;
+    EXPECT_FALSE(mesh::protocol::decodeMessage(buffer.data(), written, decoded));
+
+    // Ids must be binary-encodable
+    message.from_id = "not-a-node-id";
+    EXPECT_EQ(mesh::protocol::encodedSize(message), 0u);
+}
+
+TEST_F(CppInteropTest, MessageViewReadsInPlace) {
+    mesh::protocol::Message message;
+    message.id = mesh::protocol::MessageId::fromHex("00112233-4455-6677-8899-aabbccddeeff");
+    message.from_id = std::string(64, 'a');
+    message.to_id = std::string(64, 'b');
+    message.content = "Payload stays in the receive buffer";
+    message.ttl = 3;
+    message.path.append(mesh::protocol::makeHopId(message.from_id));
+    message.type = "chat";
+
+    std::vector<uint8_t> buffer(mesh::protocol::encodedSize(message));
+    size_t written = 0;
+    ASSERT_TRUE(mesh::protocol::encodeMessage(message, buffer.data(), buffer.size(), written));
+
+    mesh::protocol::MessageView view;
+    ASSERT_TRUE(view.parse(buffer.data(), written));
+    EXPECT_EQ(view.ttl(), 3);
+    EXPECT_EQ(view.type(), "chat");
+    EXPECT_EQ(view.content(), message.content);
+    EXPECT_EQ(view.hopCount(), 1u);
+    EXPECT_FALSE(view.isBroadcast());
+
+    // Views point into the original buffer, nothing is copied
+    EXPECT_GE(view.content().data(), reinterpret_cast<const char*>(buffer.data()));
+    EXPECT_EQ(view.frame().data, buffer.data());
+    EXPECT_EQ(view.frame().size, written);
+
+    mesh::protocol::NodeId destination;
+    ASSERT_TRUE(mesh::protocol::parseNodeId(message.to_id, destination));
+    EXPECT_TRUE(view.isAddressedTo(destination));
+
+    mesh::protocol::Message decoded;
+    ASSERT_TRUE(view.toMessage(decoded));
+    EXPECT_EQ(decoded.path, message.path);
+    EXPECT_EQ(decoded.id, message.id);
+
+    // Corrupted length prefix is caught by parse()
+    buffer[written - message.content.size() - 1] ^= 0x01;
+    EXPECT_FALSE(view.parse(buffer.data(), written));
+    EXPECT_FALSE(view.isValid());
+}
+
+TEST_F(CppInteropTest, BoundedHopPath) {
+    using mesh::protocol::HopPath;
+    using mesh::protocol::makeHopId;
+
+    mesh::protocol::Message message;
+    message.id = mesh::protocol::MessageId::fromHex("00112233-4455-6677-8899-aabbccddeeff");
+    message.from_id = std::string(64, 'a');
+    message.to_id = std::string(64, 'b');
+    message.content = "Loop me";
+    message.type = "chat";
+
+    std::vector<uint8_t> buffer(mesh::protocol::encodedSize(message));
+    size_t written = 0;
+    ASSERT_TRUE(mesh::protocol::encodeMessage(message, buffer.data(), buffer.size(), written));
+
+    // Relays stamp themselves in place; the frame size never changes
+    std::vector<mesh::protocol::HopId> relays;
+    for (int i = 0; i < 40; ++i) {
+        relays.push_back(makeHopId("relay-" + std::to_string(i)));
+        ASSERT_TRUE(mesh::protocol::appendHop(buffer.data(), written, relays.back()));
+        message.path.append(relays.back());
+    }
+    EXPECT_EQ(written, mesh::protocol::encodedSize(message));
+
+    mesh::protocol::MessageView view;
+    ASSERT_TRUE(view.parse(buffer.data(), written));
+    EXPECT_EQ(view.hopCount(), 40u);
+    EXPECT_EQ(view.hopPath(), message.path);
+    for (auto hop : relays) {
+        EXPECT_TRUE(view.hasVisited(hop));
+    }
+
+    // The list keeps the most recent hops, oldest first
+    EXPECT_EQ(message.path.size(), HopPath::kCapacity);
+    EXPECT_TRUE(message.path.overflowed());
+    EXPECT_EQ(message.path.at(0), relays[40 - HopPath::kCapacity]);
+    EXPECT_EQ(message.path.at(HopPath::kCapacity - 1), relays.back());
+
+    // Below capacity every answer is exact
+    HopPath path;
+    for (int i = 0; i < 10; ++i) {
+        path.append(relays[i]);
+    }
+    for (int i = 0; i < 40; ++i) {
+        EXPECT_EQ(path.contains(relays[i]), i < 10);
+    }
+
+    mesh::protocol::Message decoded;
+    ASSERT_TRUE(view.toMessage(decoded));
+    EXPECT_EQ(decoded.path, message.path);
+    decoded.path.append(makeHopId("one more"));
+    EXPECT_EQ(mesh::protocol::encodedSize(decoded), written);
+}
+
+TEST_F(CppInteropTest, PayloadCompressionStage) {
+    mesh::protocol::CompressionStage stage;
+
+    mesh::protocol::Message message;
+    message.id = mesh::protocol::MessageId::fromHex("00112233-4455-6677-8899-aabbccddeeff");
+    message.from_id = std::string(64, 'a');
+    message.to_id = mesh::protocol::kBroadcastId;
+    message.type = "chat";
+    message.content = "Hey, where are you? I'm on my way, see you soon. Thank you!";
+
+    // Short chat text shrinks through the dictionary codec
+    std::vector<uint8_t> plain(mesh::protocol::encodedSize(message));
+    size_t written = 0;
+    ASSERT_TRUE(mesh::protocol::encodeMessage(message, plain.data(), plain.size(), written));
+    std::vector<uint8_t> frame;
+    bool compressed = false;
+    ASSERT_TRUE(stage.compressFrame(plain.data(), written, frame, &compressed));
+    EXPECT_TRUE(compressed);
+    EXPECT_LT(frame.size(), written);
+
+    // Relays still read the header and stamp hops without decompressing
+    ASSERT_TRUE(mesh::protocol::appendHop(frame.data(), frame.size(), mesh::protocol::makeHopId("relay")));
+    mesh::protocol::MessageView view;
+    ASSERT_TRUE(view.parse(frame.data(), frame.size()));
+    EXPECT_TRUE(view.isCompressed());
+    EXPECT_TRUE(view.isBroadcast());
+    EXPECT_EQ(view.hopCount(), 1u);
+
+    mesh::protocol::Message decoded;
+    EXPECT_FALSE(mesh::protocol::decodeMessage(frame.data(), frame.size(), decoded));
+    ASSERT_TRUE(stage.decode(frame.data(), frame.size(), decoded));
+    EXPECT_EQ(decoded.content, message.content);
+    EXPECT_EQ(decoded.type, message.type);
+    EXPECT_TRUE(decoded.path.contains(mesh::protocol::makeHopId("relay")));
+
+    // Large repetitive content goes through plain deflate
+    message.content.clear();
+    for (int i = 0; i < 64; ++i) {
+        message.content += "{\"sensor\":\"temp\",\"value\":" + std::to_string(20 + i % 5) + "}";
+    }
+    ASSERT_TRUE(stage.encode(message, frame));
+    ASSERT_TRUE(view.parse(frame.data(), frame.size()));
+    EXPECT_TRUE(view.isCompressed());
+    EXPECT_EQ(view.contentBytes().data[0], mesh::protocol::kCodecDeflate);
+    ASSERT_TRUE(stage.decode(frame.data(), frame.size(), decoded));
+    EXPECT_EQ(decoded.content, message.content);
+
+    // Below the threshold the frame passes through unchanged
+    message.content = "ok";
+    ASSERT_TRUE(stage.encode(message, frame));
+    ASSERT_TRUE(view.parse(frame.data(), frame.size()));
+    EXPECT_FALSE(view.isCompressed());
+    ASSERT_TRUE(mesh::protocol::decodeMessage(frame.data(), frame.size(), decoded));
+    EXPECT_EQ(decoded.content, "ok");
+
+    // Corrupt or unknown compressed bodies are rejected
+    ASSERT_TRUE(stage.compressFrame(plain.data(), written, frame, &compressed));
+    frame.back() ^= 0x5A;
+    EXPECT_FALSE(stage.decode(frame.data(), frame.size(), decoded));
+    mesh::protocol::CompressionStage other;
+    other.registerCodec(mesh::protocol::makeDeflateCodec(mesh::protocol::kCodecChatDictionary));
+    ASSERT_TRUE(stage.compressFrame(plain.data(), written, frame, &compressed));
+    EXPECT_FALSE(other.decode(frame.data(), frame.size(), decoded));
+}
+
+TEST_F(CppInteropTest, MessageIdGenerator) {
+    using mesh::protocol::MessageId;
+
+    MessageId id = MessageId::fromHex("00112233-4455-6677-8899-aabbccddeeff");
+    EXPECT_EQ(id.high, 0x0011223344556677ull);
+    EXPECT_EQ(id.low, 0x8899aabbccddeeffull);
+    EXPECT_EQ(id.toHex(), "00112233-4455-6677-8899-aabbccddeeff");
+    EXPECT_EQ(MessageId::fromHex("00112233445566778899AABBCCDDEEFF"), id);
+    EXPECT_TRUE(MessageId::fromHex("00112233-4455-6677-8899-aabbccddeefg").isNil());
+    EXPECT_TRUE(MessageId::fromHex("0011223344-55-6677-8899-aabbccddeeff").isNil());
+
+    // The hash is persisted by dedup tables, so it must never change
+    EXPECT_EQ(id.hash(), 0x34ec59058bc25590ull);
+
+    uint8_t bytes[MessageId::kSize];
+    id.toBytes(bytes);
+    EXPECT_EQ(bytes[0], 0x00);
+    EXPECT_EQ(bytes[15], 0xff);
+    EXPECT_EQ(MessageId::fromBytes(bytes), id);
+
+    // Unique across threads, strictly increasing within each thread
+    mesh::protocol::MessageIdGenerator generator(
+        mesh::protocol::MessageIdGenerator::prefixFor(std::string(64, 'a')));
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 5000;
+    std::vector<std::vector<MessageId>> issued(kThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                issued[t].push_back(generator.next());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::unordered_set<MessageId> seen;
+    for (const auto& ids : issued) {
+        for (size_t i = 0; i < ids.size(); ++i) {
+            EXPECT_EQ(ids[i].high, generator.getPrefix());
+            if (i > 0) {
+                EXPECT_LT(ids[i - 1], ids[i]);
+            }
+            seen.insert(ids[i]);
+        }
+    }
+    EXPECT_EQ(seen.size(), static_cast<size_t>(kThreads * kPerThread));
+
+    // Generators interleaved on one thread each keep their own block, so
+    // their counters stay dense instead of jumping a block per call
+    mesh::protocol::MessageIdGenerator first(1);
+    mesh::protocol::MessageIdGenerator second(2);
+    MessageId last_first = first.next();
+    MessageId last_second = second.next();
+    for (int i = 0; i < 3000; ++i) {
+        MessageId a = first.next();
+        MessageId b = second.next();
+        ASSERT_EQ(a.low, last_first.low + 1);
+        ASSERT_EQ(b.low, last_second.low + 1);
+        last_first = a;
+        last_second = b;
+    }
+}
+
+TEST_F(CppInteropTest, CoarseClockExpiry) {
+    using mesh::protocol::CoarseClock;
+
+    // now() is always current, even on a thread that never ticks
+    auto first = CoarseClock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_GT(CoarseClock::now(), first);
+
+    auto start = CoarseClock::tick();
+    EXPECT_EQ(CoarseClock::cached(), start);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(CoarseClock::cached(), start);  // cached until the next tick
+    EXPECT_GT(CoarseClock::now(), start);
+    EXPECT_GT(CoarseClock::tick(), start);
+
+    // A thread that has never ticked reads the clock directly
+    CoarseClock::time_point fresh;
+    std::thread([&] { fresh = CoarseClock::cached(); }).join();
+    EXPECT_GE(fresh, CoarseClock::cached());
+
+    mesh::protocol::Message message;
+    EXPECT_FALSE(message.isExpired());
+    message.setMaxAge(std::chrono::milliseconds(50));
+    EXPECT_FALSE(message.isExpired());
+    EXPECT_TRUE(message.isExpired(CoarseClock::now() + std::chrono::milliseconds(50)));
+
+    message.ttl = 0;
+    EXPECT_TRUE(message.isExpired(CoarseClock::time_point()));
+
+    // The deadline is local and does not survive the wire
+    message.ttl = 3;
+    message.id = mesh::protocol::MessageId::fromHex("00112233-4455-6677-8899-aabbccddeeff");
+    message.from_id = std::string(64, 'a');
+    message.to_id = std::string(64, 'b');
+    std::vector<uint8_t> buffer(mesh::protocol::encodedSize(message));
+    size_t written = 0;
+    ASSERT_TRUE(mesh::protocol::encodeMessage(message, buffer.data(), buffer.size(), written));
+    mesh::protocol::Message decoded = message;
+    ASSERT_TRUE(mesh::protocol::decodeMessage(buffer.data(), written, decoded));
+    EXPECT_EQ(decoded.expires_at, CoarseClock::time_point::max());
+}
+
+TEST_F(CppInteropTest, PriorityMessageQueue) {
+    using mesh::broker::MessageQueue;
+    using mesh::protocol::MessagePriority;
+
+    auto makeMessage = [](MessagePriority priority, uint64_t seq) {
+        mesh::protocol::Message message;
+        message.priority = priority;
+        message.id.low = seq;
+        return message;
+    };
+
+    // Bulk traffic queued first does not hold back control messages
+    MessageQueue queue;
+    for (uint64_t i = 0; i < 100; ++i) {
+        ASSERT_TRUE(queue.push(makeMessage(MessagePriority::Low, i)));
+        ASSERT_TRUE(queue.push(makeMessage(MessagePriority::Normal, i)));
+    }
+    for (uint64_t i = 0; i < 100; ++i) {
+        ASSERT_TRUE(queue.push(makeMessage(MessagePriority::High, i)));
+    }
+    EXPECT_EQ(queue.size(), 300u);
+
+    // One round with default weights: 16 High, 4 Normal, 1 Low, in FIFO order per class
+    std::map<MessagePriority, uint64_t> served;
+    mesh::protocol::Message message;
+    for (int i = 0; i < 21; ++i) {
+        ASSERT_TRUE(queue.pop(message));
+        EXPECT_EQ(message.id.low, served[message.priority]++);
+    }
+    EXPECT_EQ(served[MessagePriority::High], 16u);
+    EXPECT_EQ(served[MessagePriority::Normal], 4u);
+    EXPECT_EQ(served[MessagePriority::Low], 1u);
+
+    auto high = queue.getClassStats(MessagePriority::High);
+    EXPECT_EQ(high.depth, 84u);
+    EXPECT_EQ(high.dequeued, 16u);
+
+    // Idle classes do not stall the round
+    while (queue.pop(message)) {
+    }
+    EXPECT_TRUE(queue.empty());
+
+    // Overdue Low messages are served ahead of High
+    MessageQueue::Config config;
+    config.low_max_wait = std::chrono::milliseconds(0);
+    config.max_depth = 8;
+    MessageQueue strict(config);
+    ASSERT_TRUE(strict.push(makeMessage(MessagePriority::High, 0)));
+    ASSERT_TRUE(strict.push(makeMessage(MessagePriority::Low, 0)));
+    ASSERT_TRUE(strict.pop(message));
+    EXPECT_EQ(message.priority, MessagePriority::Low);
+
+    // Full lanes reject instead of growing
+    for (uint64_t i = 0; i < 7; ++i) {
+        ASSERT_TRUE(strict.push(makeMessage(MessagePriority::High, i + 1)));
+    }
+    EXPECT_FALSE(strict.push(makeMessage(MessagePriority::High, 8)));
+    EXPECT_TRUE(strict.push(makeMessage(MessagePriority::Normal, 0)));
+    EXPECT_EQ(strict.getClassStats(MessagePriority::High).rejected, 1u);
+
+    // Concurrent producers, single consumer: nothing lost or duplicated
+    MessageQueue shared;
+    constexpr int kProducers = 4;
+    constexpr uint64_t kPerProducer = 1000;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p] {
+            for (uint64_t i = 0; i < kPerProducer; ++i) {
+                auto priority = static_cast<MessagePriority>(i % 3);
+                while (!shared.push(makeMessage(priority, p * kPerProducer + i))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    std::vector<bool> seen(kProducers * kPerProducer, false);
+    size_t received = 0;
+    while (received < seen.size()) {
+        if (shared.pop(message)) {
+            ASSERT_FALSE(seen[message.id.low]);
+            seen[message.id.low] = true;
+            ++received;
+        }
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_TRUE(shared.empty());
+
+    // Waits are measured across threads: a producer that has been idle
+    // must not stamp its messages with the time it was last active
+    MessageQueue::Config aging_config;
+    aging_config.low_max_wait = std::chrono::milliseconds(200);
+    MessageQueue aging(aging_config);
+    std::thread producer([&] {
+        aging.push(makeMessage(MessagePriority::Normal, 0));
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        for (uint64_t i = 0; i < 5; ++i) {
+            aging.push(makeMessage(MessagePriority::High, i));
+        }
+        for (uint64_t i = 0; i < 5; ++i) {
+            aging.push(makeMessage(MessagePriority::Low, i));
+        }
+    });
+    producer.join();
+    mesh::protocol::CoarseClock::tick();  // as the consumer's own loop would
+
+    std::vector<mesh::protocol::Message> batch(11);
+    ASSERT_EQ(aging.popBatch(batch.data(), batch.size()), 11u);
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(batch[i].priority, MessagePriority::High) << "position " << i;
+    }
+    EXPECT_EQ(batch[5].priority, MessagePriority::Normal);
+    EXPECT_LT(aging.getClassStats(MessagePriority::High).max_wait_ms, 100.0);
+    EXPECT_GE(aging.getClassStats(MessagePriority::Normal).max_wait_ms, 250.0);
+}
+
+TEST_F(CppInteropTest, MpmcRingQueue) {
+    using mesh::broker::MessageQueue;
+    using mesh::broker::MpmcRing;
+    using mesh::protocol::MessagePriority;
+
+    MpmcRing<uint64_t> ring(5);
+    EXPECT_EQ(ring.capacity(), 8u);
+    for (uint64_t i = 0; i < 8; ++i) {
+        ASSERT_TRUE(ring.tryPush(i));
+    }
+    EXPECT_FALSE(ring.tryPush(8));
+    ASSERT_NE(ring.peek(), nullptr);
+    EXPECT_EQ(*ring.peek(), 0u);
+
+    // A batch claims a FIFO run in one go and frees its slots
+    std::vector<uint64_t> batch;
+    EXPECT_EQ(ring.popBatch(5, [&](uint64_t& value) { batch.push_back(value); }), 5u);
+    EXPECT_EQ(batch, (std::vector<uint64_t>{0, 1, 2, 3, 4}));
+    EXPECT_EQ(ring.sizeApprox(), 3u);
+    EXPECT_TRUE(ring.tryPush(8));
+
+    // Concurrent producers and consumers: nothing lost or duplicated
+    MpmcRing<uint64_t> shared(64);
+    constexpr uint64_t kPerProducer = 20000;
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> taken{0};
+    std::vector<std::thread> threads;
+    for (uint64_t p = 0; p < 3; ++p) {
+        threads.emplace_back([&, p] {
+            for (uint64_t i = 1; i <= kPerProducer; ++i) {
+                while (!shared.tryPush(p * kPerProducer + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < 2; ++c) {
+        threads.emplace_back([&] {
+            while (taken.load() < 3 * kPerProducer) {
+                size_t n = shared.popBatch(8, [&](uint64_t& value) { sum.fetch_add(value); });
+                taken.fetch_add(n);
+                if (n == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    uint64_t count = 3 * kPerProducer;
+    EXPECT_EQ(sum.load(), count * (count + 1) / 2);
+
+    // Batch dequeue follows the same weighted order as single pops
+    auto makeMessage = [](MessagePriority priority, uint64_t seq) {
+        mesh::protocol::Message message;
+        message.priority = priority;
+        message.id.low = seq;
+        return message;
+    };
+    MessageQueue single;
+    MessageQueue batched;
+    for (uint64_t i = 0; i < 40; ++i) {
+        single.push(makeMessage(static_cast<MessagePriority>(i % 3), i));
+        batched.push(makeMessage(static_cast<MessagePriority>(i % 3), i));
+    }
+    std::vector<mesh::protocol::Message> out(16);
+    std::vector<uint64_t> batched_order;
+    while (size_t n = batched.popBatch(out.data(), out.size())) {
+        for (size_t i = 0; i < n; ++i) {
+            batched_order.push_back(out[i].id.low);
+        }
+    }
+    std::vector<uint64_t> single_order;
+    mesh::protocol::Message message;
+    while (single.pop(message)) {
+        single_order.push_back(message.id.low);
+    }
+    EXPECT_EQ(batched_order.size(), 40u);
+    EXPECT_EQ(batched_order, single_order);
+    EXPECT_EQ(batched.getClassStats(MessagePriority::High).dequeued, 13u);
+
+    // Blocking enqueue waits for the consumer instead of failing
+    MessageQueue::Config config;
+    config.max_depth = 2;
+    config.enqueue_policy = MessageQueue::EnqueuePolicy::Block;
+    config.block_timeout = std::chrono::seconds(5);
+    MessageQueue blocking(config);
+    ASSERT_TRUE(blocking.push(makeMessage(MessagePriority::High, 0)));
+    ASSERT_TRUE(blocking.push(makeMessage(MessagePriority::High, 1)));
+    std::thread consumer([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        mesh::protocol::Message popped;
+        blocking.pop(popped);
+    });
+    EXPECT_TRUE(blocking.push(makeMessage(MessagePriority::High, 2)));
+    consumer.join();
+    EXPECT_EQ(blocking.getClassStats(MessagePriority::High).blocked, 1u);
+    EXPECT_EQ(blocking.getClassStats(MessagePriority::High).rejected, 0u);
+
+    config.block_timeout = std::chrono::milliseconds(1);
+    MessageQueue timed(config);
+    ASSERT_TRUE(timed.push(makeMessage(MessagePriority::Low, 0)));
+    ASSERT_TRUE(timed.push(makeMessage(MessagePriority::Low, 1)));
+    EXPECT_FALSE(timed.push(makeMessage(MessagePriority::Low, 2)));
+    EXPECT_EQ(timed.getClassStats(MessagePriority::Low).rejected, 1u);
+}
+
+TEST_F(CppInteropTest, EventDrivenWakeup) {
+    using mesh::broker::MessageQueue;
+    using mesh::broker::waitReadable;
+
+    // Nothing pending: waits time out without firing
+    mesh::broker::EventFd stop;
+    mesh::broker::TimerFd timer(std::chrono::milliseconds(10));
+    MessageQueue queue;
+    ASSERT_TRUE(queue.prepareWait());
+    EXPECT_EQ(waitReadable({queue.wakeFd(), stop.fd()}, std::chrono::milliseconds(1)), 0u);
+    queue.finishWait();
+
+    // A push from another thread wakes an armed consumer
+    mesh::protocol::Message message;
+    message.id.low = 7;
+    ASSERT_TRUE(queue.prepareWait());
+    std::thread producer([&] { queue.push(message); });
+    EXPECT_EQ(waitReadable({queue.wakeFd(), stop.fd()}, std::chrono::seconds(5)), 1u);
+    queue.finishWait();
+    producer.join();
+
+    // A consumer with work pending never arms
+    EXPECT_FALSE(queue.prepareWait());
+    mesh::protocol::Message popped;
+    ASSERT_TRUE(queue.pop(popped));
+    EXPECT_EQ(popped.id.low, 7u);
+
+    // Unarmed pushes do not touch the eventfd
+    queue.push(message);
+    EXPECT_EQ(waitReadable({queue.wakeFd()}, std::chrono::milliseconds(0)), 0u);
+
+    // Timers and stop events report their own bit
+    stop.notify();
+    EXPECT_TRUE(waitReadable({timer.fd(), stop.fd()}, std::chrono::milliseconds(0)) & 2u);
+    EXPECT_EQ(stop.drain(), 1u);
+    EXPECT_EQ(waitReadable({timer.fd(), stop.fd()}, std::chrono::seconds(5)), 1u);
+    EXPECT_GE(timer.drain(), 1u);
+}
+
+TEST_F(CppInteropTest, ShardedStatsCounters) {
+    enum : size_t { kSent, kDelivered, kCount };
+    mesh::broker::ShardedCounters<kCount> counters;
+
+    counters.add(kSent, 3);
+    counters.add(kDelivered);
+    EXPECT_EQ(counters.read(kSent), 3u);
+    EXPECT_EQ(counters.read(kDelivered), 1u);
+
+    // Increments from many threads land on different shards but sum exactly
+    constexpr int kThreads = 8;
+    constexpr uint64_t kPerThread = 50000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&] {
+            for (uint64_t i = 0; i < kPerThread; ++i) {
+                counters.add(kSent);
+                if (i % 2 == 0) {
+                    counters.add(kDelivered);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto totals = counters.readAll();
+    EXPECT_EQ(totals[kSent], 3 + kThreads * kPerThread);
+    EXPECT_EQ(totals[kDelivered], 1 + kThreads * kPerThread / 2);
+
+    counters.reset();
+    EXPECT_EQ(counters.read(kSent), 0u);
+}
+
+TEST_F(CppInteropTest, LatencyHistogramPercentiles) {
+    using mesh::broker::LatencyHistogram;
+
+    // Buckets are contiguous and every value lands within 1/16 of itself
+    for (uint64_t value : {0ull, 1ull, 15ull, 16ull, 17ull, 31ull, 32ull, 1000ull, 123456ull, 1ull << 39}) {
+        size_t index = LatencyHistogram::bucketIndex(value);
+        uint64_t upper = LatencyHistogram::bucketUpperBound(index);
+        EXPECT_GE(upper, value);
+        EXPECT_LE(upper - value, value / 16);
+        if (index > 0) {
+            EXPECT_LT(LatencyHistogram::bucketUpperBound(index - 1), value);
+        }
+    }
+    EXPECT_EQ(LatencyHistogram::bucketIndex(~0ull), LatencyHistogram::kBucketCount - 1);
+
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.summarize().count, 0u);
+    for (uint64_t us = 1; us <= 10000; ++us) {
+        histogram.recordMicros(us);
+    }
+    auto summary = histogram.summarize();
+    EXPECT_EQ(summary.count, 10000u);
+    EXPECT_DOUBLE_EQ(summary.mean_us, 5000.5);
+    EXPECT_EQ(summary.max_us, 10000u);
+    auto near = [](uint64_t reported, uint64_t exact) {
+        return reported >= exact && reported - exact <= exact / 16;
+    };
+    EXPECT_TRUE(near(summary.p50_us, 5000)) << summary.p50_us;
+    EXPECT_TRUE(near(summary.p90_us, 9000)) << summary.p90_us;
+    EXPECT_TRUE(near(summary.p99_us, 9900)) << summary.p99_us;
+    EXPECT_EQ(summary.p999_us, 10000u);
+
+    // Per-priority breakdown and the merged view
+    mesh::broker::PriorityLatency latency;
+    for (int i = 0; i < 99; ++i) {
+        latency.record(mesh::protocol::MessagePriority::High, std::chrono::microseconds(100));
+    }
+    latency.record(mesh::protocol::MessagePriority::Low, std::chrono::milliseconds(50));
+    auto stats = latency.summarize();
+    EXPECT_EQ(stats.all.count, 100u);
+    EXPECT_TRUE(near(stats.all.p50_us, 100)) << stats.all.p50_us;
+    EXPECT_EQ(stats.all.max_us, 50000u);
+    EXPECT_EQ(stats.by_priority[static_cast<size_t>(mesh::protocol::MessagePriority::High)].max_us, 100u);
+    EXPECT_EQ(stats.by_priority[static_cast<size_t>(mesh::protocol::MessagePriority::Low)].p50_us, 50000u);
+    EXPECT_EQ(stats.by_priority[static_cast<size_t>(mesh::protocol::MessagePriority::Normal)].count, 0u);
+
+    // Concurrent recorders lose nothing
+    LatencyHistogram shared;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (uint64_t i = 0; i < 10000; ++i) {
+                shared.recordMicros(i + t);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(shared.summarize().count, 40000u);
+    EXPECT_EQ(shared.summarize().max_us, 10002u);
+}
+
+TEST_F(CppInteropTest, PeerSnapshotPublication) {
+    using Table = std::map<std::string, std::shared_ptr<int>>;
+    mesh::broker::SnapshotCell<Table> cell;
+
+    auto empty = cell.load();
+    EXPECT_EQ(empty->version, 0u);
+    EXPECT_TRUE(empty->value.empty());
+
+    auto peer = std::make_shared<int>(1);
+    EXPECT_EQ(cell.update([&](Table& table) { table["a"] = peer; }), 1u);
+    EXPECT_EQ(cell.update([&](Table& table) { table["b"] = std::make_shared<int>(2); }), 2u);
+
+    // Readers keep the version they loaded; elements are shared, not copied
+    auto first = cell.load();
+    cell.update([](Table& table) { table.erase("a"); });
+    EXPECT_TRUE(empty->value.empty());
+    EXPECT_EQ(first->version, 2u);
+    EXPECT_EQ(first->value.size(), 2u);
+    EXPECT_EQ(first->value.at("a"), peer);
+    EXPECT_EQ(cell.load()->value.count("a"), 0u);
+    EXPECT_EQ(peer.use_count(), 2);
+
+    // Concurrent readers always see a complete table
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (int i = 0; i < 2000; ++i) {
+            cell.update([i](Table& table) {
+                table["x" + std::to_string(i % 8)] = std::make_shared<int>(i);
+                table["y" + std::to_string(i % 8)] = std::make_shared<int>(i);
+            });
+        }
+        done = true;
+    });
+    uint64_t last_version = 0;
+    while (!done) {
+        auto snapshot = cell.load();
+        EXPECT_GE(snapshot->version, last_version);
+        last_version = snapshot->version;
+        for (int i = 0; i < 8; ++i) {
+            auto x = snapshot->value.find("x" + std::to_string(i));
+            auto y = snapshot->value.find("y" + std::to_string(i));
+            ASSERT_EQ(x == snapshot->value.end(), y == snapshot->value.end());
+            if (x != snapshot->value.end()) {
+                ASSERT_EQ(*x->second, *y->second);
+            }
+        }
+    }
+    writer.join();
+    EXPECT_EQ(cell.load()->version, 2003u);
+}
+
+TEST_F(CppInteropTest, MultiAdapterHub) {
+    using mesh::broker::AdapterHub;
+
+    // Records what each adapter was asked to send
+    struct RecordingAdapter : mesh::broker::Adapter {
+        RecordingAdapter(std::string name, std::mutex& mutex, std::vector<std::string>& log)
+            : name_(std::move(name)), mutex_(mutex), log_(log) {}
+        std::string name() const override { return name_; }
+        bool send(const mesh::protocol::Message& message) override {
+            std::lock_guard<std::mutex> lock(mutex_);
+            log_.push_back(name_ + ":" + message.content);
+            return true;
+        }
+        std::string name_;
+        std::mutex& mutex_;
+        std::vector<std::string>& log_;
+    };
+
+    std::mutex mutex;
+    std::vector<std::string> sent;
+    std::vector<std::string> delivered;
+    AdapterHub hub("gateway", [&](const mesh::protocol::Message& message) {
+        std::lock_guard<std::mutex> lock(mutex);
+        delivered.push_back(message.content);
+    });
+    size_t wifi = hub.addAdapter(std::make_unique<RecordingAdapter>("wifi", mutex, sent));
+    size_t ble = hub.addAdapter(std::make_unique<RecordingAdapter>("ble", mutex, sent));
+    hub.setRoute("phone", ble);
+    ASSERT_TRUE(hub.start());
+
+    auto makeMessage = [](const std::string& to, const std::string& content) {
+        mesh::protocol::Message message;
+        message.to_id = to;
+        message.content = content;
+        return message;
+    };
+    auto waitFor = [&](size_t count) {
+        for (int i = 0; i < 5000; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (sent.size() >= count) {
+                    return;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+
+    // Bridged from WiFi to the BLE peer without leaving the process
+    EXPECT_TRUE(hub.route(makeMessage("phone", "unicast"), wifi));
+    waitFor(1);
+    // Broadcasts go out everywhere except where they came from, and are delivered locally
+    EXPECT_TRUE(hub.route(makeMessage(mesh::protocol::kBroadcastId, "broadcast"), ble));
+    waitFor(2);
+    // Unknown destinations from the local node go out on every adapter
+    EXPECT_TRUE(hub.route(makeMessage("stranger", "flood")));
+    waitFor(4);
+    EXPECT_TRUE(hub.route(makeMessage("gateway", "local"), wifi));
+
+    // A message this hub already relayed is dropped
+    auto looped = makeMessage("phone", "looped");
+    looped.path.append(mesh::protocol::makeHopId("gateway"));
+    EXPECT_FALSE(hub.route(looped, wifi));
+    EXPECT_EQ(hub.loopsDropped(), 1u);
+
+    // Relaying spends a hop; messages out of hops or past their age are dropped
+    auto last_hop = makeMessage("phone", "last-hop");
+    last_hop.ttl = 1;
+    EXPECT_FALSE(hub.route(last_hop, wifi));
+    auto stale = makeMessage("phone", "stale");
+    stale.setMaxAge(std::chrono::milliseconds(10));
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_FALSE(hub.route(stale, wifi));
+
+    hub.stop();
+    std::sort(sent.begin(), sent.end());
+    EXPECT_EQ(sent, (std::vector<std::string>{"ble:flood", "ble:unicast", "wifi:broadcast", "wifi:flood"}));
+    EXPECT_EQ(delivered, (std::vector<std::string>{"broadcast", "local"}));
+
+    auto stats = hub.getStats();
+    ASSERT_EQ(stats.size(), 2u);
+    EXPECT_EQ(stats[wifi].name, "wifi");
+    EXPECT_EQ(stats[wifi].received, 5u);
+    EXPECT_EQ(stats[wifi].sent, 2u);
+    EXPECT_EQ(stats[ble].received, 1u);
+    EXPECT_EQ(stats[ble].sent, 2u);
+
+    // Broadcasts cross a wire adapter to a second hub, whether the sender
+    // names kBroadcastId or leaves to_id empty
+    mesh::broker::EmulatedLink link(mesh::broker::LinkProfile{});
+    std::vector<std::string> heard;
+    AdapterHub near_hub("near", [](const mesh::protocol::Message&) {});
+    AdapterHub far_hub("far", [&](const mesh::protocol::Message& message) {
+        std::lock_guard<std::mutex> lock(mutex);
+        heard.push_back(message.to_id + ":" + message.content);
+    });
+    size_t far_air = 0;
+    size_t near_air = near_hub.addAdapter(link.makeAdapter(
+        mesh::broker::EmulatedLink::End::A, "air",
+        [&](const mesh::protocol::Message& message) { near_hub.route(message, near_air); }));
+    far_air = far_hub.addAdapter(link.makeAdapter(
+        mesh::broker::EmulatedLink::End::B, "air",
+        [&](const mesh::protocol::Message& message) { far_hub.route(message, far_air); }));
+    ASSERT_TRUE(near_hub.start());
+    ASSERT_TRUE(far_hub.start());
+
+    auto named = makeMessage(mesh::protocol::kBroadcastId, "named");
+    auto unnamed = makeMessage("", "unnamed");
+    named.from_id = unnamed.from_id = std::string(64, 'a');
+    EXPECT_TRUE(near_hub.route(named));
+    EXPECT_TRUE(near_hub.route(unnamed));
+    for (int i = 0; i < 5000; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (heard.size() >= 2) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    near_hub.stop();
+    far_hub.stop();
+    link.close();
+
+    EXPECT_EQ(heard, (std::vector<std::string>{"broadcast:named", "broadcast:unnamed"}));
+    EXPECT_EQ(near_hub.getStats()[near_air].sent, 2u);
+    EXPECT_EQ(near_hub.getStats()[near_air].failed, 0u);
+    EXPECT_EQ(far_hub.getStats()[far_air].received, 2u);
+}
+
+TEST_F(CppInteropTest, EmulatedMeshAtScale) {
+    using mesh::broker::EmulatedMesh;
+    using Duration = EmulatedMesh::Duration;
+
+    // 5x5 grid: node 24 is eight hops from node 0
+    EmulatedMesh::Config config;
+    config.link_delay = Duration(2000);
+    config.tx_time = Duration(100);
+    EmulatedMesh grid(config);
+    EXPECT_EQ(grid.addNodes(25), 0u);
+    grid.connectGrid(5);
+    EXPECT_EQ(grid.linkCount(), 40u);
+    EXPECT_FALSE(grid.connect(0, 1));
+    EXPECT_FALSE(grid.connect(3, 3));
+
+    // No routes yet: unicast floods, still arrives exactly once
+    std::vector<std::pair<EmulatedMesh::NodeIndex, Duration>> deliveries;
+    grid.setDeliverHandler([&](EmulatedMesh::NodeIndex node, const mesh::protocol::Message& message,
+                               Duration latency) {
+        EXPECT_EQ(message.content, "hello");
+        deliveries.emplace_back(node, latency);
+    });
+    ASSERT_TRUE(grid.send(24, 0, "hello"));
+    grid.run();
+    EXPECT_TRUE(grid.idle());
+    ASSERT_EQ(deliveries.size(), 1u);
+    EXPECT_EQ(deliveries[0].first, 0u);
+    EXPECT_GT(grid.getStats().flooded, 0u);
+    EXPECT_GT(grid.getStats().duplicates, 0u);
+
+    // The flood taught every node a route back to 24
+    Duration converged;
+    ASSERT_TRUE(grid.convergenceTime(24, converged));
+    EXPECT_EQ(grid.routeCount(24), 24u);
+    EXPECT_FALSE(grid.convergenceTime(0, converged));
+
+    // A broadcast beacon from 0 reaches every node and converges routes to it
+    deliveries.clear();
+    auto start = grid.now();
+    grid.send(0, EmulatedMesh::kBroadcast, "hello");
+    grid.run();
+    EXPECT_EQ(deliveries.size(), 24u);
+    ASSERT_TRUE(grid.convergenceTime(0, converged));
+    // Eight hops, each waiting for up to four frames to serialize
+    EXPECT_GE(converged - start, 8 * (config.tx_time + config.link_delay));
+    EXPECT_LE(converged - start, 8 * (config.tx_time * 4 + config.link_delay));
+
+    // Now unicast follows the shortest route, one frame per hop
+    deliveries.clear();
+    auto before = grid.getStats();
+    grid.send(24, 0, "hello");
+    grid.run();
+    auto after = grid.getStats();
+    ASSERT_EQ(deliveries.size(), 1u);
+    EXPECT_EQ(deliveries[0].second, 8 * (config.tx_time + config.link_delay));
+    EXPECT_EQ(after.transmissions - before.transmissions, 8u);
+    EXPECT_EQ(after.flooded, before.flooded);
+    EXPECT_EQ(after.routed - before.routed, 8u);
+
+    // TTL bounds how far a flood travels
+    config.ttl = 2;
+    EmulatedMesh line(config);
+    line.addNodes(6);
+    line.connectGrid(6);
+    size_t heard = 0;
+    line.setDeliverHandler([&](EmulatedMesh::NodeIndex, const mesh::protocol::Message&, Duration) { ++heard; });
+    line.send(0, EmulatedMesh::kBroadcast, "beacon");
+    line.run();
+    EXPECT_EQ(heard, 2u);
+    EXPECT_EQ(line.getStats().expired, 1u);
+
+    // Thousands of nodes in one process; identical runs give identical results
+    auto converge = [](size_t nodes) {
+        EmulatedMesh mesh;
+        mesh.addNodes(nodes);
+        mesh.connectRandom(2, 7);
+        mesh.send(0, EmulatedMesh::kBroadcast, "beacon");
+        mesh.run();
+        Duration at(-1);
+        mesh.convergenceTime(0, at);
+        return std::make_pair(at, mesh.getStats().transmissions);
+    };
+    auto first = converge(5000);
+    EXPECT_GT(first.first.count(), 0);
+    EXPECT_EQ(converge(5000), first);
+
+    // run(until) stops the clock at the limit
+    EmulatedMesh partial;
+    partial.addNodes(100);
+    partial.connectGrid(10);
+    partial.send(0, EmulatedMesh::kBroadcast, "beacon");
+    partial.run(Duration(5000));
+    EXPECT_FALSE(partial.idle());
+    EXPECT_LE(partial.now(), Duration(5000));
+    EXPECT_GT(partial.routeCount(0), 0u);
+    EXPECT_LT(partial.routeCount(0), 99u);
+}
+
+TEST_F(CppInteropTest, LinkModelEmulation) {
+    using mesh::broker::LinkModel;
+    using mesh::broker::LinkProfile;
+    using Direction = LinkModel::Direction;
+    using Outcome = LinkModel::Outcome;
+    using us = std::chrono::microseconds;
+
+    // 8 Mbit/s: a 1000-byte frame takes 1ms to serialize
+    LinkProfile profile;
+    profile.bandwidth_bps = 8'000'000;
+    profile.delay = us(500);
+    profile.mtu = 1200;
+    profile.max_backlog = us(5000);
+    LinkModel link(profile);
+
+    EXPECT_EQ(link.transmit(Direction::AtoB, 1201, us(0)).outcome, Outcome::Oversize);
+    for (int i = 0; i < 5; ++i) {
+        auto verdict = link.transmit(Direction::AtoB, 1000, us(0));
+        ASSERT_EQ(verdict.outcome, Outcome::Delivered);
+        EXPECT_EQ(verdict.departs_at, us(1000 * (i + 1)));
+        EXPECT_EQ(verdict.arrives_at, us(1000 * (i + 1) + 500));
+    }
+    // A sixth frame would wait 6ms, past max_backlog
+    EXPECT_EQ(link.transmit(Direction::AtoB, 1000, us(0)).outcome, Outcome::Congested);
+    EXPECT_EQ(link.getStats(Direction::AtoB).delivered, 5u);
+    EXPECT_EQ(link.getStats(Direction::AtoB).congested, 1u);
+    EXPECT_EQ(link.getStats(Direction::AtoB).oversize, 1u);
+
+    // Half duplex: the reverse direction waits for the same airtime;
+    // full duplex does not
+    EXPECT_EQ(link.transmit(Direction::BtoA, 1000, us(2000)).departs_at, us(6000));
+    profile.half_duplex = false;
+    LinkModel duplex(profile);
+    duplex.transmit(Direction::AtoB, 1000, us(0));
+    EXPECT_EQ(duplex.transmit(Direction::BtoA, 1000, us(0)).departs_at, us(1000));
+
+    // A token bucket lets an idle link send a burst at once, then shapes
+    profile.burst_bytes = 2000;
+    LinkModel bursty(profile);
+    EXPECT_EQ(bursty.transmit(Direction::AtoB, 1000, us(10000)).departs_at, us(10000));
+    EXPECT_EQ(bursty.transmit(Direction::AtoB, 1000, us(10000)).departs_at, us(10000));
+    EXPECT_EQ(bursty.transmit(Direction::AtoB, 1000, us(10000)).departs_at, us(11000));
+
+    // Jitter stays in range and never reorders a direction
+    profile = LinkProfile();
+    profile.jitter = us(3000);
+    profile.max_backlog = us(1000000);
+    LinkModel jittery(profile, 7);
+    us last(0);
+    for (int i = 0; i < 200; ++i) {
+        auto verdict = jittery.transmit(Direction::AtoB, 100, us(i * 100));
+        EXPECT_GE(verdict.arrives_at, last);
+        EXPECT_LE(verdict.arrives_at, verdict.departs_at + profile.delay + profile.jitter);
+        last = verdict.arrives_at;
+    }
+
+    // Gilbert-Elliott: bad half the time on average, in bursts of ~10 frames
+    profile = LinkProfile();
+    profile.bandwidth_bps = 1'000'000'000;
+    profile.loss = mesh::broker::GilbertElliott{0.1, 0.1, 0.0, 1.0};
+    EXPECT_DOUBLE_EQ(profile.loss.averageLoss(), 0.5);
+    LinkModel lossy(profile, 3);
+    size_t lost = 0;
+    size_t bursts = 0;
+    bool previous_lost = false;
+    const size_t frames = 20000;
+    for (size_t i = 0; i < frames; ++i) {
+        bool dropped = lossy.transmit(Direction::AtoB, 100, us(static_cast<int64_t>(i) * 10)).outcome == Outcome::Lost;
+        lost += dropped;
+        bursts += dropped && !previous_lost;
+        previous_lost = dropped;
+    }
+    EXPECT_NEAR(static_cast<double>(lost) / frames, 0.5, 0.05);
+    EXPECT_NEAR(static_cast<double>(lost) / static_cast<double>(bursts), 10.0, 2.0);
+    EXPECT_EQ(lossy.getStats(Direction::AtoB).lost, lost);
+
+    // Modelled links in an emulated mesh; a chain of four 8 Mbit/s hops
+    using mesh::broker::EmulatedMesh;
+    profile = LinkProfile();
+    profile.bandwidth_bps = 8'000'000;
+    profile.delay = us(500);
+    EmulatedMesh::Config config;
+    config.tx_time = us(0);
+    EmulatedMesh chain(config);
+    chain.addNodes(5);
+    for (EmulatedMesh::NodeIndex i = 0; i < 4; ++i) {
+        ASSERT_TRUE(chain.connect(i, i + 1, profile));
+    }
+    EXPECT_NE(chain.linkModel(1, 2), nullptr);
+    EXPECT_EQ(chain.linkModel(0, 2), nullptr);
+    std::vector<us> latencies;
+    size_t frame_bytes = 0;
+    chain.setDeliverHandler([&](EmulatedMesh::NodeIndex, const mesh::protocol::Message& message, us latency) {
+        frame_bytes = mesh::protocol::encodedSize(message);
+        latencies.push_back(latency);
+    });
+    chain.send(4, 0, std::string(800, 'x'));
+    chain.run();
+    ASSERT_EQ(latencies.size(), 1u);
+    // Each hop serializes the frame, then adds propagation delay
+    auto airtime = us(static_cast<int64_t>(frame_bytes));
+    EXPECT_EQ(latencies[0], 4 * (airtime + profile.delay));
+
+    // Over-MTU frames never make it onto a modelled link
+    chain.send(4, 0, std::string(2000, 'x'));
+    chain.run();
+    EXPECT_EQ(latencies.size(), 1u);
+    EXPECT_EQ(chain.getStats().link_dropped, 1u);
+
+    // Real-time link between two adapters
+    using mesh::broker::EmulatedLink;
+    profile = LinkProfile();
+    profile.delay = us(20000);
+    EmulatedLink radio(profile);
+    std::mutex mutex;
+    std::condition_variable arrived;
+    std::vector<std::string> received;
+    auto phone = radio.makeAdapter(EmulatedLink::End::A, "wifi", [](const mesh::protocol::Message&) {});
+    auto laptop = radio.makeAdapter(EmulatedLink::End::B, "wifi", [&](const mesh::protocol::Message& message) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(message.content);
+        arrived.notify_all();
+    });
+    mesh::protocol::Message message;
+    message.from_id = std::string(64, 'a');
+    message.to_id = std::string(64, 'b');
+    message.content = "over the air";
+    auto sent_at = std::chrono::steady_clock::now();
+    ASSERT_TRUE(phone->send(message));
+    message.content = std::string(2000, 'x');
+    EXPECT_FALSE(phone->send(message));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(arrived.wait_for(lock, std::chrono::seconds(5), [&] { return !received.empty(); }));
+    }
+    EXPECT_GE(std::chrono::steady_clock::now() - sent_at, profile.delay);
+    EXPECT_EQ(received[0], "over the air");
+    EXPECT_EQ(radio.getStats(EmulatedLink::End::A).delivered, 1u);
+    EXPECT_EQ(radio.getStats(EmulatedLink::End::A).oversize, 1u);
+    radio.close();
+    EXPECT_FALSE(laptop->send(message));
+}
+
+TEST_F(CppInteropTest, StoreAndForwardSpool) {
+    using mesh::broker::MessageSpool;
+
+    char dir_template[] = "/tmp/mesh-spool-XXXXXX";
+    ASSERT_NE(mkdtemp(dir_template), nullptr);
+    MessageSpool::Config config;
+    config.directory = dir_template;
+    config.segment_bytes = 4096;        // about twenty messages per segment
+    config.commit_interval = std::chrono::milliseconds(2);
+
+    mesh::protocol::NodeId alice;
+    mesh::protocol::NodeId bob;
+    ASSERT_TRUE(mesh::protocol::parseNodeId(std::string(64, 'a'), alice));
+    ASSERT_TRUE(mesh::protocol::parseNodeId(std::string(64, 'b'), bob));
+    auto makeMessage = [](char to, int n) {
+        mesh::protocol::Message message;
+        message.id = mesh::protocol::MessageId{1, static_cast<uint64_t>(n)};
+        message.from_id = std::string(64, 'f');
+        message.to_id = std::string(64, to);
+        message.content = "m" + std::to_string(n);
+        return message;
+    };
+    auto contents = [](const MessageSpool& spool, const mesh::protocol::NodeId& peer, size_t max) {
+        std::vector<std::string> out;
+        spool.stream(peer, max, [&](const uint8_t* frame, size_t len) {
+            mesh::protocol::Message message;
+            EXPECT_TRUE(mesh::protocol::decodeMessage(frame, len, message));
+            out.push_back(message.content);
+            return true;
+        });
+        return out;
+    };
+
+    {
+        MessageSpool spool(config);
+        ASSERT_TRUE(spool.open());
+        for (int i = 0; i < 50; ++i) {
+            ASSERT_TRUE(spool.append(makeMessage('a', i)));
+            if (i % 5 == 0) {
+                ASSERT_TRUE(spool.append(makeMessage('b', i)));
+            }
+        }
+        EXPECT_TRUE(spool.sync());
+        EXPECT_EQ(spool.pending(alice), 50u);
+        EXPECT_EQ(spool.pending(bob), 10u);
+        auto stats = spool.getStats();
+        EXPECT_EQ(stats.destinations, 2u);
+        EXPECT_GE(stats.segments, 3u);
+        EXPECT_GE(stats.commits, 1u);
+
+        // Messages that cannot be encoded are refused
+        auto bad = makeMessage('a', 99);
+        bad.to_id = "not-a-node";
+        EXPECT_FALSE(spool.append(bad));
+
+        // Streaming is in order, stops when the sender pushes back, and
+        // leaves everything spooled until acknowledged
+        EXPECT_EQ(contents(spool, alice, 3), (std::vector<std::string>{"m0", "m1", "m2"}));
+        size_t accepted = 0;
+        EXPECT_EQ(spool.stream(alice, 10, [&](const uint8_t*, size_t) { return ++accepted < 4; }), 3u);
+        EXPECT_EQ(spool.pending(alice), 50u);
+
+        EXPECT_EQ(spool.acknowledge(alice, 20), 20u);
+        EXPECT_EQ(spool.pending(alice), 30u);
+        EXPECT_EQ(contents(spool, alice, 1), std::vector<std::string>{"m20"});
+        EXPECT_EQ(spool.getStats().acknowledged, 20u);
+    }
+
+    // Reopening rebuilds the index from the log, acks included
+    std::string last_segment;
+    {
+        MessageSpool spool(config);
+        ASSERT_TRUE(spool.open());
+        EXPECT_EQ(spool.getStats().recovered, 40u);
+        EXPECT_EQ(spool.pending(alice), 30u);
+        EXPECT_EQ(contents(spool, alice, 2), (std::vector<std::string>{"m20", "m21"}));
+        EXPECT_EQ(contents(spool, bob, 100).size(), 10u);
+
+        // Fully acknowledged segments are deleted, oldest first
+        size_t segments = spool.getStats().segments;
+        EXPECT_EQ(spool.acknowledge(bob, 100), 10u);
+        EXPECT_EQ(spool.acknowledge(alice, 10), 10u);
+        EXPECT_LT(spool.getStats().segments, segments);
+        EXPECT_EQ(spool.getStats().destinations, 1u);
+        ASSERT_TRUE(spool.append(makeMessage('b', 100)));
+        EXPECT_TRUE(spool.sync());
+
+        char name[32];
+        for (unsigned n = 1; n < 1000; ++n) {
+            std::snprintf(name, sizeof(name), "/%08u.spool", n);
+            if (access((config.directory + name).c_str(), F_OK) == 0) {
+                last_segment = config.directory + name;
+            }
+        }
+    }
+
+    // A torn record at the tail is ignored and cleared, not fatal
+    {
+        FILE* file = std::fopen(last_segment.c_str(), "r+b");
+        ASSERT_NE(file, nullptr);
+        std::vector<uint8_t> bytes(config.segment_bytes);
+        ASSERT_EQ(std::fread(bytes.data(), 1, bytes.size(), file), bytes.size());
+        size_t end = 0;
+        for (;;) {
+            uint32_t len = bytes[end] | bytes[end + 1] << 8 | bytes[end + 2] << 16 | uint32_t(bytes[end + 3]) << 24;
+            if (len == 0) {
+                break;
+            }
+            end += 8 + len;
+        }
+        const uint8_t torn[] = {200, 0, 0, 0, 0xDE, 0xAD, 0xBE, 0xEF, 1, 2, 3};
+        std::fseek(file, static_cast<long>(end), SEEK_SET);
+        std::fwrite(torn, 1, sizeof(torn), file);
+        std::fclose(file);
+    }
+    {
+        MessageSpool spool(config);
+        ASSERT_TRUE(spool.open());
+        EXPECT_EQ(spool.getStats().recovered, 21u);
+        EXPECT_EQ(contents(spool, bob, 5), std::vector<std::string>{"m100"});
+        ASSERT_TRUE(spool.append(makeMessage('b', 101)));
+        EXPECT_TRUE(spool.sync());
+    }
+    {
+        MessageSpool spool(config);
+        ASSERT_TRUE(spool.open());
+        EXPECT_EQ(contents(spool, bob, 5), (std::vector<std::string>{"m100", "m101"}));
+        EXPECT_EQ(spool.acknowledge(alice, 100), 20u);
+        EXPECT_EQ(spool.acknowledge(bob, 100), 2u);
+        EXPECT_EQ(spool.getStats().pending, 0u);
+        EXPECT_EQ(spool.getStats().segments, 1u);
+    }
+
+    MessageSpool spool(config);
+    ASSERT_TRUE(spool.open());
+    EXPECT_EQ(spool.getStats().recovered, 0u);
+    spool.close();
+    std::string cleanup = "rm -rf " + config.directory;
+    EXPECT_EQ(std::system(cleanup.c_str()), 0);
+}
+
+TEST_F(CppInteropTest, StoreAndForwardSpoolCommitFailure) {
+    using mesh::broker::MessageSpool;
+
+    char dir_template[] = "/tmp/mesh-spool-XXXXXX";
+    ASSERT_NE(mkdtemp(dir_template), nullptr);
+    std::atomic<bool> disk_failing{false};
+    MessageSpool::Config config;
+    config.directory = dir_template;
+    config.segment_bytes = 4096;
+    config.commit_interval = std::chrono::milliseconds(2);
+    config.flush = [&](void* address, size_t len) {
+        return !disk_failing && msync(address, len, MS_SYNC) == 0;
+    };
+
+    mesh::protocol::NodeId alice;
+    ASSERT_TRUE(mesh::protocol::parseNodeId(std::string(64, 'a'), alice));
+    auto makeMessage = [](int n) {
+        mesh::protocol::Message message;
+        message.id = mesh::protocol::MessageId{1, static_cast<uint64_t>(n)};
+        message.from_id = std::string(64, 'f');
+        message.to_id = std::string(64, 'a');
+        message.content = "m" + std::to_string(n);
+        return message;
+    };
+
+    {
+        MessageSpool spool(config);
+        ASSERT_TRUE(spool.open());
+        ASSERT_TRUE(spool.append(makeMessage(0)));
+        EXPECT_TRUE(spool.sync());
+
+        // A failed commit is reported and appends are refused, not
+        // silently accepted into a log that never reaches the disk
+        disk_failing = true;
+        ASSERT_TRUE(spool.append(makeMessage(1)));
+        EXPECT_FALSE(spool.sync());
+        EXPECT_FALSE(spool.append(makeMessage(2)));
+        auto stats = spool.getStats();
+        EXPECT_TRUE(stats.failing);
+        EXPECT_GE(stats.commit_failures, 1u);
+        EXPECT_EQ(spool.pending(alice), 2u);
+
+        // The committer keeps retrying and recovers once the disk does
+        disk_failing = false;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (spool.getStats().failing && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_FALSE(spool.getStats().failing);
+        EXPECT_TRUE(spool.sync());
+        ASSERT_TRUE(spool.append(makeMessage(3)));
+        EXPECT_TRUE(spool.sync());
+        EXPECT_EQ(spool.pending(alice), 3u);
+    }
+
+    {
+        MessageSpool spool(config);
+        ASSERT_TRUE(spool.open());
+        EXPECT_EQ(spool.getStats().recovered, 3u);
+        EXPECT_FALSE(spool.getStats().failing);
+    }
+    std::string cleanup = "rm -rf " + config.directory;
+    EXPECT_EQ(std::system(cleanup.c_str()), 0);
+}
+
+TEST_F(CppInteropTest, FragmentationReassembly) {
+    using mesh::protocol::Reassembler;
+
+    mesh::protocol::Message message;
+    message.id = mesh::protocol::MessageId::fromHex("00112233-4455-6677-8899-aabbccddeeff");
+    message.from_id = std::string(64, 'a');
+    message.to_id = std::string(64, 'b');
+    message.content = std::string(2000, 'x');
+    std::vector<uint8_t> encoded(mesh::protocol::encodedSize(message));
+    size_t written = 0;
+    ASSERT_TRUE(mesh::protocol::encodeMessage(message, encoded.data(), encoded.size(), written));
+
+    mesh::protocol::Fragmenter fragmenter(mesh::protocol::kBleDefaultMtu);
+    size_t count = fragmenter.fragmentCount(written);
+    ASSERT_GT(count, 1u);
+    uint16_t stream = fragmenter.nextStreamId();
+    std::vector<std::vector<uint8_t>> fragments(count);
+    for (size_t i = 0; i < count; ++i) {
+        fragments[i].resize(fragmenter.getMtu());
+        size_t size = fragmenter.writeFragment(encoded.data(), written, stream, i, fragments[i].data());
+        ASSERT_GT(size, 0u);
+        ASSERT_LE(size, fragmenter.getMtu());
+        fragments[i].resize(size);
+        EXPECT_TRUE(mesh::protocol::isFragment(fragments[i].data(), size));
+    }
+    EXPECT_FALSE(mesh::protocol::isFragment(encoded.data(), written));
+
+    // Out of order with a duplicate; the same stream id from another source is separate
+    Reassembler reassembler;
+    std::vector<uint8_t> frame;
+    std::reverse(fragments.begin(), fragments.end());
+    for (size_t i = 0; i + 1 < count; ++i) {
+        EXPECT_EQ(reassembler.receive(1, fragments[i].data(), fragments[i].size(), frame),
+                  Reassembler::Result::Incomplete);
+        EXPECT_EQ(reassembler.receive(2, fragments[i].data(), fragments[i].size(), frame),
+                  Reassembler::Result::Incomplete);
+    }
+    EXPECT_EQ(reassembler.receive(1, fragments[0].data(), fragments[0].size(), frame),
+              Reassembler::Result::Duplicate);
+    EXPECT_EQ(reassembler.getStats().partial_streams, 2u);
+    EXPECT_EQ(reassembler.getStats().reserved_bytes, 2 * written);
+
+    ASSERT_EQ(reassembler.receive(1, fragments.back().data(), fragments.back().size(), frame),
+              Reassembler::Result::Complete);
+    EXPECT_EQ(frame.size(), written);
+    mesh::protocol::Message decoded;
+    ASSERT_TRUE(mesh::protocol::decodeMessage(frame.data(), frame.size(), decoded));
+    EXPECT_EQ(decoded.content, message.content);
+    reassembler.recycle(std::move(frame));
+
+    // Truncated fragments never touch stream state
+    EXPECT_EQ(reassembler.receive(2, fragments.back().data(), fragments.back().size() - 1, frame),
+              Reassembler::Result::Invalid);
+    EXPECT_EQ(reassembler.getStats().partial_streams, 1u);
+
+    // Stalled streams are swept after the timeout
+    EXPECT_EQ(reassembler.sweep(mesh::protocol::CoarseClock::now() + std::chrono::seconds(10)), 1u);
+    EXPECT_EQ(reassembler.getStats().reserved_bytes, 0u);
+
+    // A new stream that does not fit the budget evicts the oldest partial one
+    Reassembler::Config config;
+    config.memory_budget = written + written / 2;
+    Reassembler bounded(config);
+    EXPECT_EQ(bounded.receive(1, fragments[0].data(), fragments[0].size(), frame),
+              Reassembler::Result::Incomplete);
+    EXPECT_EQ(bounded.receive(2, fragments[0].data(), fragments[0].size(), frame),
+              Reassembler::Result::Incomplete);
+    EXPECT_EQ(bounded.getStats().evicted, 1u);
+    EXPECT_EQ(bounded.getStats().reserved_bytes, written);
+
+    config.memory_budget = written - 1;
+    Reassembler tiny(config);
+    EXPECT_EQ(tiny.receive(1, fragments[0].data(), fragments[0].size(), frame),
+              Reassembler::Result::OverBudget);
+}
+
+TEST_F(CppInteropTest, SmallMessageCoalescing) {
+    using mesh::protocol::Coalescer;
+
+    struct Sent {
+        uint64_t next_hop;
+        std::vector<uint8_t> frame;
+    };
+    std::vector<Sent> sent;
+    Coalescer::Config config;
+    config.max_batch_bytes = 64;
+    config.max_message_bytes = 40;
+    config.max_delay = std::chrono::microseconds(200);
+    Coalescer coalescer(config, [&](uint64_t next_hop, const uint8_t* frame, size_t len) {
+        sent.push_back({next_hop, std::vector<uint8_t>(frame, frame + len)});
+    });
+
+    auto t0 = Coalescer::Clock::now();
+    std::vector<uint8_t> ack(10, 0xA1);
+    std::vector<uint8_t> typing(12, 0xB2);
+    std::vector<uint8_t> bulk(100, 0xC3);
+
+    // Frames for the same hop wait for the deadline, other hops batch separately
+    coalescer.submit(1, ack.data(), ack.size(), t0);
+    coalescer.submit(1, typing.data(), typing.size(), t0);
+    coalescer.submit(2, ack.data(), ack.size(), t0);
+    EXPECT_TRUE(sent.empty());
+    EXPECT_EQ(coalescer.nextDeadline(), t0 + config.max_delay);
+
+    coalescer.poll(t0 + std::chrono::microseconds(199));
+    EXPECT_TRUE(sent.empty());
+    coalescer.poll(t0 + config.max_delay);
+    ASSERT_EQ(sent.size(), 2u);
+    EXPECT_EQ(coalescer.nextDeadline(), Coalescer::Clock::time_point::max());
+
+    // Hop 1 got one batch of two, hop 2 its lone frame bare
+    for (const auto& out : sent) {
+        if (out.next_hop == 2) {
+            EXPECT_EQ(out.frame, ack);
+            continue;
+        }
+        mesh::protocol::BatchReader reader;
+        ASSERT_TRUE(reader.reset(out.frame.data(), out.frame.size()));
+        EXPECT_EQ(reader.count(), 2u);
+        mesh::protocol::ByteView frame;
+        ASSERT_TRUE(reader.next(frame));
+        EXPECT_EQ(std::vector<uint8_t>(frame.begin(), frame.end()), ack);
+        ASSERT_TRUE(reader.next(frame));
+        EXPECT_EQ(std::vector<uint8_t>(frame.begin(), frame.end()), typing);
+        EXPECT_FALSE(reader.next(frame));
+    }
+
+    // The byte threshold flushes early; large frames bypass after queued ones
+    sent.clear();
+    for (int i = 0; i < 6; ++i) {
+        coalescer.submit(1, ack.data(), ack.size(), t0);
+    }
+    ASSERT_EQ(sent.size(), 1u);
+    EXPECT_EQ(sent[0].frame[1], 5u);
+    coalescer.submit(1, typing.data(), typing.size(), t0);
+    coalescer.submit(1, bulk.data(), bulk.size(), t0);
+    ASSERT_EQ(sent.size(), 3u);
+    EXPECT_EQ(sent[1].frame[1], 2u);
+    EXPECT_EQ(sent[2].frame, bulk);
+
+    auto stats = coalescer.getStats();
+    EXPECT_EQ(stats.messages, 11u);
+    EXPECT_EQ(stats.frames, 5u);
+    EXPECT_EQ(stats.batches, 3u);
+    EXPECT_EQ(stats.bypassed, 1u);
+
+    // Damaged batches stop cleanly
+    std::vector<uint8_t> damaged = sent[0].frame;
+    damaged.resize(damaged.size() - 3);
+    mesh::protocol::BatchReader reader;
+    ASSERT_TRUE(reader.reset(damaged.data(), damaged.size()));
+    mesh::protocol::ByteView frame;
+    size_t frames = 0;
+    while (reader.next(frame)) {
+        ++frames;
+    }
+    EXPECT_EQ(frames, 4u);
+}
+
+TEST_F(CppInteropTest, TypeCodeDispatch) {
+    namespace types = mesh::protocol::types;
+    using mesh::protocol::MessageView;
+
+    static_assert(mesh::protocol::typeCode("chat") == types::Chat::kCode);
+    static_assert(mesh::protocol::typeName(types::Ack::kCode) == "ack");
+    static_assert(mesh::protocol::typeCode("poll") == mesh::protocol::kNamedTypeCode);
+
+    struct Counters {
+        int chat = 0;
+        int ack = 0;
+        std::string last_content;
+    };
+    struct AckHandler {
+        void operator()(const MessageView&, Counters& counters) const { ++counters.ack; }
+    };
+    auto dispatcher = mesh::protocol::makeDispatcher<Counters>(
+        mesh::protocol::on<types::Chat>([](const MessageView& view, Counters& counters) {
+            ++counters.chat;
+            counters.last_content.assign(view.content());
+        }),
+        mesh::protocol::on<types::Ack>(AckHandler{}));
+    static_assert(decltype(dispatcher)::handles<types::Chat>());
+    static_assert(!decltype(dispatcher)::handles<types::Heartbeat>());
+
+    auto encode = [](const std::string& type, const std::string& content) {
+        mesh::protocol::Message message;
+        message.from_id = std::string(64, 'a');
+        message.to_id = std::string(64, 'b');
+        message.type = type;
+        message.content = content;
+        std::vector<uint8_t> buffer(mesh::protocol::encodedSize(message));
+        size_t written = 0;
+        EXPECT_TRUE(mesh::protocol::encodeMessage(message, buffer.data(), buffer.size(), written));
+        return buffer;
+    };
+
+    // Well-known types travel as a code, not a name
+    auto chat = encode("chat", "hi");
+    auto poll = encode("poll", "hi");
+    EXPECT_EQ(chat[2], types::Chat::kCode);
+    EXPECT_EQ(poll[2], mesh::protocol::kNamedTypeCode);
+    EXPECT_EQ(chat.size() + 5, poll.size());
+
+    Counters counters;
+    MessageView view;
+    ASSERT_TRUE(view.parse(chat.data(), chat.size()));
+    EXPECT_EQ(view.type(), "chat");
+    EXPECT_TRUE(dispatcher.dispatch(view, counters));
+
+    auto ack = encode("ack", "");
+    ASSERT_TRUE(view.parse(ack.data(), ack.size()));
+    EXPECT_TRUE(dispatcher.dispatch(view, counters));
+
+    // Named and unhandled types fall through to the caller
+    ASSERT_TRUE(view.parse(poll.data(), poll.size()));
+    EXPECT_EQ(view.type(), "poll");
+    EXPECT_FALSE(dispatcher.dispatch(view, counters));
+    auto heartbeat = encode("heartbeat", "");
+    ASSERT_TRUE(view.parse(heartbeat.data(), heartbeat.size()));
+    EXPECT_FALSE(dispatcher.dispatch(view, counters));
+
+    EXPECT_EQ(counters.chat, 1);
+    EXPECT_EQ(counters.ack, 1);
+    EXPECT_EQ(counters.last_content, "hi");
+
+    mesh::protocol::Message decoded;
+    ASSERT_TRUE(mesh::protocol::decodeMessage(chat.data(), chat.size(), decoded));
+    EXPECT_EQ(decoded.type, "chat");
+
+    // Codes from newer nodes still parse, so relays can forward them, but
+    // have no name and no handler here
+    chat[2] = mesh::protocol::kMaxTypeCode + 1;
+    ASSERT_TRUE(view.parse(chat.data(), chat.size()));
+    EXPECT_EQ(view.typeCode(), mesh::protocol::kMaxTypeCode + 1);
+    EXPECT_TRUE(view.type().empty());
+    EXPECT_EQ(view.content(), "hi");
+    EXPECT_FALSE(dispatcher.dispatch(view, counters));
+    EXPECT_EQ(counters.chat, 1);
+}
+
+TEST_F(CppInteropTest, ForwardErrorCorrection) {
+    using mesh::protocol::FecDecoder;
+    namespace gf256 = mesh::protocol::gf256;
+
+    for (unsigned a = 1; a < 256; ++a) {
+        ASSERT_EQ(gf256::mul(static_cast<uint8_t>(a), gf256::inv(static_cast<uint8_t>(a))), 1);
+    }
+    std::vector<uint8_t> region(37, 0);
+    std::vector<uint8_t> source(37);
+    for (size_t i = 0; i < source.size(); ++i) {
+        source[i] = static_cast<uint8_t>(i * 7 + 1);
+    }
+    gf256::mulAddRegion(region.data(), source.data(), 0x53, region.size());
+    for (size_t i = 0; i < region.size(); ++i) {
+        EXPECT_EQ(region[i], gf256::mul(0x53, source[i]));
+    }
+
+    // The SSSE3 kernel, where the CPU has it, matches the scalar one for
+    // every coefficient, including the unaligned tail
+    std::vector<uint8_t> bytes(1000);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<uint8_t>(i * 131 + (i >> 3));
+    }
+    for (unsigned c = 0; c < 256; ++c) {
+        std::vector<uint8_t> scalar(bytes.rbegin(), bytes.rend());
+        std::vector<uint8_t> simd = scalar;
+        gf256::mulAddRegionScalar(scalar.data() + 1, bytes.data() + 3, static_cast<uint8_t>(c), 995);
+        if (!gf256::mulAddRegionSsse3(simd.data() + 1, bytes.data() + 3, static_cast<uint8_t>(c), 995)) {
+            break;
+        }
+        ASSERT_EQ(simd, scalar) << "coefficient " << c;
+    }
+
+    // Redundancy follows the link's loss estimate
+    mesh::protocol::FecEncoder encoder(mesh::protocol::kBleDefaultMtu);
+    EXPECT_EQ(encoder.parityShardCount(10, 0.0), 0u);
+    EXPECT_GT(encoder.parityShardCount(10, 0.05), 0u);
+    EXPECT_GT(encoder.parityShardCount(10, 0.2), encoder.parityShardCount(10, 0.05));
+    EXPECT_EQ(encoder.parityShardCount(10, 1.0), encoder.getConfig().max_parity);
+
+    mesh::protocol::LossEstimator estimator(0.5);
+    estimator.record(10, 2);
+    EXPECT_DOUBLE_EQ(estimator.lossRate(), 0.1);
+
+    std::vector<uint8_t> original(3000);
+    for (size_t i = 0; i < original.size(); ++i) {
+        original[i] = static_cast<uint8_t>(i ^ (i >> 8));
+    }
+    std::vector<std::vector<uint8_t>> shards;
+    size_t n = encoder.encode(original.data(), original.size(), encoder.nextStreamId(), 0.1, shards);
+    size_t k = encoder.dataShardCount(original.size());
+    ASSERT_GT(n, k);
+    for (const auto& shard : shards) {
+        EXPECT_LE(shard.size(), encoder.getMtu());
+        EXPECT_TRUE(mesh::protocol::isFecShard(shard.data(), shard.size()));
+    }
+
+    // Lose the first n - k data shards; the rest arrive out of order
+    FecDecoder decoder;
+    std::vector<uint8_t> frame;
+    std::vector<size_t> order;
+    for (size_t i = n - k; i < n; ++i) {
+        order.push_back(i);
+    }
+    std::reverse(order.begin(), order.end());
+    for (size_t i = 0; i + 1 < order.size(); ++i) {
+        EXPECT_EQ(decoder.receive(1, shards[order[i]].data(), shards[order[i]].size(), frame),
+                  FecDecoder::Result::Incomplete);
+    }
+    EXPECT_EQ(decoder.getStats().partial_streams, 1u);
+    ASSERT_EQ(decoder.receive(1, shards[order.back()].data(), shards[order.back()].size(), frame),
+              FecDecoder::Result::Complete);
+    EXPECT_EQ(frame, original);
+    EXPECT_EQ(decoder.getStats().recovered, 1u);
+    EXPECT_EQ(decoder.getStats().reserved_bytes, 0u);
+
+    // Surplus shards of a finished stream are dropped, not reopened
+    EXPECT_EQ(decoder.receive(1, shards[0].data(), shards[0].size(), frame), FecDecoder::Result::Duplicate);
+    EXPECT_EQ(decoder.getStats().partial_streams, 0u);
+
+    // All data shards present: no decoding needed
+    for (size_t i = 0; i < k; ++i) {
+        decoder.receive(2, shards[i].data(), shards[i].size(), frame);
+    }
+    EXPECT_EQ(frame, original);
+    EXPECT_EQ(decoder.getStats().completed, 2u);
+    EXPECT_EQ(decoder.getStats().recovered, 1u);
+
+    // Damaged shards are rejected, and stalled streams are swept
+    EXPECT_EQ(decoder.receive(3, shards[1].data(), shards[1].size() - 1, frame), FecDecoder::Result::Invalid);
+    EXPECT_EQ(decoder.receive(3, shards[1].data(), shards[1].size(), frame), FecDecoder::Result::Incomplete);
+    EXPECT_EQ(decoder.sweep(mesh::protocol::CoarseClock::now() + std::chrono::seconds(10)), 1u);
+    EXPECT_EQ(decoder.getStats().reserved_bytes, 0u);
+    EXPECT_EQ(decoder.getStats().finished_streams, 0u);
+
+    // A long-lived link remembers only its latest finished streams, even
+    // if nothing sweeps
+    std::vector<std::vector<uint8_t>> small;
+    const std::vector<uint8_t> message(100, 0x5a);
+    for (unsigned stream = 0; stream < 1000; ++stream) {
+        size_t count = encoder.encode(message.data(), message.size(), static_cast<uint16_t>(stream), 0.0, small);
+        for (size_t i = 0; i < count; ++i) {
+            decoder.receive(4, small[i].data(), small[i].size(), frame);
+        }
+    }
+    EXPECT_EQ(decoder.getStats().completed, 1002u);
+    EXPECT_LE(decoder.getStats().finished_streams, 32u);
+
+    // A wrapped stream id with a different shape replaces the finished one
+    size_t count = encoder.encode(original.data(), original.size(), 999, 0.0, small);
+    for (size_t i = 0; i < count; ++i) {
+        decoder.receive(4, small[i].data(), small[i].size(), frame);
+    }
+    EXPECT_EQ(frame, original);
+    EXPECT_EQ(decoder.getStats().completed, 1003u);
+
+    // Ageing out the first use of a reopened id keeps the second's tombstone
+    auto deliver = [&](const std::vector<std::vector<uint8_t>>& all, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            decoder.receive(5, all[i].data(), all[i].size(), frame);
+        }
+    };
+    deliver(small, encoder.encode(message.data(), message.size(), 7, 0.0, small));
+    std::vector<std::vector<uint8_t>> reopened;
+    deliver(reopened, encoder.encode(original.data(), original.size(), 7, 0.0, reopened));
+    for (unsigned stream = 100; stream < 131; ++stream) {
+        deliver(small, encoder.encode(message.data(), message.size(), static_cast<uint16_t>(stream), 0.0, small));
+    }
+    EXPECT_EQ(decoder.receive(5, reopened[0].data(), reopened[0].size(), frame), FecDecoder::Result::Duplicate);
+}
@@ -1,10 +1,21 @@
 #include <gtest/gtest.h>
 #include <mesh/core.h>
 #include <mesh/crypto.h>
+#include <mesh/crypto/batch_signer.hpp>
+#include <mesh/crypto/group_session.hpp>
+#include <mesh/crypto/layered_frame.hpp>
+#include <mesh/crypto/noise.hpp>
+#include <mesh/crypto/session_table.hpp>
 #include <openssl/sha.h>
+#include <algorithm>
 #include <cstring>
+#include <string>
+#include <thread>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <map>
+#include <set>
 
 class SecurityTest : public ::testing::Test {
 protected:
@@ -286,3 +297,312 @@ TEST_F(SecurityTest, TimingAttackResistance) {
     free(signature);
     mesh_keypair_destroy(keypair);
 }
+
+TEST_F(SecurityTest, NoiseHandshakeEarlyData) {
+    using mesh::crypto::NoiseHandshake;
+
+    mesh::crypto::KeyPair alice_static;
+    mesh::crypto::KeyPair bob_static;
+
+    NoiseHandshake alice(NoiseHandshake::Role::Initiator, alice_static);
+    NoiseHandshake bob(NoiseHandshake::Role::Responder, bob_static);
+
+    const std::string hello = "First message rides in the handshake";
+    const std::string reply = "Reply rides in the response";
+
+    // First flight carries the early data
+    std::vector<uint8_t> initiation;
+    ASSERT_TRUE(alice.writeInitiation(bob_static.getPublicKey(),
+                                      std::vector<uint8_t>(hello.begin(), hello.end()),
+                                      initiation));
+    EXPECT_EQ(initiation.size(), NoiseHandshake::kInitiationOverhead + hello.size());
+
+    std::vector<uint8_t> early_data;
+    ASSERT_TRUE(bob.readInitiation(initiation, early_data));
+    EXPECT_EQ(std::string(early_data.begin(), early_data.end()), hello);
+    EXPECT_EQ(bob.getRemoteStaticKey(), alice_static.getPublicKey());
+
+    // Response completes both sides
+    std::vector<uint8_t> response;
+    ASSERT_TRUE(bob.writeResponse(std::vector<uint8_t>(reply.begin(), reply.end()), response));
+
+    std::vector<uint8_t> payload;
+    ASSERT_TRUE(alice.readResponse(response, payload));
+    EXPECT_EQ(std::string(payload.begin(), payload.end()), reply);
+
+    ASSERT_TRUE(alice.isComplete());
+    ASSERT_TRUE(bob.isComplete());
+    EXPECT_EQ(alice.getSendKey(), bob.getReceiveKey());
+    EXPECT_EQ(alice.getReceiveKey(), bob.getSendKey());
+    EXPECT_NE(alice.getSendKey(), alice.getReceiveKey());
+    EXPECT_EQ(alice.getHandshakeHash(), bob.getHandshakeHash());
+}
+
+TEST_F(SecurityTest, NoiseHandshakeRejectsTampering) {
+    using mesh::crypto::NoiseHandshake;
+
+    mesh::crypto::KeyPair alice_static;
+    mesh::crypto::KeyPair bob_static;
+    mesh::crypto::KeyPair mallory_static;
+
+    // Initiation addressed to a different responder key
+    NoiseHandshake alice(NoiseHandshake::Role::Initiator, alice_static);
+    std::vector<uint8_t> initiation;
+    ASSERT_TRUE(alice.writeInitiation(mallory_static.getPublicKey(), {}, initiation));
+
+    NoiseHandshake bob(NoiseHandshake::Role::Responder, bob_static);
+    std::vector<uint8_t> early_data;
+    EXPECT_FALSE(bob.readInitiation(initiation, early_data));
+    EXPECT_FALSE(bob.isComplete());
+
+    // Flipped ciphertext bit
+    NoiseHandshake carol(NoiseHandshake::Role::Initiator, alice_static);
+    ASSERT_TRUE(carol.writeInitiation(bob_static.getPublicKey(), {'h', 'i'}, initiation));
+    initiation.back() ^= 0x01;
+
+    NoiseHandshake dave(NoiseHandshake::Role::Responder, bob_static);
+    EXPECT_FALSE(dave.readInitiation(initiation, early_data));
+}
+
+TEST_F(SecurityTest, SessionTableLookupAndEviction) {
+    mesh::crypto::SessionTable table(4);
+
+    mesh::crypto::SessionTable::Entry entry;
+    entry.send_key.fill(0x11);
+    entry.receive_key.fill(0x22);
+
+    mesh::crypto::SessionId id = table.insert(entry);
+    ASSERT_NE(id, mesh::crypto::kInvalidSessionId);
+    EXPECT_EQ(table.size(), 1u);
+
+    mesh::crypto::SessionTable::Entry found;
+    ASSERT_TRUE(table.lookup(id, found));
+    EXPECT_EQ(found.send_key, entry.send_key);
+    EXPECT_EQ(found.receive_key, entry.receive_key);
+
+    uint64_t counter = 0;
+    EXPECT_TRUE(table.nextSendCounter(id, counter));
+    EXPECT_EQ(counter, 0u);
+    EXPECT_TRUE(table.nextSendCounter(id, counter));
+    EXPECT_EQ(counter, 1u);
+
+    // Evicted ids must not resolve, even after the slot is reused
+    EXPECT_TRUE(table.evict(id));
+    EXPECT_FALSE(table.lookup(id, found));
+    EXPECT_FALSE(table.evict(id));
+
+    mesh::crypto::SessionId reused = table.insert(entry);
+    ASSERT_NE(reused, mesh::crypto::kInvalidSessionId);
+    EXPECT_NE(reused, id);
+    EXPECT_FALSE(table.lookup(id, found));
+    EXPECT_TRUE(table.lookup(reused, found));
+
+    // Capacity is a hard limit
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_NE(table.insert(entry), mesh::crypto::kInvalidSessionId);
+    }
+    EXPECT_EQ(table.insert(entry), mesh::crypto::kInvalidSessionId);
+}
+
+TEST_F(SecurityTest, SessionTableCountersSurviveSlotReuse) {
+    // One slot, reused as fast as possible while two senders reserve
+    // counters; no id may ever be handed the same counter twice
+    mesh::crypto::SessionTable table(1);
+    mesh::crypto::SessionTable::Entry entry;
+    std::atomic<mesh::crypto::SessionId> current{table.insert(entry)};
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> attempts{0};
+
+    std::thread churn([&] {
+        while (attempts.load() < 40000) {
+            table.evict(current.load());
+            current.store(table.insert(entry));
+            std::this_thread::yield();
+        }
+        stop.store(true);
+    });
+
+    std::vector<std::vector<std::pair<mesh::crypto::SessionId, uint64_t>>> reserved(2);
+    std::vector<std::thread> senders;
+    for (auto& out : reserved) {
+        senders.emplace_back([&] {
+            while (!stop.load()) {
+                mesh::crypto::SessionId id = current.load();
+                uint64_t counter = 0;
+                attempts.fetch_add(1);
+                if (table.nextSendCounter(id, counter)) {
+                    out.emplace_back(id, counter);
+                }
+            }
+        });
+    }
+    churn.join();
+    for (auto& sender : senders) {
+        sender.join();
+    }
+
+    std::map<mesh::crypto::SessionId, std::set<uint64_t>> seen;
+    size_t total = 0;
+    for (const auto& out : reserved) {
+        for (const auto& [id, counter] : out) {
+            EXPECT_TRUE(seen[id].insert(counter).second) << "id " << id << " counter " << counter;
+            ++total;
+        }
+    }
+    EXPECT_GT(total, 0u);
+}
+
+TEST_F(SecurityTest, SenderKeyGroupBroadcast) {
+    mesh::crypto::SenderKeySession sender;
+    mesh::crypto::SenderKeyReceiver alice;
+    mesh::crypto::SenderKeyReceiver bob;
+
+    std::vector<uint8_t> distribution = sender.createDistribution();
+    ASSERT_TRUE(alice.importDistribution(distribution));
+    ASSERT_TRUE(bob.importDistribution(distribution));
+
+    const std::string text = "Broadcast encrypted once";
+    std::vector<uint8_t> first, second, third;
+    ASSERT_TRUE(sender.encrypt(std::vector<uint8_t>(text.begin(), text.end()), first));
+    ASSERT_TRUE(sender.encrypt({'2'}, second));
+    ASSERT_TRUE(sender.encrypt({'3'}, third));
+
+    // Every member decrypts the same frame
+    std::vector<uint8_t> plaintext;
+    ASSERT_TRUE(alice.decrypt(first, plaintext));
+    EXPECT_EQ(std::string(plaintext.begin(), plaintext.end()), text);
+    ASSERT_TRUE(bob.decrypt(first, plaintext));
+    EXPECT_EQ(std::string(plaintext.begin(), plaintext.end()), text);
+
+    // Out-of-order delivery, then replay rejection
+    ASSERT_TRUE(alice.decrypt(third, plaintext));
+    EXPECT_EQ(plaintext, std::vector<uint8_t>({'3'}));
+    ASSERT_TRUE(alice.decrypt(second, plaintext));
+    EXPECT_EQ(plaintext, std::vector<uint8_t>({'2'}));
+    EXPECT_FALSE(alice.decrypt(second, plaintext));
+
+    // Tampered frame does not advance the chain
+    std::vector<uint8_t> fourth;
+    ASSERT_TRUE(sender.encrypt({'4'}, fourth));
+    std::vector<uint8_t> tampered = fourth;
+    tampered.back() ^= 0x01;
+    EXPECT_FALSE(bob.decrypt(tampered, plaintext));
+    EXPECT_TRUE(bob.decrypt(fourth, plaintext));
+
+    // Rotation locks out members that have not received the new key
+    ASSERT_TRUE(sender.rotate());
+    EXPECT_TRUE(sender.hasKey());
+    std::vector<uint8_t> rotated;
+    ASSERT_TRUE(sender.encrypt({'5'}, rotated));
+    EXPECT_FALSE(alice.decrypt(rotated, plaintext));
+    ASSERT_TRUE(alice.importDistribution(sender.createDistribution()));
+    std::vector<uint8_t> after;
+    ASSERT_TRUE(sender.encrypt({'6'}, after));
+    EXPECT_TRUE(alice.decrypt(after, plaintext));
+}
+
+TEST_F(SecurityTest, LayeredFramePassThroughRelay) {
+    mesh::crypto::SessionTable::Key e2e_key, link_ab, link_bc, link_cd;
+    e2e_key.fill(0xE2);
+    link_ab.fill(0xAB);
+    link_bc.fill(0xBC);
+    link_cd.fill(0xCD);
+
+    mesh::crypto::RoutingHeader header;
+    header.ttl = 8;
+    header.session_id = 1;
+    header.hop_counter = 1;
+    header.source.fill('a');
+    header.destination.fill('d');
+
+    const std::string text = "End-to-end payload";
+    std::vector<uint8_t> frame;
+    ASSERT_TRUE(mesh::crypto::sealLayeredFrame(header, e2e_key, 42,
+                                               std::vector<uint8_t>(text.begin(), text.end()),
+                                               link_ab, frame));
+    const std::vector<uint8_t> body(frame.begin() + mesh::crypto::kRoutingHeaderSize, frame.end());
+
+    // Relays B and C re-tag the header only
+    ASSERT_TRUE(mesh::crypto::relayLayeredFrame(frame.data(), frame.size(), link_ab, 2, 7, link_bc));
+    ASSERT_TRUE(mesh::crypto::relayLayeredFrame(frame.data(), frame.size(), link_bc, 3, 9, link_cd));
+    EXPECT_TRUE(std::equal(body.begin(), body.end(),
+                           frame.begin() + mesh::crypto::kRoutingHeaderSize));
+
+    // Wrong inbound link key is rejected without touching the frame
+    std::vector<uint8_t> before = frame;
+    EXPECT_FALSE(mesh::crypto::relayLayeredFrame(frame.data(), frame.size(), link_ab, 4, 1, link_cd));
+    EXPECT_EQ(frame, before);
+
+    mesh::crypto::RoutingHeader received;
+    std::vector<uint8_t> plaintext;
+    ASSERT_TRUE(mesh::crypto::openLayeredFrame(frame.data(), frame.size(), link_cd, e2e_key,
+                                               received, plaintext));
+    EXPECT_EQ(std::string(plaintext.begin(), plaintext.end()), text);
+    EXPECT_EQ(received.ttl, 6);
+    EXPECT_EQ(received.hops, 2);
+    EXPECT_EQ(received.session_id, 3u);
+    EXPECT_EQ(received.type, MESH_MSG_ENCRYPTED);
+
+    // A relay cannot see body tampering, but the destination rejects it
+    frame.back() ^= 0x01;
+    EXPECT_TRUE(mesh::crypto::verifyRoutingHeader(frame.data(), frame.size(), link_cd, received));
+    EXPECT_FALSE(mesh::crypto::openLayeredFrame(frame.data(), frame.size(), link_cd, e2e_key,
+                                                received, plaintext));
+
+    // Header tampering is caught at the next hop
+    frame.back() ^= 0x01;
+    frame[2] = 200;
+    EXPECT_FALSE(mesh::crypto::verifyRoutingHeader(frame.data(), frame.size(), link_cd, received));
+}
+
+TEST_F(SecurityTest, MerkleBatchSigning) {
+    mesh_key_t public_key, private_key;
+    ASSERT_EQ(mesh_crypto_ed25519_keypair_generate(public_key, private_key), MESH_CRYPTO_SUCCESS);
+
+    mesh::crypto::BatchSigner signer(private_key, std::chrono::milliseconds(5), 16);
+    std::vector<std::string> votes;
+    for (int i = 0; i < 5; ++i) {
+        votes.push_back("vote-" + std::to_string(i));
+        signer.add(reinterpret_cast<const uint8_t*>(votes.back().data()), votes.back().size());
+    }
+
+    std::vector<mesh::crypto::BatchProof> proofs;
+    ASSERT_TRUE(signer.flush(proofs));
+    ASSERT_EQ(proofs.size(), votes.size());
+    EXPECT_EQ(signer.pending(), 0u);
+
+    // Only the first message of the batch costs a signature check
+    mesh::crypto::BatchVerifier verifier(public_key);
+    for (size_t i = 0; i < votes.size(); ++i) {
+        std::vector<uint8_t> wire = proofs[i].encode();
+        mesh::crypto::BatchProof decoded;
+        ASSERT_TRUE(mesh::crypto::BatchProof::decode(wire.data(), wire.size(), decoded));
+        EXPECT_TRUE(verifier.verify(reinterpret_cast<const uint8_t*>(votes[i].data()),
+                                    votes[i].size(), decoded));
+    }
+    EXPECT_EQ(verifier.getStats().signature_checks, 1u);
+    EXPECT_EQ(verifier.getStats().cache_hits, votes.size() - 1);
+
+    // Message swapped under another message's proof
+    EXPECT_FALSE(verifier.verify(reinterpret_cast<const uint8_t*>(votes[0].data()),
+                                 votes[0].size(), proofs[1]));
+
+    // Wrong signer key
+    mesh_key_t other_public, other_private;
+    ASSERT_EQ(mesh_crypto_ed25519_keypair_generate(other_public, other_private), MESH_CRYPTO_SUCCESS);
+    mesh::crypto::BatchVerifier other(other_public);
+    EXPECT_FALSE(other.verify(reinterpret_cast<const uint8_t*>(votes[0].data()),
+                              votes[0].size(), proofs[0]));
+
+    // A full batch refuses further leaves until it is flushed
+    using AddResult = mesh::crypto::BatchSigner::AddResult;
+    mesh::crypto::BatchSigner small(private_key, std::chrono::milliseconds(5), 2);
+    const uint8_t vote = 'v';
+    EXPECT_EQ(small.add(&vote, 1), AddResult::Queued);
+    EXPECT_EQ(small.add(&vote, 1), AddResult::Full);
+    EXPECT_EQ(small.add(&vote, 1), AddResult::Rejected);
+    EXPECT_EQ(small.pending(), 2u);
+    ASSERT_TRUE(small.flush(proofs));
+    EXPECT_EQ(proofs.size(), 2u);
+    EXPECT_EQ(small.add(&vote, 1), AddResult::Queued);
+}